@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <fstream>
+
+#include "async_file_reader.hpp"
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+#ifdef _WIN32
+	constexpr ULONG_PTR WAKE_KEY = 1;
+	// ReadFile takes a DWORD size, large files are read in several steps
+	constexpr std::uint64_t READ_CHUNK_SIZE = 16 * 1024 * 1024;
+#endif
+}
+
+namespace SAV
+{
+	struct AsyncFileReader::Request
+	{
+#ifdef _WIN32
+		OVERLAPPED overlapped = {};
+		HANDLE file = INVALID_HANDLE_VALUE;
+		std::uint64_t offset = 0;
+#endif
+		std::filesystem::path path;
+		Buffer data;
+		std::promise<std::optional<Buffer>> promise;
+	};
+
+	AsyncFileReader::PendingRead AsyncFileReader::read(const std::filesystem::path& file)
+	{
+		return read(std::vector<std::filesystem::path>{ file }).front();
+	}
+
+	std::vector<AsyncFileReader::PendingRead> AsyncFileReader::read(const std::vector<std::filesystem::path>& files)
+	{
+		std::vector<PendingRead> reads;
+		reads.reserve(files.size());
+		{
+			std::lock_guard guard(m_mutex);
+			for (const auto& file : files)
+			{
+				auto request = std::make_unique<Request>();
+				request->path = file;
+				reads.push_back(request->promise.get_future().share());
+				if (m_isStopping)
+				{
+					request->promise.set_value(std::nullopt);
+					continue;
+				}
+				m_queue.push_back(std::move(request));
+			}
+		}
+		wake();
+		return reads;
+	}
+
+	AsyncFileReader::Statistics AsyncFileReader::statistics() const
+	{
+		Statistics statistics;
+		statistics.files = m_files;
+		statistics.bytes = m_bytes;
+		statistics.busyTime = std::chrono::duration_cast<std::chrono::duration<double>>(Clock::duration{ m_busyTime.load() });
+		return statistics;
+	}
+
+	void AsyncFileReader::complete(Request& request, bool isRead)
+	{
+		if (!isRead)
+		{
+			request.promise.set_value(std::nullopt);
+			return;
+		}
+
+		++m_files;
+		m_bytes += request.data.size();
+		request.promise.set_value(std::move(request.data));
+	}
+
+#ifdef _WIN32
+	AsyncFileReader::AsyncFileReader(std::size_t readsInFlight) :
+		m_readsInFlight{ (std::max)(readsInFlight, std::size_t{ 1 }) }
+	{
+		m_port = ::CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+		if (!m_port)
+		{
+			throw std::exception("Can't create an I/O completion port");
+		}
+		m_threads.emplace_back(&AsyncFileReader::run, this);
+	}
+
+	AsyncFileReader::~AsyncFileReader()
+	{
+		{
+			std::lock_guard guard(m_mutex);
+			m_isStopping = true;
+			for (auto& request : m_queue)
+			{
+				request->promise.set_value(std::nullopt);
+			}
+			m_queue.clear();
+		}
+		wake();
+
+		m_threads.front().join();
+		::CloseHandle(m_port);
+	}
+
+	void AsyncFileReader::wake()
+	{
+		::PostQueuedCompletionStatus(m_port, 0, WAKE_KEY, nullptr);
+	}
+
+	void AsyncFileReader::run()
+	{
+		// returns false if the request is already finished
+		auto issue = [](Request& request) -> bool
+		{
+			auto toRead = (std::min)(READ_CHUNK_SIZE, request.data.size() - request.offset);
+			request.overlapped = {};
+			request.overlapped.Offset = static_cast<DWORD>(request.offset);
+			request.overlapped.OffsetHigh = static_cast<DWORD>(request.offset >> 32);
+			return ::ReadFile(request.file, request.data.data() + request.offset, static_cast<DWORD>(toRead), nullptr, &request.overlapped) ||
+				::GetLastError() == ERROR_IO_PENDING;
+		};
+
+		auto finish = [this](Request* request, bool isRead)
+		{
+			::CloseHandle(request->file);
+			complete(*request, isRead);
+			delete request;
+
+			if (--m_inFlight == 0)
+			{
+				m_busyTime += (Clock::now() - m_busySince).count();
+			}
+		};
+
+		while (true)
+		{
+			// start queued reads while there is room
+			while (m_inFlight < m_readsInFlight)
+			{
+				RequestPtr request;
+				{
+					std::lock_guard guard(m_mutex);
+					if (m_queue.empty())
+					{
+						break;
+					}
+					request = std::move(m_queue.front());
+					m_queue.pop_front();
+				}
+
+				request->file = ::CreateFileW(request->path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+					FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+				LARGE_INTEGER size;
+				if (request->file == INVALID_HANDLE_VALUE || !::GetFileSizeEx(request->file, &size) ||
+					!::CreateIoCompletionPort(request->file, m_port, 0, 0))
+				{
+					if (request->file != INVALID_HANDLE_VALUE)
+					{
+						::CloseHandle(request->file);
+					}
+					complete(*request, false);
+					continue;
+				}
+
+				request->data.resize(static_cast<std::size_t>(size.QuadPart));
+				if (m_inFlight++ == 0)
+				{
+					m_busySince = Clock::now();
+				}
+
+				if (request->data.empty())
+				{
+					finish(request.release(), true);
+				}
+				else if (auto* pending = request.release(); !issue(*pending))
+				{
+					finish(pending, false);
+				}
+			}
+
+			{
+				std::lock_guard guard(m_mutex);
+				if (m_isStopping && m_inFlight == 0)
+				{
+					break;
+				}
+			}
+
+			DWORD bytes = 0;
+			ULONG_PTR key = 0;
+			OVERLAPPED* overlapped = nullptr;
+			BOOL isCompleted = ::GetQueuedCompletionStatus(m_port, &bytes, &key, &overlapped, INFINITE);
+			if (overlapped == nullptr)
+			{
+				// woken up for new requests or the shutdown
+				continue;
+			}
+
+			auto* request = CONTAINING_RECORD(overlapped, Request, overlapped);
+			if (!isCompleted || bytes == 0)
+			{
+				finish(request, false);
+				continue;
+			}
+
+			request->offset += bytes;
+			if (request->offset == request->data.size())
+			{
+				finish(request, true);
+			}
+			else if (!issue(*request))
+			{
+				finish(request, false);
+			}
+		}
+	}
+#else
+	AsyncFileReader::AsyncFileReader(std::size_t readsInFlight) :
+		m_readsInFlight{ (std::max)(readsInFlight, std::size_t{ 1 }) }
+	{
+		for (std::size_t index = 0; index < m_readsInFlight; ++index)
+		{
+			m_threads.emplace_back(&AsyncFileReader::run, this);
+		}
+	}
+
+	AsyncFileReader::~AsyncFileReader()
+	{
+		{
+			std::lock_guard guard(m_mutex);
+			m_isStopping = true;
+			for (auto& request : m_queue)
+			{
+				request->promise.set_value(std::nullopt);
+			}
+			m_queue.clear();
+		}
+		wake();
+
+		for (auto& thread : m_threads)
+		{
+			thread.join();
+		}
+	}
+
+	void AsyncFileReader::wake()
+	{
+		m_condition.notify_all();
+	}
+
+	void AsyncFileReader::run()
+	{
+		while (true)
+		{
+			RequestPtr request;
+			{
+				std::unique_lock lock(m_mutex);
+				m_condition.wait(lock, [this]() { return m_isStopping || !m_queue.empty(); });
+				if (m_queue.empty())
+				{
+					return;
+				}
+				request = std::move(m_queue.front());
+				m_queue.pop_front();
+				if (m_inFlight++ == 0)
+				{
+					m_busySince = Clock::now();
+				}
+			}
+
+			std::ifstream input(request->path, std::ios_base::binary | std::ios_base::ate);
+			bool isRead = static_cast<bool>(input);
+			if (isRead)
+			{
+				request->data.resize(static_cast<std::size_t>(input.tellg()));
+				input.seekg(0);
+				isRead = static_cast<bool>(input.read(reinterpret_cast<char*>(request->data.data()), static_cast<std::streamsize>(request->data.size())));
+			}
+			complete(*request, isRead);
+
+			std::lock_guard guard(m_mutex);
+			if (--m_inFlight == 0)
+			{
+				m_busyTime += (Clock::now() - m_busySince).count();
+			}
+		}
+	}
+#endif
+}
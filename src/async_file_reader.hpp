@@ -0,0 +1,86 @@
+#pragma once
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace SAV
+{
+	// Reads whole files into memory in the background with a bounded number of reads in flight.
+	// On Windows the reads are overlapped and completed through an I/O completion port,
+	// elsewhere a small pool of threads reads them.
+	class AsyncFileReader
+	{
+	public:
+		using Buffer = std::vector<std::byte>;
+		// nullopt if the file can't be read
+		using PendingRead = std::shared_future<std::optional<Buffer>>;
+
+		inline static constexpr std::size_t defaultReadsInFlight = 8;
+
+		struct Statistics
+		{
+			std::uint64_t files = 0;
+			std::uint64_t bytes = 0;
+			// time with at least one read in flight
+			std::chrono::duration<double> busyTime{ 0 };
+
+			double bytesPerSecond() const { return busyTime.count() > 0.0 ? bytes / busyTime.count() : 0.0; }
+		};
+
+	public:
+		explicit AsyncFileReader(std::size_t readsInFlight = defaultReadsInFlight);
+		// Waits for the reads in flight, the queued ones are abandoned
+		~AsyncFileReader();
+
+		AsyncFileReader(const AsyncFileReader&) = delete;
+		AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+		PendingRead read(const std::filesystem::path& file);
+		// The whole batch is queued at once
+		std::vector<PendingRead> read(const std::vector<std::filesystem::path>& files);
+
+		Statistics statistics() const;
+
+	private:
+		struct Request;
+		using RequestPtr = std::unique_ptr<Request>;
+
+		void run();
+		void wake();
+		void complete(Request& request, bool isRead);
+
+	private:
+		std::size_t m_readsInFlight;
+
+		mutable std::mutex m_mutex;
+		std::deque<RequestPtr> m_queue;
+		bool m_isStopping = false;
+
+		std::atomic<std::uint64_t> m_files = 0;
+		std::atomic<std::uint64_t> m_bytes = 0;
+		std::atomic<std::int64_t> m_busyTime = 0; // steady clock ticks
+		std::size_t m_inFlight = 0;
+		std::chrono::steady_clock::time_point m_busySince;
+
+#ifdef _WIN32
+		HANDLE m_port = nullptr;
+#else
+		std::condition_variable m_condition;
+#endif
+		std::vector<std::thread> m_threads;
+	};
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+namespace SAV
+{
+	// Read side of a cancellation flag. It is cheap to copy and safe to poll from any thread.
+	// A default constructed token is never canceled.
+	class CancellationToken
+	{
+	public:
+		CancellationToken() = default;
+
+		bool isCanceled() const
+		{
+			return m_state && m_state->load(std::memory_order_acquire);
+		}
+
+	private:
+		friend class CancellationSource;
+
+		explicit CancellationToken(std::shared_ptr<const std::atomic<bool>> state) :
+			m_state{ std::move(state) }
+		{}
+
+	private:
+		std::shared_ptr<const std::atomic<bool>> m_state;
+	};
+
+	// Owned by whoever may request the cancellation, usually the UI thread
+	class CancellationSource
+	{
+	public:
+		CancellationSource() :
+			m_state{ std::make_shared<std::atomic<bool>>(false) }
+		{}
+
+		void cancel() { m_state->store(true, std::memory_order_release); }
+		bool isCanceled() const { return m_state->load(std::memory_order_acquire); }
+
+		CancellationToken token() const { return CancellationToken{ m_state }; }
+
+	private:
+		std::shared_ptr<std::atomic<bool>> m_state;
+	};
+}
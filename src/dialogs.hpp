@@ -13,6 +13,7 @@ namespace SAV
 	};
 
 	inline constexpr SaveFileData program_save_data = { {L"Simple Animation Viwer data (*.sav)", L"*.sav"}, L"sav" };
+	inline constexpr SaveFileData program_export_text_data = { {L"Simple Animation Viewer text data (*.sav)", L"*.sav"}, L"sav" };
 	inline constexpr SaveFileData program_save_video = { {L"mp4 video file (*.mp4)", L"*.mp4"}, L"mp4" };
 
 	//inline constexpr std::array<COMDLG_FILTERSPEC, 1> program_data_filter = { {L"Simple Animation Viwer data (*.sav)", L"*.sav"} };
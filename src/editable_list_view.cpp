@@ -4,6 +4,7 @@
 #include <gdiplus.h>
 #include <gdiplusheaders.h>
 
+#include <algorithm>
 #include <array>
 #include <exception>
 #include <sstream>
@@ -56,17 +57,10 @@ namespace
 				case VK_RETURN:
 				{
 					std::array<wchar_t, 256> szText = { 0 };
-					LVITEM lvItem;
-					lvItem.iItem = PtrToInt(GetProp(hwnd, L"ITEM"));
-					lvItem.iSubItem = 1;
-
 					GetWindowText(hwnd, szText.data(), static_cast<int>(szText.size()));
-					lvItem.pszText = szText.data();
 
-					if (auto parentWindow = ::GetAncestor(hwnd, GA_PARENT); parentWindow != nullptr)
-					{
-						SendMessage(parentWindow, LVM_SETITEMTEXT, (WPARAM)lvItem.iItem, (LPARAM)&lvItem);
-					}
+					auto* editableListView = (SAV::EditableListView*)dwRefData;
+					editableListView->setItemText(PtrToInt(GetProp(hwnd, L"ITEM")), 1, szText.data());
 					DestroyWindow(hwnd);
 				}
 				return 0;
@@ -99,18 +93,22 @@ namespace
 
 }
 
-SAV::EditableListView::EditableListView(HWND parent, const RECT& position) :
+SAV::EditableListView::EditableListView(HWND parent, const RECT& position, ListViewModel* model) :
 	m_handle(nullptr),
 	m_height(position.bottom - position.top),
 	m_width(position.right - position.left),
 	m_widthPercent(static_cast<float>(m_width) / 100.0f),
+	m_columnCount(0),
+	m_model(model),
+	m_imageSize(0),
 	m_onSelectHandler(nullptr),
+	m_onEditHandler(nullptr),
 	m_dragAndDropContext{ std::nullopt }
 {
 	m_handle = ::CreateWindow(
 		WC_LISTVIEW,
 		L"",
-		WS_CHILD | LVS_REPORT | WS_VISIBLE | LVS_SINGLESEL,
+		WS_CHILD | LVS_REPORT | WS_VISIBLE | (m_model ? LVS_OWNERDATA : LVS_SINGLESEL),
 		position.left, position.top,
 		m_width, m_height,
 		parent,
@@ -123,7 +121,8 @@ SAV::EditableListView::EditableListView(HWND parent, const RECT& position) :
 		throw std::exception("Can't create list view");
 	}
 
-	ListView_SetExtendedListViewStyle(m_handle, LVS_EX_FULLROWSELECT | LVS_EX_AUTOSIZECOLUMNS);
+	// painted into a back buffer, the rows and the drag image don't flicker
+	ListView_SetExtendedListViewStyle(m_handle, LVS_EX_FULLROWSELECT | LVS_EX_AUTOSIZECOLUMNS | LVS_EX_DOUBLEBUFFER);
 
 	SetWindowSubclass(m_handle, listViewSubclassProc, 1, (DWORD_PTR)this);
 }
@@ -145,9 +144,10 @@ void SAV::EditableListView::addHeader(const HeaderDescription& description, int
 	{
 		throw std::exception("Can't initialize header");
 	}
+	++m_columnCount;
 }
 
-void SAV::EditableListView::showInplaceEditControl(int itemIndex, int subItemIndex)
+void SAV::EditableListView::showInplaceEditControl(int itemIndex, int subItemIndex, const std::optional<std::wstring>& text)
 {
 	::RECT timerSubItemRect;
 	ListView_GetSubItemRect(m_handle, itemIndex, subItemIndex, LVIR_LABEL, &timerSubItemRect);
@@ -156,11 +156,18 @@ void SAV::EditableListView::showInplaceEditControl(int itemIndex, int subItemInd
 		timerSubItemRect.right - timerSubItemRect.left, timerSubItemRect.bottom - timerSubItemRect.top,
 		m_handle, NULL, GetModuleHandle(0), 0);
 
-	std::array<wchar_t, 256> text = { 0 };
-	ListView_GetItemText(m_handle, itemIndex, subItemIndex, text.data(), static_cast<int>(text.size()));
+	std::array<wchar_t, 256> itemText = { 0 };
+	if (text)
+	{
+		wcsncpy_s(itemText.data(), itemText.size(), text->c_str(), _TRUNCATE);
+	}
+	else
+	{
+		ListView_GetItemText(m_handle, itemIndex, subItemIndex, itemText.data(), static_cast<int>(itemText.size()));
+	}
 
 	SendMessage(inPlaceEditControl, EM_LIMITTEXT, 8, 0);
-	SendMessage(inPlaceEditControl, WM_SETTEXT, 0, (LPARAM)text.data());
+	SendMessage(inPlaceEditControl, WM_SETTEXT, 0, (LPARAM)itemText.data());
 	SendMessage(inPlaceEditControl, EM_SETSEL, 0, 8);
 	SetFocus(inPlaceEditControl);
 
@@ -168,12 +175,64 @@ void SAV::EditableListView::showInplaceEditControl(int itemIndex, int subItemInd
 	SetProp(inPlaceEditControl, L"ITEM", (HANDLE)itemIndex);
 }
 
-void SAV::EditableListView::updateData(const std::vector<std::vector<std::wstring>>& data)
+void SAV::EditableListView::updateData(const std::vector<std::vector<std::wstring>>& data, const std::vector<LPARAM>& params)
 {
 	for(int rowIndex = 0; rowIndex < data.size(); ++rowIndex)
 	{
-		insertItem(data[rowIndex], rowIndex);
+		insertItem(data[rowIndex], rowIndex, rowIndex < params.size() ? params[rowIndex] : 0);
+	}
+}
+
+void SAV::EditableListView::appendData(const std::vector<std::vector<std::wstring>>& data, const std::vector<LPARAM>& params)
+{
+	::SendMessage(m_handle, WM_SETREDRAW, FALSE, 0);
+	auto firstIndex = ListView_GetItemCount(m_handle);
+	for (int rowIndex = 0; rowIndex < data.size(); ++rowIndex)
+	{
+		auto param = rowIndex < params.size() ? params[rowIndex] : 0;
+		insertItem(data[rowIndex], firstIndex + rowIndex, param);
+		notifyEdit(ListViewEdit{ ListViewEdit::Type::Insert, firstIndex + rowIndex, -1, data[rowIndex], param });
+	}
+	::SendMessage(m_handle, WM_SETREDRAW, TRUE, 0);
+	::InvalidateRect(m_handle, nullptr, FALSE);
+}
+
+void SAV::EditableListView::refresh()
+{
+	ListView_SetItemCountEx(m_handle, m_model->rowCount(), LVSICF_NOSCROLL | LVSICF_NOINVALIDATEALL);
+	::InvalidateRect(m_handle, nullptr, FALSE);
+}
+
+void SAV::EditableListView::redrawRows(int first, int last)
+{
+	ListView_RedrawItems(m_handle, first, last);
+}
+
+void SAV::EditableListView::selectRow(int row)
+{
+	ListView_SetItemState(m_handle, -1, 0, LVIS_SELECTED | LVIS_FOCUSED);
+	ListView_SetItemState(m_handle, row, LVIS_SELECTED | LVIS_FOCUSED, LVIS_SELECTED | LVIS_FOCUSED);
+	ListView_EnsureVisible(m_handle, row, FALSE);
+}
+
+void SAV::EditableListView::showImages(int size)
+{
+	m_imageSize = size;
+
+	// the rows take the height of the small image list, its blank image keeps the room the row images are drawn into
+	HIMAGELIST imageList = nullptr;
+	if (size > 0)
+	{
+		imageList = ImageList_Create(size, size, ILC_COLOR32, 1, 0);
+		ImageList_SetImageCount(imageList, 1);
+	}
+
+	// the list destroys the image list it holds when it goes away, the replaced one is ours
+	if (auto previous = ListView_SetImageList(m_handle, imageList, LVSIL_SMALL); previous)
+	{
+		ImageList_Destroy(previous);
 	}
+	::InvalidateRect(m_handle, nullptr, TRUE);
 }
 
 std::tuple<bool, int> SAV::EditableListView::processNotify(WPARAM wp, LPARAM lp)
@@ -213,6 +272,22 @@ std::tuple<bool, int> SAV::EditableListView::processNotify(WPARAM wp, LPARAM lp)
 			returnedCode = processCustomDraw(listViewCustomDraw);
 			return { true, returnedCode };
 		}
+
+		case LVN_GETDISPINFO:
+		{
+			// only the painted cells are asked for, the text is formatted on demand
+			auto* dispInfo = reinterpret_cast<NMLVDISPINFO*>(lp);
+			if (m_model && (dispInfo->item.mask & LVIF_TEXT) && dispInfo->item.iItem < m_model->rowCount())
+			{
+				auto text = m_model->text(dispInfo->item.iItem, dispInfo->item.iSubItem);
+				wcsncpy_s(dispInfo->item.pszText, dispInfo->item.cchTextMax, text.c_str(), _TRUNCATE);
+			}
+			if (m_imageSize > 0 && (dispInfo->item.mask & LVIF_IMAGE))
+			{
+				dispInfo->item.iImage = 0;
+			}
+			return { true, returnedCode };
+		}
 	}
 
 	return {false, returnedCode};
@@ -222,7 +297,14 @@ std::vector<std::wstring> SAV::EditableListView::getRowData(int index) const
 {
 	std::vector<std::wstring> data;
 
-	if (index >= 0)
+	if (m_model && index >= 0 && index < m_model->rowCount())
+	{
+		for (int column = 0; column < m_columnCount; ++column)
+		{
+			data.push_back(m_model->text(index, column));
+		}
+	}
+	else if (!m_model && index >= 0)
 	{
 		std::array<wchar_t, 256> buffer = { 0 };
 		int subItemIndex = 0;
@@ -241,10 +323,27 @@ std::vector<std::wstring> SAV::EditableListView::getRowData(int index) const
 	return data;
 }
 
-void SAV::EditableListView::insertItem(const std::vector<std::wstring>& itemData, int index)
+LPARAM SAV::EditableListView::getRowParam(int index) const
+{
+	if (m_model)
+	{
+		return index >= 0 && index < m_model->rowCount() ? m_model->param(index) : 0;
+	}
+
+	LVITEM item;
+	item.mask = LVIF_PARAM;
+	item.iItem = index;
+	item.iSubItem = 0;
+	item.lParam = 0;
+	ListView_GetItem(m_handle, &item);
+	return item.lParam;
+}
+
+void SAV::EditableListView::insertItem(const std::vector<std::wstring>& itemData, int index, LPARAM param)
 {
 	LVITEM lvI;
-	lvI.mask = LVIF_TEXT | LVIF_STATE;
+	lvI.mask = LVIF_TEXT | LVIF_STATE | LVIF_PARAM;
+	lvI.lParam = param;
 	lvI.stateMask = 0;
 	lvI.state = 0;
 	lvI.cchTextMax = 256;
@@ -256,7 +355,8 @@ void SAV::EditableListView::insertItem(const std::vector<std::wstring>& itemData
 	lvI.iItem = index;
 	lvI.iSubItem = 0;
 	lvI.pszText = buffer.data();
-	ListView_InsertItem(m_handle, &lvI);
+	lvI.iItem = ListView_InsertItem(m_handle, &lvI);
+	lvI.mask = LVIF_TEXT;
 	for (int columnIndex = 1; columnIndex < itemData.size(); ++columnIndex)
 	{
 		std::copy(itemData[columnIndex].begin(), itemData[columnIndex].end(), buffer.begin());
@@ -278,12 +378,17 @@ SAV::EditableListView::DragAndDrop SAV::EditableListView::createDragAndDropConte
 	auto hdc = ::GetDC(m_handle);
 	auto hdcMem = ::CreateCompatibleDC(hdc);
 	auto bitmap = ::CreateCompatibleBitmap(hdc, width, height);
+	::ReleaseDC(m_handle, hdc);
 	auto oldBitmap = SelectObject(hdcMem, bitmap);
 
 	RECT r{ 0, 0, width, height };
 	::FillRect(hdcMem, &r, static_cast<HBRUSH>(GetStockObject(DKGRAY_BRUSH)));
 
 	auto data = getRowData(index);
+	if (auto rowCount = getSelectedRows().size(); rowCount > 1)
+	{
+		data[0] += L" (+" + std::to_wstring(rowCount - 1) + L")";
+	}
 	COLORREF rgbWhite = 0x00FFFFFF;
 	COLORREF oldColor = ::SetTextColor(hdcMem, rgbWhite);
 	int oldBkMode = ::SetBkMode(hdcMem, TRANSPARENT);
@@ -322,6 +427,11 @@ int SAV::EditableListView::processContextMenu(LPARAM lParam)
 		EnableMenuItem(menuTrackPopup, ID_COPY_ITEM, MF_GRAYED);
 		EnableMenuItem(menuTrackPopup, ID_SETTOALL, MF_GRAYED);
 	}
+	if (index < 0 || !m_model)
+	{
+		EnableMenuItem(menuTrackPopup, ID_REVERSE_ITEMS, MF_GRAYED);
+		EnableMenuItem(menuTrackPopup, ID_SCALE_ITEMS, MF_GRAYED);
+	}
 
 	int id = TrackPopupMenuEx(menuTrackPopup, TPM_RIGHTBUTTON | TPM_RETURNCMD, p.x, p.y, m_handle, nullptr);
 	switch (id)
@@ -337,6 +447,15 @@ int SAV::EditableListView::processContextMenu(LPARAM lParam)
 		case ID_SETTOALL:
 			setValueToAllItem(index);
 			break;
+
+		case ID_REVERSE_ITEMS:
+			reverseItems();
+			break;
+
+		case ID_SCALE_ITEMS:
+			// the factor is typed like a duration and applies to every selected row
+			showInplaceEditControl(index, 1, L"x1");
+			break;
 	}
 
 	DestroyMenu(contextMenu);
@@ -349,7 +468,7 @@ void SAV::EditableListView::processSelectionChanged()
 	{
 		int index = ListView_GetNextItem(m_handle, -1, LVNI_SELECTED);
 		auto data = getRowData(index);
-		m_onSelectHandler.operator()(data);
+		m_onSelectHandler.operator()(data, index >= 0 ? getRowParam(index) : 0, index);
 	}
 }
 
@@ -390,12 +509,17 @@ bool SAV::EditableListView::processMouseMoving(LPARAM lParam)
 	lvhti.pt.y = p.y;
 	ScreenToClient(m_handle, &lvhti.pt);
 	ListView_HitTest(m_handle, &lvhti);
+
+	// only the image at its old and new place and the rows losing and getting the mark are painted
+	invalidateDragImage();
 	m_dragAndDropContext->mouse = lvhti.pt;
+	invalidateDragImage();
 
-	if (lvhti.iItem != -1)
+	if (lvhti.iItem != -1 && lvhti.iItem != m_dragAndDropContext->hotItemIndex)
 	{
+		invalidateRow(m_dragAndDropContext->hotItemIndex);
 		m_dragAndDropContext->hotItemIndex = lvhti.iItem;
-		InvalidateRect(m_handle, nullptr, false);
+		invalidateRow(m_dragAndDropContext->hotItemIndex);
 	}
 
 	return true;
@@ -408,6 +532,8 @@ void SAV::EditableListView::processEndDragAndDrop(LPARAM lParam)
 		return;
 	}
 
+	invalidateDragImage();
+	invalidateRow(m_dragAndDropContext->hotItemIndex);
 	m_dragAndDropContext.reset();
 
 	ReleaseCapture();
@@ -429,33 +555,96 @@ void SAV::EditableListView::processEndDragAndDrop(LPARAM lParam)
 
 	int index = ListView_GetNextItem(m_handle, -1, LVNI_SELECTED);
 
-	if (index != -1 && index == lvhti.iItem)
+	// a drop onto any of the dragged rows leaves them in place
+	if (index != -1 && (ListView_GetItemState(m_handle, lvhti.iItem, LVIS_SELECTED) & LVIS_SELECTED) != 0)
 	{
 		return;
 	}
 
+	if (m_model)
+	{
+		// the model repaints the rows which changed their places
+		auto rows = getSelectedRows();
+		ListView_SetItemState(m_handle, -1, 0, LVIS_SELECTED | LVIS_FOCUSED);
+		auto first = m_model->move(rows, lvhti.iItem);
+		for (int row = first; row < first + static_cast<int>(rows.size()); ++row)
+		{
+			ListView_SetItemState(m_handle, row, LVIS_SELECTED, LVIS_SELECTED);
+		}
+		ListView_SetItemState(m_handle, first, LVIS_FOCUSED, LVIS_FOCUSED);
+		return;
+	}
+
 	auto draggedData = getRowData(index);
-	removeItem(index);
-	insertItem(draggedData, lvhti.iItem);
+	auto draggedParam = getRowParam(index);
+	::SendMessage(m_handle, LVM_DELETEITEM, static_cast<WPARAM>(index), 0);
+	insertItem(draggedData, lvhti.iItem, draggedParam);
+	notifyEdit(ListViewEdit{ ListViewEdit::Type::Move, index, lvhti.iItem, {}, 0 });
 
 	InvalidateRect(m_handle, nullptr, false);
 }
 
+void SAV::EditableListView::invalidateRow(int index)
+{
+	::RECT rowRect;
+	if (index >= 0 && ListView_GetItemRect(m_handle, index, &rowRect, LVIR_BOUNDS))
+	{
+		::InvalidateRect(m_handle, &rowRect, FALSE);
+	}
+}
+
+void SAV::EditableListView::invalidateDragImage()
+{
+	const auto& context = *m_dragAndDropContext;
+	::RECT imageRect{ context.mouse.x, context.mouse.y, context.mouse.x + context.imageWidth, context.mouse.y + context.imageHeight };
+	::InvalidateRect(m_handle, &imageRect, FALSE);
+}
+
 void SAV::EditableListView::removeItem(const std::optional<int>& itemIndex)
 {
+	if (m_model)
+	{
+		if (auto rows = getEditedRows(itemIndex); !rows.empty())
+		{
+			editWithoutRedraw([this, &rows]()
+				{
+					ListView_SetItemState(m_handle, -1, 0, LVIS_SELECTED);
+					m_model->remove(rows);
+				});
+		}
+		return;
+	}
+
 	int index = itemIndex.has_value() ? *itemIndex : ListView_GetNextItem(m_handle, -1, LVNI_SELECTED);
 	if (index != -1)
 	{
 		::SendMessage(m_handle, LVM_DELETEITEM, static_cast<WPARAM>(index), 0);
+		notifyEdit(ListViewEdit{ ListViewEdit::Type::Remove, index, -1, {}, 0 });
 	}
 }
 
 void SAV::EditableListView::copyItem(const std::optional<int>& itemIndex )
 {
+	if (m_model)
+	{
+		if (auto rows = getEditedRows(itemIndex); !rows.empty())
+		{
+			editWithoutRedraw([this, &rows]()
+				{
+					ListView_SetItemState(m_handle, -1, 0, LVIS_SELECTED);
+					m_model->duplicate(rows);
+				});
+		}
+		return;
+	}
+
 	int index = itemIndex.has_value() ? *itemIndex : ListView_GetNextItem(m_handle, -1, LVNI_SELECTED);
 	if (index >= 0)
 	{
-		insertItem(getRowData(index), index);
+		auto data = getRowData(index);
+		auto param = getRowParam(index);
+		insertItem(data, index, param);
+		notifyEdit(ListViewEdit{ ListViewEdit::Type::Insert, index, -1, std::move(data), param });
 	}
 }
 
@@ -467,6 +656,21 @@ void SAV::EditableListView::setValueToAllItem(const std::optional<int>& itemInde
 		auto data = getRowData(index);
 		auto& value = data[1];
 		auto itemCount = ListView_GetItemCount(m_handle);
+		if (m_model)
+		{
+			std::vector<int> rows;
+			rows.reserve(itemCount);
+			for (int i = 0; i < itemCount; ++i)
+			{
+				if (i != index)
+				{
+					rows.push_back(i);
+				}
+			}
+			editWithoutRedraw([this, &rows, &value]() { m_model->setText(rows, 1, value); });
+			return;
+		}
+
 		for (int i = 0; i < itemCount; ++i)
 		{
 			if (i != index)
@@ -476,11 +680,79 @@ void SAV::EditableListView::setValueToAllItem(const std::optional<int>& itemInde
 				lvItem.iSubItem = 1;
 				lvItem.pszText = value.data();
 				SendMessage(m_handle, LVM_SETITEMTEXT, (WPARAM)lvItem.iItem, (LPARAM)&lvItem);
+				notifyEdit(ListViewEdit{ ListViewEdit::Type::SetText, i, -1, getRowData(i), 0 });
 			}
 		}
 	}
 }
 
+void SAV::EditableListView::setItemText(int index, int subItemIndex, const std::wstring& text)
+{
+	if (m_model)
+	{
+		auto rows = getEditedRows(index);
+		editWithoutRedraw([this, &rows, subItemIndex, &text]() { m_model->setText(rows, subItemIndex, text); });
+		return;
+	}
+
+	std::wstring buffer{ text };
+	LVITEM lvItem;
+	lvItem.iItem = index;
+	lvItem.iSubItem = subItemIndex;
+	lvItem.pszText = buffer.data();
+	SendMessage(m_handle, LVM_SETITEMTEXT, (WPARAM)lvItem.iItem, (LPARAM)&lvItem);
+	notifyEdit(ListViewEdit{ ListViewEdit::Type::SetText, index, -1, getRowData(index), 0 });
+}
+
+void SAV::EditableListView::reverseItems()
+{
+	if (!m_model)
+	{
+		return;
+	}
+
+	if (auto rows = getSelectedRows(); rows.size() > 1)
+	{
+		editWithoutRedraw([this, &rows]() { m_model->reverse(rows); });
+	}
+}
+
+std::vector<int> SAV::EditableListView::getSelectedRows() const
+{
+	std::vector<int> rows;
+	for (int index = ListView_GetNextItem(m_handle, -1, LVNI_SELECTED); index != -1; index = ListView_GetNextItem(m_handle, index, LVNI_SELECTED))
+	{
+		rows.push_back(index);
+	}
+	return rows;
+}
+
+std::vector<int> SAV::EditableListView::getEditedRows(const std::optional<int>& itemIndex) const
+{
+	auto rows = getSelectedRows();
+	if (!itemIndex || std::binary_search(rows.begin(), rows.end(), *itemIndex))
+	{
+		return rows;
+	}
+	return *itemIndex >= 0 ? std::vector<int>{ *itemIndex } : std::vector<int>{};
+}
+
+void SAV::EditableListView::editWithoutRedraw(const std::function<void()>& edit)
+{
+	::SendMessage(m_handle, WM_SETREDRAW, FALSE, 0);
+	edit();
+	::SendMessage(m_handle, WM_SETREDRAW, TRUE, 0);
+	::InvalidateRect(m_handle, nullptr, FALSE);
+}
+
+void SAV::EditableListView::notifyEdit(ListViewEdit&& edit)
+{
+	if (m_onEditHandler)
+	{
+		m_onEditHandler(edit);
+	}
+}
+
 std::vector<std::vector<std::wstring>> SAV::EditableListView::getListViewData() const
 {
 	std::vector<std::vector<std::wstring>> result;
@@ -493,12 +765,24 @@ std::vector<std::vector<std::wstring>> SAV::EditableListView::getListViewData()
 	return result;
 }
 
-void SAV::EditableListView::onResize(const ::RECT& position)
+std::vector<LPARAM> SAV::EditableListView::getListViewParams() const
+{
+	std::vector<LPARAM> result;
+	int totalItemsCount = ListView_GetItemCount(m_handle);
+	for (int index = 0; index < totalItemsCount; ++index)
+	{
+		result.push_back(getRowParam(index));
+	}
+
+	return result;
+}
+
+HDWP SAV::EditableListView::onResize(HDWP positions, const ::RECT& position)
 {
-	::SetWindowPos(m_handle, HWND_TOP, position.left, position.top,
+	return ::DeferWindowPos(positions, m_handle, HWND_TOP, position.left, position.top,
 		position.right - position.left,
 		position.bottom - position.top,
-		SWP_NOZORDER);
+		SWP_NOZORDER | SWP_NOACTIVATE);
 }
 
 int SAV::EditableListView::processCustomDraw(LPNMLVCUSTOMDRAW listViewCustomDraw)
@@ -506,36 +790,82 @@ int SAV::EditableListView::processCustomDraw(LPNMLVCUSTOMDRAW listViewCustomDraw
 	switch (listViewCustomDraw->nmcd.dwDrawStage)
 	{
 		case CDDS_PREPAINT:
-			return m_dragAndDropContext ? (CDRF_NOTIFYPOSTPAINT | CDRF_NOTIFYITEMDRAW) : CDRF_DODEFAULT;
+		{
+			int result = m_dragAndDropContext ? (CDRF_NOTIFYPOSTPAINT | CDRF_NOTIFYITEMDRAW) : CDRF_DODEFAULT;
+			if (m_imageSize > 0)
+			{
+				// only the visible rows need their images
+				auto first = ListView_GetTopIndex(m_handle);
+				m_model->prepareRows(first, (std::min)(first + ListView_GetCountPerPage(m_handle), m_model->rowCount() - 1));
+				result |= CDRF_NOTIFYITEMDRAW;
+			}
+			return result;
+		}
 
 		case CDDS_ITEMPREPAINT:
 			return processPrePaint(listViewCustomDraw);
 
+		case CDDS_ITEMPOSTPAINT:
+			return processItemPostPaint(listViewCustomDraw);
+
 		case CDDS_POSTPAINT:
-			return processPostPaint();
+			return processPostPaint(listViewCustomDraw);
 	}
+	return CDRF_DODEFAULT;
 }
 
 int SAV::EditableListView::processPrePaint(LPNMLVCUSTOMDRAW listViewCustomDraw)
 {
-	if (m_dragAndDropContext->hotItemIndex != -1 && listViewCustomDraw->nmcd.dwItemSpec == m_dragAndDropContext->hotItemIndex)
+	int result = m_imageSize > 0 ? CDRF_NOTIFYPOSTPAINT : CDRF_DODEFAULT;
+	if (m_dragAndDropContext && m_dragAndDropContext->hotItemIndex != -1 && listViewCustomDraw->nmcd.dwItemSpec == m_dragAndDropContext->hotItemIndex)
 	{
 		listViewCustomDraw->clrTextBk = RGB(255, 0, 0);
-		return CDRF_NEWFONT;
+		result |= CDRF_NEWFONT;
 	}
 
-	return CDRF_DODEFAULT;
+	return result;
 }
 
-int SAV::EditableListView::processPostPaint()
+int SAV::EditableListView::processPostPaint(LPNMLVCUSTOMDRAW listViewCustomDraw)
 {
 	if (m_dragAndDropContext)
 	{
+		// the paint DC, so the image goes into the same back buffer as the rows
 		ImageList_Draw(m_dragAndDropContext->getImageList(), 0,
-						GetDC(m_handle),
+						listViewCustomDraw->nmcd.hdc,
 						m_dragAndDropContext->mouse.x, m_dragAndDropContext->mouse.y,
 						ILD_BLEND);
 	}
 	
 	return CDRF_DODEFAULT;
-}
\ No newline at end of file
+}
+
+int SAV::EditableListView::processItemPostPaint(LPNMLVCUSTOMDRAW listViewCustomDraw)
+{
+	auto row = static_cast<int>(listViewCustomDraw->nmcd.dwItemSpec);
+	auto image = m_model->image(row);
+	if (!image)
+	{
+		return CDRF_DODEFAULT;
+	}
+
+	::RECT imageRect;
+	ListView_GetItemRect(m_handle, row, &imageRect, LVIR_ICON);
+
+	BITMAPINFO bitmapInfo = {};
+	bitmapInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	bitmapInfo.bmiHeader.biWidth = static_cast<LONG>(image->stride);
+	bitmapInfo.bmiHeader.biHeight = -static_cast<LONG>(image->height); // the rows go downwards
+	bitmapInfo.bmiHeader.biPlanes = 1;
+	bitmapInfo.bmiHeader.biBitCount = 32;
+	bitmapInfo.bmiHeader.biCompression = BI_RGB;
+
+	// centered in the room of the blank image
+	const auto width = static_cast<int>(image->width);
+	const auto height = static_cast<int>(image->height);
+	::StretchDIBits(listViewCustomDraw->nmcd.hdc,
+		imageRect.left + (imageRect.right - imageRect.left - width) / 2, imageRect.top + (imageRect.bottom - imageRect.top - height) / 2,
+		width, height, 0, 0, width, height, image->pixels, &bitmapInfo, DIB_RGB_COLORS, SRCCOPY);
+
+	return CDRF_DODEFAULT;
+}
@@ -16,14 +16,75 @@ namespace SAV
 		std::uint32_t headerWidthPercent;
 	};
 
+	// Reported after the user changed the rows
+	struct ListViewEdit
+	{
+		enum class Type
+		{
+			Insert,
+			Remove,
+			Move,
+			SetText
+		};
+
+		Type type;
+		int index;                      // the changed row, the row taken out by a move
+		int target;                     // Move: the row the item ends up at
+		std::vector<std::wstring> data; // Insert, SetText: the row texts after the edit
+		LPARAM param;                   // Insert: the value attached to the row
+	};
+
+	// Pixels of a row image, 32bpp ARGB rows stride pixels apart
+	struct ListViewImage
+	{
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint32_t stride;
+		const std::uint32_t* pixels;
+	};
+
+	// Rows of a list in owner data mode. The list keeps no rows of its own, it asks for the cells
+	// it paints and every edit made through the list is applied here. The owner tells the list
+	// about changed rows through refresh() and redrawRows().
+	class ListViewModel
+	{
+	public:
+		virtual ~ListViewModel() = default;
+
+		virtual int rowCount() const = 0;
+		virtual std::wstring text(int row, int column) const = 0;
+		virtual LPARAM param(int row) const = 0;
+		// While images are shown: the one of the row, nullopt if there is none yet
+		virtual std::optional<ListViewImage> image(int row) const { return std::nullopt; }
+		// While images are shown: rows [first, last] are about to be painted
+		virtual void prepareRows(int first, int last) {}
+
+		// Rows are ascending, every edit of them is one operation on the model
+		// The copies of neighbouring rows are inserted right after them
+		virtual void duplicate(const std::vector<int>& rows) = 0;
+		virtual void remove(const std::vector<int>& rows) = 0;
+		// The rows keep their places but come in the reverse order
+		virtual void reverse(const std::vector<int>& rows) = 0;
+		// false if the text isn't a valid value of the column
+		virtual bool setText(const std::vector<int>& rows, int column, const std::wstring& text) = 0;
+
+		// The rows are taken out and inserted as one block, right behind the row at target when any
+		// of them is above it and right in front of it otherwise. Returns the row the block starts at.
+		// The list doesn't call it when target is one of the rows.
+		virtual int move(const std::vector<int>& rows, int target) = 0;
+	};
+
 	class EditableListView
 	{
 	public:
 		using HandlerToken = std::uint32_t;
-		using OnSelectHandler = std::function<void(const std::vector<std::wstring>&)>;
+		// Gets the row texts, the value attached to the row and the row, -1 if none is selected
+		using OnSelectHandler = std::function<void(const std::vector<std::wstring>&, LPARAM, int)>;
+		using OnEditHandler = std::function<void(const ListViewEdit&)>;
 
 	public:
-		explicit EditableListView(HWND parent, const RECT& position);
+		// With a model the list runs in owner data mode, the model must outlive the list
+		explicit EditableListView(HWND parent, const RECT& position, ListViewModel* model = nullptr);
 
 		template<typename Container, typename T = typename Container::value_type, typename = std::enable_if_t<std::is_same_v<HeaderDescription, T>>>
 		void createHeaders(const Container& descriptions)
@@ -36,7 +97,18 @@ namespace SAV
 			}
 		}
 
-		void updateData(const std::vector<std::vector<std::wstring>>& data);
+		// Every row may carry a value (params[i] for data[i]) which moves and is copied along with the row
+		void updateData(const std::vector<std::vector<std::wstring>>& data, const std::vector<LPARAM>& params = {});
+		// Adds rows after the existing ones, the list is redrawn once
+		void appendData(const std::vector<std::vector<std::wstring>>& data, const std::vector<LPARAM>& params = {});
+		// Owner data mode: takes the row count of the model and repaints the visible rows
+		void refresh();
+		// Owner data mode: repaints rows [first, last] if they are visible
+		void redrawRows(int first, int last);
+		// Makes the row the only selected one and scrolls it into view
+		void selectRow(int row);
+		// Owner data mode: draws the image of every row in front of its first column, 0 hides them
+		void showImages(int size);
 		std::tuple<bool, int> processNotify(WPARAM wp, LPARAM lp);
 
 		int processContextMenu(LPARAM lParam);
@@ -45,18 +117,31 @@ namespace SAV
 		bool processMouseMoving(LPARAM lParam);
 		void processEndDragAndDrop(LPARAM lParam);
 
+		// In owner data mode these take every selected row if the item is one of them
 		void removeItem( const std::optional<int>& itemIndex = std::nullopt );
 		void copyItem( const std::optional<int>& itemIndex = std::nullopt );
 		void setValueToAllItem(const std::optional<int>& itemIndex = std::nullopt);
+		void setItemText(int index, int subItemIndex, const std::wstring& text);
+		// Owner data mode only
+		void reverseItems();
 
 		std::vector<std::vector<std::wstring>> getListViewData() const;
+		std::vector<LPARAM> getListViewParams() const;
 
 		void setOnSelectHandler(const OnSelectHandler& handler)
 		{
 			m_onSelectHandler = handler;
 		}
 
-		void onResize(const ::RECT& position);
+		// Edits made by filling the list through updateData are not reported. In owner data mode
+		// the model reports its changes instead.
+		void setOnEditHandler(const OnEditHandler& handler)
+		{
+			m_onEditHandler = handler;
+		}
+
+		// Adds the move to a batch of BeginDeferWindowPos, returns the batch to go on with
+		HDWP onResize(HDWP positions, const ::RECT& position);
 	private:
 		struct DragAndDropContext
 		{
@@ -111,23 +196,36 @@ namespace SAV
 
 	private:
 		void addHeader(const HeaderDescription& description, int index);
-		void showInplaceEditControl(int itemIndex, int subItemIndex);
+		void showInplaceEditControl(int itemIndex, int subItemIndex, const std::optional<std::wstring>& text = std::nullopt);
 		std::vector<std::wstring> getRowData(int index) const;
+		LPARAM getRowParam(int index) const;
+		std::vector<int> getSelectedRows() const;
+		std::vector<int> getEditedRows(const std::optional<int>& itemIndex) const;
+		// The model may report many changes, the list is painted once afterwards
+		void editWithoutRedraw(const std::function<void()>& edit);
 
-		void insertItem(const std::vector<std::wstring>& itemData, int index);
+		void insertItem(const std::vector<std::wstring>& itemData, int index, LPARAM param = 0);
+		void notifyEdit(ListViewEdit&& edit);
 
 		DragAndDrop createDragAndDropContext(int index);
 		int processCustomDraw(LPNMLVCUSTOMDRAW listViewCustomDraw);
 		int processPrePaint(LPNMLVCUSTOMDRAW listViewCustomDraw);
-		int processPostPaint();
+		int processPostPaint(LPNMLVCUSTOMDRAW listViewCustomDraw);
+		int processItemPostPaint(LPNMLVCUSTOMDRAW listViewCustomDraw);
+		void invalidateRow(int index);
+		void invalidateDragImage();
 
 	private:
 		HWND m_handle;
 		int m_width;
 		int m_height;
 		float m_widthPercent;
+		int m_columnCount;
+		ListViewModel* m_model;
+		int m_imageSize;
 
 		OnSelectHandler m_onSelectHandler;
+		OnEditHandler m_onEditHandler;
 		DragAndDrop m_dragAndDropContext;
 	};
 
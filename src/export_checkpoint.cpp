@@ -0,0 +1,110 @@
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include "export_checkpoint.hpp"
+
+namespace
+{
+	constexpr std::string_view JOB_TAG = "job";
+	constexpr std::string_view SEGMENT_TAG = "segment";
+	constexpr char delim = ';';
+}
+
+namespace SAV
+{
+	ExportCheckpoint::ExportCheckpoint(const std::filesystem::path& output, std::uint64_t jobHash) :
+		m_sidecarPath{ output.wstring() + L".checkpoint" },
+		m_segmentsFolder{ output.wstring() + L".parts" },
+		m_jobHash{ jobHash }
+	{}
+
+	void ExportCheckpoint::load()
+	{
+		m_segments.clear();
+
+		std::ifstream input(m_sidecarPath);
+		std::string rowData;
+		bool isSameJob = false;
+		while (std::getline(input, rowData))
+		{
+			std::istringstream row(rowData);
+			std::string tag;
+			if (!std::getline(row, tag, delim))
+			{
+				continue;
+			}
+
+			if (tag == JOB_TAG)
+			{
+				std::uint64_t jobHash = 0;
+				row >> std::hex >> jobHash;
+				isSameJob = !row.fail() && jobHash == m_jobHash;
+				if (!isSameJob)
+				{
+					break;
+				}
+			}
+			else if (tag == SEGMENT_TAG && isSameJob)
+			{
+				std::uint32_t index = 0;
+				Segment segment = { 0, 0 };
+				char separator = 0;
+				row >> index >> separator >> segment.firstFrame >> separator >> segment.frameCount;
+
+				std::error_code ec;
+				if (!row.fail() && std::filesystem::exists(segmentPath(index), ec))
+				{
+					m_segments[index] = segment;
+				}
+			}
+		}
+
+		if (!isSameJob)
+		{
+			// the output settings or the frames changed, whatever was encoded before is useless now
+			clear();
+		}
+	}
+
+	bool ExportCheckpoint::isCompleted(std::uint32_t segmentIndex) const
+	{
+		return m_segments.find(segmentIndex) != m_segments.end();
+	}
+
+	std::filesystem::path ExportCheckpoint::segmentPath(std::uint32_t segmentIndex) const
+	{
+		std::wostringstream filename;
+		filename << L"segment_" << std::setw(5) << std::setfill(L'0') << segmentIndex << L".mp4";
+		return m_segmentsFolder / filename.str();
+	}
+
+	bool ExportCheckpoint::commit(std::uint32_t segmentIndex, const Segment& segment)
+	{
+		const bool isNewSidecar = m_segments.empty();
+		std::ofstream output(m_sidecarPath, isNewSidecar ? std::ios_base::trunc : std::ios_base::app);
+		if (isNewSidecar)
+		{
+			output << JOB_TAG << delim << std::hex << m_jobHash << std::dec << std::endl;
+		}
+		output << SEGMENT_TAG << delim << segmentIndex << delim << segment.firstFrame << delim << segment.frameCount << std::endl;
+
+		if (!output)
+		{
+			return false;
+		}
+
+		m_segments[segmentIndex] = segment;
+		return true;
+	}
+
+	void ExportCheckpoint::clear()
+	{
+		m_segments.clear();
+
+		std::error_code ec;
+		std::filesystem::remove(m_sidecarPath, ec);
+		std::filesystem::remove_all(m_segmentsFolder, ec);
+	}
+}
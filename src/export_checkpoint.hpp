@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+
+namespace SAV
+{
+	// Sidecar "<output>.checkpoint" listing the segments of an export that are already encoded.
+	// Segment files live in "<output>.parts" until they are assembled into the output file.
+	class ExportCheckpoint
+	{
+	public:
+		struct Segment
+		{
+			std::uint64_t firstFrame;
+			std::uint64_t frameCount;
+		};
+
+	public:
+		ExportCheckpoint(const std::filesystem::path& output, std::uint64_t jobHash);
+
+		// Reads the sidecar. Segments recorded for another job or whose file is missing are dropped.
+		void load();
+
+		bool isCompleted(std::uint32_t segmentIndex) const;
+		std::filesystem::path segmentPath(std::uint32_t segmentIndex) const;
+
+		// Records a finalized segment, the sidecar is flushed before it returns
+		bool commit(std::uint32_t segmentIndex, const Segment& segment);
+
+		// Removes the sidecar and every segment file
+		void clear();
+
+	private:
+		std::filesystem::path m_sidecarPath;
+		std::filesystem::path m_segmentsFolder;
+		std::uint64_t m_jobHash;
+		std::map<std::uint32_t, Segment> m_segments;
+	};
+}
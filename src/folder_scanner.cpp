@@ -0,0 +1,158 @@
+#include <algorithm>
+
+#include "folder_scanner.hpp"
+
+namespace SAV
+{
+	FolderScanner::FolderScanner(const std::filesystem::path& folder, bool isRecursive, const CancellationToken& cancellationToken,
+		const OnBatch& onBatch, const OnFinished& onFinished) :
+		m_cancellationToken{ cancellationToken },
+		m_onBatch{ onBatch },
+		m_onFinished{ onFinished }
+	{
+		const auto workerCount = (std::max)(2u, std::thread::hardware_concurrency());
+		for (std::uint32_t index = 0; index < workerCount; ++index)
+		{
+			m_workers.emplace_back(&FolderScanner::probe, this);
+		}
+		m_enumerator = std::thread(&FolderScanner::enumerate, this, folder, isRecursive);
+	}
+
+	FolderScanner::~FolderScanner()
+	{
+		if (m_enumerator.joinable())
+		{
+			m_enumerator.join();
+		}
+
+		for (auto& worker : m_workers)
+		{
+			worker.join();
+		}
+	}
+
+	void FolderScanner::enumerate(const std::filesystem::path& folder, bool isRecursive)
+	{
+		std::uint64_t sequence = 0;
+		auto push = [this, &sequence](const std::filesystem::directory_entry& entry)
+		{
+			std::error_code ec;
+			if (!entry.is_regular_file(ec))
+			{
+				return;
+			}
+
+			{
+				std::lock_guard guard(m_pathsMutex);
+				m_paths.emplace_back(sequence++, entry.path());
+			}
+			m_pathsCondition.notify_one();
+		};
+
+		std::error_code ec;
+		if (isRecursive)
+		{
+			auto options = std::filesystem::directory_options::skip_permission_denied;
+			for (auto it = std::filesystem::recursive_directory_iterator(folder, options, ec);
+				!ec && it != std::filesystem::recursive_directory_iterator() && !m_cancellationToken.isCanceled(); it.increment(ec))
+			{
+				push(*it);
+			}
+		}
+		else
+		{
+			for (auto it = std::filesystem::directory_iterator(folder, ec);
+				!ec && it != std::filesystem::directory_iterator() && !m_cancellationToken.isCanceled(); it.increment(ec))
+			{
+				push(*it);
+			}
+		}
+
+		{
+			std::lock_guard guard(m_pathsMutex);
+			m_isEnumerated = true;
+		}
+		m_pathsCondition.notify_all();
+
+		// every result may already be in, nobody else would finish the scan then
+		std::lock_guard guard(m_resultsMutex);
+		m_totalCount = sequence;
+		m_isCounted = true;
+		flush();
+	}
+
+	void FolderScanner::probe()
+	{
+		while (true)
+		{
+			std::pair<std::uint64_t, std::filesystem::path> item;
+			{
+				std::unique_lock lock(m_pathsMutex);
+				m_pathsCondition.wait(lock, [this]() { return !m_paths.empty() || m_isEnumerated; });
+				if (m_paths.empty())
+				{
+					return;
+				}
+				item = std::move(m_paths.front());
+				m_paths.pop_front();
+			}
+
+			std::optional<ScannedImage> image;
+			if (!m_cancellationToken.isCanceled())
+			{
+				if (auto info = ImageProbe::probe(item.second); info)
+				{
+					image.emplace(ScannedImage{ std::move(item.second), *info });
+				}
+			}
+			deliver(item.first, std::move(image));
+		}
+	}
+
+	void FolderScanner::deliver(std::uint64_t sequence, std::optional<ScannedImage>&& image)
+	{
+		// callbacks run under the lock so batches can't overtake each other
+		std::lock_guard guard(m_resultsMutex);
+		m_results.emplace(sequence, std::move(image));
+		flush();
+	}
+
+	void FolderScanner::flush()
+	{
+		if (m_isFinished)
+		{
+			return;
+		}
+
+		std::vector<ScannedImage> batch;
+		for (auto it = m_results.begin(); it != m_results.end() && it->first == m_nextSequence; it = m_results.erase(it))
+		{
+			if (it->second)
+			{
+				batch.push_back(std::move(*it->second));
+			}
+			++m_nextSequence;
+
+			if (batch.size() == batchSize)
+			{
+				sendBatch(batch);
+			}
+		}
+		sendBatch(batch);
+
+		if (m_isCounted && m_nextSequence == m_totalCount)
+		{
+			m_isFinished = true;
+			m_onFinished();
+		}
+	}
+
+	void FolderScanner::sendBatch(std::vector<ScannedImage>& batch)
+	{
+		if (!batch.empty() && !m_cancellationToken.isCanceled())
+		{
+			m_onBatch(std::move(batch));
+		}
+		batch.clear();
+	}
+}
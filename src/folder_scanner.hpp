@@ -0,0 +1,73 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "cancellation_token.hpp"
+#include "image_probe.hpp"
+
+namespace SAV
+{
+	struct ScannedImage
+	{
+		std::filesystem::path path;
+		ImageInfo info;
+	};
+
+	// Enumerates a folder (optionally the whole tree) and probes every file on worker threads.
+	// Files that are not images are dropped. Images are delivered in enumeration order, in batches,
+	// as soon as a contiguous run of them is probed.
+	class FolderScanner
+	{
+	public:
+		// Both are called on a worker thread
+		using OnBatch = std::function<void(std::vector<ScannedImage>&&)>;
+		using OnFinished = std::function<void()>;
+
+		inline static constexpr std::size_t batchSize = 256;
+
+	public:
+		FolderScanner(const std::filesystem::path& folder, bool isRecursive, const CancellationToken& cancellationToken,
+			const OnBatch& onBatch, const OnFinished& onFinished);
+		~FolderScanner();
+
+		FolderScanner(const FolderScanner&) = delete;
+		FolderScanner& operator=(const FolderScanner&) = delete;
+
+	private:
+		void enumerate(const std::filesystem::path& folder, bool isRecursive);
+		void probe();
+		void deliver(std::uint64_t sequence, std::optional<ScannedImage>&& image);
+		void flush();
+		void sendBatch(std::vector<ScannedImage>& batch);
+
+	private:
+		CancellationToken m_cancellationToken;
+		OnBatch m_onBatch;
+		OnFinished m_onFinished;
+
+		std::mutex m_pathsMutex;
+		std::condition_variable m_pathsCondition;
+		std::deque<std::pair<std::uint64_t, std::filesystem::path>> m_paths;
+		bool m_isEnumerated = false;
+
+		// results wait here until every file enumerated before them is probed
+		std::mutex m_resultsMutex;
+		std::map<std::uint64_t, std::optional<ScannedImage>> m_results;
+		std::uint64_t m_nextSequence = 0;
+		std::uint64_t m_totalCount = 0;
+		bool m_isCounted = false;
+		bool m_isFinished = false;
+
+		std::thread m_enumerator;
+		std::vector<std::thread> m_workers;
+	};
+}
@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <array>
+#include <optional>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <unordered_map>
+#endif
+
+#include "folder_watcher.hpp"
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Collects changed paths and tells when the batch is due
+	class ChangeBatch
+	{
+	public:
+		void add(std::filesystem::path path)
+		{
+			auto now = Clock::now();
+			if (!m_firstChange)
+			{
+				m_firstChange = now;
+			}
+			m_lastChange = now;
+			m_paths.insert(std::move(path));
+		}
+
+		// nullopt while nothing is pending
+		std::optional<std::chrono::milliseconds> timeLeft() const
+		{
+			if (!m_firstChange)
+			{
+				return std::nullopt;
+			}
+
+			auto deadline = (std::min)(m_lastChange + SAV::FolderWatcher::coalescingDelay, *m_firstChange + SAV::FolderWatcher::maxDelay);
+			auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+			return (std::max)(left, std::chrono::milliseconds{ 0 });
+		}
+
+		void flushIfDue(const SAV::FolderWatcher::OnChanged& onChanged)
+		{
+			if (auto left = timeLeft(); !left || left->count() > 0)
+			{
+				return;
+			}
+
+			onChanged(std::vector<std::filesystem::path>(m_paths.begin(), m_paths.end()));
+			m_paths.clear();
+			m_firstChange.reset();
+		}
+
+	private:
+		std::set<std::filesystem::path> m_paths;
+		std::optional<Clock::time_point> m_firstChange;
+		Clock::time_point m_lastChange;
+	};
+
+#ifdef _WIN32
+	constexpr ULONG_PTR STOP_KEY = ~ULONG_PTR{ 0 };
+	constexpr DWORD NOTIFY_FILTER = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+	constexpr std::size_t NOTIFY_BUFFER_SIZE = 64 * 1024;
+
+	struct DirectoryWatch
+	{
+		std::filesystem::path folder;
+		HANDLE directory = INVALID_HANDLE_VALUE;
+		OVERLAPPED overlapped = {};
+		// ReadDirectoryChangesW wants a DWORD aligned buffer
+		std::vector<DWORD> buffer = std::vector<DWORD>(NOTIFY_BUFFER_SIZE / sizeof(DWORD));
+		bool isPending = false;
+
+		bool arm()
+		{
+			overlapped = {};
+			isPending = ::ReadDirectoryChangesW(directory, buffer.data(), static_cast<DWORD>(buffer.size() * sizeof(DWORD)),
+				FALSE, NOTIFY_FILTER, nullptr, &overlapped, nullptr) != FALSE;
+			return isPending;
+		}
+	};
+#endif
+}
+
+namespace SAV
+{
+	FolderWatcher::FolderWatcher(const OnChanged& onChanged) :
+		m_onChanged{ onChanged }
+	{}
+
+	FolderWatcher::~FolderWatcher()
+	{
+		stop();
+	}
+
+#ifdef _WIN32
+	void FolderWatcher::watch(const std::vector<std::filesystem::path>& folders)
+	{
+		stop();
+
+		m_port = ::CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+		if (!m_port)
+		{
+			return;
+		}
+		m_thread = std::thread(&FolderWatcher::run, this, folders);
+	}
+
+	void FolderWatcher::stop()
+	{
+		if (m_thread.joinable())
+		{
+			::PostQueuedCompletionStatus(m_port, 0, STOP_KEY, nullptr);
+			m_thread.join();
+		}
+
+		if (m_port)
+		{
+			::CloseHandle(m_port);
+			m_port = nullptr;
+		}
+	}
+
+	void FolderWatcher::run(std::vector<std::filesystem::path> folders)
+	{
+		// the OVERLAPPED structures must not move while a read is pending
+		std::vector<std::unique_ptr<DirectoryWatch>> watches;
+		for (auto& folder : folders)
+		{
+			auto watch = std::make_unique<DirectoryWatch>();
+			watch->folder = std::move(folder);
+			watch->directory = ::CreateFileW(watch->folder.c_str(), FILE_LIST_DIRECTORY,
+				FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+				FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+			if (watch->directory == INVALID_HANDLE_VALUE)
+			{
+				continue;
+			}
+
+			if (!::CreateIoCompletionPort(watch->directory, m_port, static_cast<ULONG_PTR>(watches.size()), 0) || !watch->arm())
+			{
+				::CloseHandle(watch->directory);
+				continue;
+			}
+			watches.push_back(std::move(watch));
+		}
+
+		ChangeBatch batch;
+		while (true)
+		{
+			auto timeLeft = batch.timeLeft();
+			DWORD bytes = 0;
+			ULONG_PTR key = 0;
+			OVERLAPPED* overlapped = nullptr;
+			BOOL isCompleted = ::GetQueuedCompletionStatus(m_port, &bytes, &key, &overlapped,
+				timeLeft ? static_cast<DWORD>(timeLeft->count()) : INFINITE);
+
+			if (overlapped == nullptr)
+			{
+				if (isCompleted && key == STOP_KEY)
+				{
+					break;
+				}
+
+				// timeout
+				batch.flushIfDue(m_onChanged);
+				continue;
+			}
+
+			auto& watch = *watches[key];
+			watch.isPending = false;
+			if (!isCompleted || bytes == 0)
+			{
+				// the folder is gone or the buffer overflowed, every file in it may have changed
+				batch.add(watch.folder);
+			}
+			else
+			{
+				auto* data = reinterpret_cast<const BYTE*>(watch.buffer.data());
+				while (true)
+				{
+					auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(data);
+					batch.add(watch.folder / std::wstring_view{ info->FileName, info->FileNameLength / sizeof(wchar_t) });
+					if (info->NextEntryOffset == 0)
+					{
+						break;
+					}
+					data += info->NextEntryOffset;
+				}
+			}
+
+			if (isCompleted)
+			{
+				watch.arm();
+			}
+			batch.flushIfDue(m_onChanged);
+		}
+
+		for (auto& watch : watches)
+		{
+			if (watch->isPending)
+			{
+				DWORD bytes = 0;
+				::CancelIoEx(watch->directory, &watch->overlapped);
+				::GetOverlappedResult(watch->directory, &watch->overlapped, &bytes, TRUE);
+			}
+			::CloseHandle(watch->directory);
+		}
+	}
+#else
+	void FolderWatcher::watch(const std::vector<std::filesystem::path>& folders)
+	{
+		stop();
+
+		m_stopEvent = ::eventfd(0, EFD_CLOEXEC);
+		if (m_stopEvent < 0)
+		{
+			return;
+		}
+		m_thread = std::thread(&FolderWatcher::run, this, folders);
+	}
+
+	void FolderWatcher::stop()
+	{
+		if (m_thread.joinable())
+		{
+			std::uint64_t value = 1;
+			[[maybe_unused]] auto written = ::write(m_stopEvent, &value, sizeof(value));
+			m_thread.join();
+		}
+
+		if (m_stopEvent >= 0)
+		{
+			::close(m_stopEvent);
+			m_stopEvent = -1;
+		}
+	}
+
+	void FolderWatcher::run(std::vector<std::filesystem::path> folders)
+	{
+		int notify = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (notify < 0)
+		{
+			return;
+		}
+
+		std::unordered_map<int, std::filesystem::path> watches;
+		for (auto& folder : folders)
+		{
+			int descriptor = ::inotify_add_watch(notify, folder.c_str(),
+				IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF);
+			if (descriptor >= 0)
+			{
+				watches.emplace(descriptor, std::move(folder));
+			}
+		}
+
+		ChangeBatch batch;
+		alignas(inotify_event) std::array<char, 64 * 1024> buffer;
+		while (true)
+		{
+			auto timeLeft = batch.timeLeft();
+			std::array<pollfd, 2> descriptors = { pollfd{ notify, POLLIN, 0 }, pollfd{ m_stopEvent, POLLIN, 0 } };
+			if (::poll(descriptors.data(), descriptors.size(), timeLeft ? static_cast<int>(timeLeft->count()) : -1) < 0)
+			{
+				continue;
+			}
+
+			if (descriptors[1].revents & POLLIN)
+			{
+				break;
+			}
+
+			if (descriptors[0].revents & POLLIN)
+			{
+				ssize_t size = 0;
+				while ((size = ::read(notify, buffer.data(), buffer.size())) > 0)
+				{
+					for (ssize_t offset = 0; offset < size;)
+					{
+						auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+						offset += sizeof(inotify_event) + event->len;
+
+						if (event->mask & IN_Q_OVERFLOW)
+						{
+							// events were dropped, every watched file may have changed
+							for (const auto& [descriptor, folder] : watches)
+							{
+								batch.add(folder);
+							}
+							continue;
+						}
+
+						auto it = watches.find(event->wd);
+						if (it == watches.end())
+						{
+							continue;
+						}
+						batch.add(event->len > 0 ? it->second / event->name : it->second);
+					}
+				}
+			}
+
+			batch.flushIfDue(m_onChanged);
+		}
+
+		::close(notify);
+	}
+#endif
+}
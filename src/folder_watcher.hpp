@@ -0,0 +1,51 @@
+#pragma once
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace SAV
+{
+	// Watches a set of folders (not their subfolders) for files being written, created, renamed or removed.
+	// Events are collected until the folders stay quiet for coalescingDelay, so a whole re-render
+	// arrives as one batch. If the system dropped events, the folder itself is reported.
+	class FolderWatcher
+	{
+	public:
+		// Called on the watcher thread
+		using OnChanged = std::function<void(std::vector<std::filesystem::path>&&)>;
+
+		inline static constexpr std::chrono::milliseconds coalescingDelay{ 200 };
+		// a folder that never calms down is still reported this often
+		inline static constexpr std::chrono::milliseconds maxDelay{ 2000 };
+
+	public:
+		explicit FolderWatcher(const OnChanged& onChanged);
+		~FolderWatcher();
+
+		FolderWatcher(const FolderWatcher&) = delete;
+		FolderWatcher& operator=(const FolderWatcher&) = delete;
+
+		// Replaces the watched folders
+		void watch(const std::vector<std::filesystem::path>& folders);
+		void stop();
+
+	private:
+		void run(std::vector<std::filesystem::path> folders);
+
+	private:
+		OnChanged m_onChanged;
+		std::thread m_thread;
+#ifdef _WIN32
+		HANDLE m_port = nullptr;
+#else
+		int m_stopEvent = -1;
+#endif
+	};
+}
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cmath>
+#include <cwchar>
+#include <iterator>
+
+#include "frame_list_model.hpp"
+#include "number_parser.hpp"
+#include "utils.hpp"
+
+namespace
+{
+	constexpr int NAME_COLUMN = 0;
+	constexpr int DURATION_COLUMN = 1;
+}
+
+namespace SAV
+{
+	FrameListModel::FrameListModel(FrameModel& frames, const AnimationData& animationData) :
+		m_frames{ frames },
+		m_animationData{ animationData }
+	{}
+
+	void FrameListModel::setFilter(std::vector<std::size_t>&& frames)
+	{
+		m_filter = std::move(frames);
+	}
+
+	void FrameListModel::clearFilter()
+	{
+		m_filter.reset();
+	}
+
+	std::size_t FrameListModel::frameIndex(int row) const
+	{
+		return m_filter ? (*m_filter)[row] : static_cast<std::size_t>(row);
+	}
+
+	int FrameListModel::rowOf(std::size_t frameIndex) const
+	{
+		if (!m_filter)
+		{
+			return static_cast<int>(frameIndex);
+		}
+		return static_cast<int>(std::lower_bound(m_filter->begin(), m_filter->end(), frameIndex) - m_filter->begin());
+	}
+
+	int FrameListModel::rowCount() const
+	{
+		return static_cast<int>(m_filter ? m_filter->size() : m_frames.size());
+	}
+
+	std::wstring FrameListModel::text(int row, int column) const
+	{
+		const auto& frame = m_frames[frameIndex(row)];
+		switch (column)
+		{
+			case NAME_COLUMN:
+				return m_animationData.getName(frame.handle);
+
+			case DURATION_COLUMN:
+				return std::to_wstring(frame.duration.count());
+		}
+		return {};
+	}
+
+	LPARAM FrameListModel::param(int row) const
+	{
+		return static_cast<LPARAM>(m_frames[frameIndex(row)].handle);
+	}
+
+	std::optional<ListViewImage> FrameListModel::image(int row) const
+	{
+		if (!m_thumbnails)
+		{
+			return std::nullopt;
+		}
+
+		auto thumbnail = m_thumbnails->find(m_animationData.getAnimationFilePath(m_frames[frameIndex(row)].handle));
+		if (!thumbnail)
+		{
+			return std::nullopt;
+		}
+		return ListViewImage{ thumbnail->width, thumbnail->height, thumbnail->stride, thumbnail->pixels };
+	}
+
+	void FrameListModel::prepareRows(int first, int last)
+	{
+		if (!m_thumbnails)
+		{
+			return;
+		}
+
+		std::vector<std::filesystem::path> sources;
+		for (auto row = (std::max)(first, 0); row <= last && row < rowCount(); ++row)
+		{
+			sources.push_back(m_animationData.getAnimationFilePath(m_frames[frameIndex(row)].handle));
+		}
+		m_thumbnails->request(sources);
+	}
+
+	void FrameListModel::duplicate(const std::vector<int>& rows)
+	{
+		m_frames.duplicate(toIndices(rows));
+	}
+
+	void FrameListModel::remove(const std::vector<int>& rows)
+	{
+		m_frames.remove(toIndices(rows));
+	}
+
+	void FrameListModel::reverse(const std::vector<int>& rows)
+	{
+		m_frames.reverse(toIndices(rows));
+	}
+
+	bool FrameListModel::setText(const std::vector<int>& rows, int column, const std::wstring& text)
+	{
+		if (column != DURATION_COLUMN || text.empty())
+		{
+			return false;
+		}
+
+		if (text.front() == L'x' || text.front() == L'*')
+		{
+			wchar_t* end = nullptr;
+			auto factor = std::wcstod(text.c_str() + 1, &end);
+			if (end == text.c_str() + 1 || *end != L'\0' || !std::isfinite(factor) || factor < 0.0)
+			{
+				return false;
+			}
+			m_frames.scaleDuration(toIndices(rows), factor);
+			return true;
+		}
+
+		auto duration = NumberParser::parseDuration(text);
+		if (!duration)
+		{
+			return false;
+		}
+		m_frames.setDuration(toIndices(rows), std::chrono::milliseconds{ *duration });
+		return true;
+	}
+
+	int FrameListModel::move(const std::vector<int>& rows, int target)
+	{
+		// a single frame is journaled as one move
+		auto targetIndex = frameIndex(target);
+		if (rows.size() == 1)
+		{
+			m_frames.move(frameIndex(rows.front()), targetIndex);
+			return rowOf(targetIndex);
+		}
+		return rowOf(m_frames.move(toIndices(rows), targetIndex));
+	}
+
+	std::vector<std::size_t> FrameListModel::toIndices(const std::vector<int>& rows) const
+	{
+		std::vector<std::size_t> indices;
+		indices.reserve(rows.size());
+		std::transform(rows.begin(), rows.end(), std::back_inserter(indices), [this](int row) { return frameIndex(row); });
+		return indices;
+	}
+}
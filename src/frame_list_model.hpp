@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "editable_list_view.hpp"
+#include "frame_model.hpp"
+#include "program_data.hpp"
+#include "thumbnail_cache.hpp"
+
+namespace SAV
+{
+	// The frame model as the list shows it: the file name and the duration in milliseconds.
+	// The list asks for the visible cells only, its edits go to the frame model. A filter shows
+	// some of the frames, the rows then map to their indices.
+	class FrameListModel : public ListViewModel
+	{
+	public:
+		FrameListModel(FrameModel& frames, const AnimationData& animationData);
+
+		// Ascending indices of the frames to show
+		void setFilter(std::vector<std::size_t>&& frames);
+		void clearFilter();
+		bool isFiltered() const { return m_filter.has_value(); }
+
+		std::size_t frameIndex(int row) const;
+		// The row showing the frame, or the next one if the filter hides it
+		int rowOf(std::size_t frameIndex) const;
+
+		// The rows show the thumbnails of their frames, nullptr hides them
+		void setThumbnails(ThumbnailCache* thumbnails) { m_thumbnails = thumbnails; }
+		bool hasThumbnails() const { return m_thumbnails != nullptr; }
+
+		int rowCount() const override;
+		std::wstring text(int row, int column) const override;
+		LPARAM param(int row) const override;
+		std::optional<ListViewImage> image(int row) const override;
+		// Asks for the thumbnails of the rows
+		void prepareRows(int first, int last) override;
+
+		void duplicate(const std::vector<int>& rows) override;
+		void remove(const std::vector<int>& rows) override;
+		void reverse(const std::vector<int>& rows) override;
+		// A number sets the duration, "x<factor>" or "*<factor>" scales it
+		bool setText(const std::vector<int>& rows, int column, const std::wstring& text) override;
+
+		int move(const std::vector<int>& rows, int target) override;
+
+	private:
+		std::vector<std::size_t> toIndices(const std::vector<int>& rows) const;
+
+	private:
+		FrameModel& m_frames;
+		const AnimationData& m_animationData;
+		std::optional<std::vector<std::size_t>> m_filter;
+		ThumbnailCache* m_thumbnails = nullptr;
+	};
+}
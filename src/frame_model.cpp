@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "frame_model.hpp"
+
+namespace
+{
+	struct Run
+	{
+		std::size_t first;
+		std::size_t count;
+	};
+
+	std::vector<Run> findRuns(const std::vector<std::size_t>& indices)
+	{
+		std::vector<Run> runs;
+		for (auto index : indices)
+		{
+			if (!runs.empty() && runs.back().first + runs.back().count == index)
+			{
+				++runs.back().count;
+			}
+			else
+			{
+				runs.push_back(Run{ index, 1 });
+			}
+		}
+		return runs;
+	}
+}
+
+namespace SAV
+{
+	void FrameModel::assign(Frames&& frames)
+	{
+		m_frames = std::move(frames);
+		++m_version;
+		notify(Change::Type::Reset, 0, m_frames.size());
+	}
+
+	void FrameModel::append(const Frames& frames)
+	{
+		insert(m_frames.size(), frames);
+	}
+
+	void FrameModel::insert(std::size_t index, const Frames& frames)
+	{
+		if (frames.empty())
+		{
+			return;
+		}
+
+		m_frames.insert(m_frames.begin() + index, frames.begin(), frames.end());
+		++m_version;
+		notify(Change::Type::Insert, index, frames.size());
+	}
+
+	void FrameModel::remove(std::size_t first, std::size_t count)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		m_frames.erase(m_frames.begin() + first, m_frames.begin() + first + count);
+		++m_version;
+		notify(Change::Type::Remove, first, count);
+	}
+
+	void FrameModel::move(std::size_t index, std::size_t target)
+	{
+		if (index == target)
+		{
+			return;
+		}
+
+		// only the frames between the two positions shift
+		auto begin = m_frames.begin();
+		if (index < target)
+		{
+			std::rotate(begin + index, begin + index + 1, begin + target + 1);
+		}
+		else
+		{
+			std::rotate(begin + target, begin + index, begin + index + 1);
+		}
+		++m_version;
+		notify(Change::Type::Move, index, 1, target);
+	}
+
+	void FrameModel::setDuration(std::size_t index, std::chrono::milliseconds duration)
+	{
+		m_frames[index].duration = duration;
+		++m_version;
+		notify(Change::Type::Update, index, 1);
+	}
+
+	void FrameModel::remove(const std::vector<std::size_t>& indices)
+	{
+		auto runs = findRuns(indices);
+		if (runs.empty())
+		{
+			return;
+		}
+
+		// the kept frames move up in one pass
+		auto begin = m_frames.begin();
+		auto write = begin + runs.front().first;
+		std::size_t read = runs.front().first;
+		for (const auto& run : runs)
+		{
+			write = std::move(begin + read, begin + run.first, write);
+			read = run.first + run.count;
+		}
+		write = std::move(begin + read, m_frames.end(), write);
+		m_frames.erase(write, m_frames.end());
+
+		++m_version;
+		// the last run goes first, so the indices of the others still hold
+		for (auto run = runs.rbegin(); run != runs.rend(); ++run)
+		{
+			notify(Change::Type::Remove, run->first, run->count);
+		}
+	}
+
+	void FrameModel::duplicate(const std::vector<std::size_t>& indices)
+	{
+		auto runs = findRuns(indices);
+		if (runs.empty())
+		{
+			return;
+		}
+
+		Frames frames;
+		frames.reserve(m_frames.size() + indices.size());
+		std::vector<Run> inserts;
+		std::size_t next = 0;
+		for (const auto& run : runs)
+		{
+			auto begin = m_frames.begin();
+			frames.insert(frames.end(), begin + next, begin + run.first + run.count);
+			inserts.push_back(Run{ frames.size(), run.count });
+			frames.insert(frames.end(), begin + run.first, begin + run.first + run.count);
+			next = run.first + run.count;
+		}
+		frames.insert(frames.end(), m_frames.begin() + next, m_frames.end());
+		m_frames = std::move(frames);
+
+		++m_version;
+		for (const auto& insert : inserts)
+		{
+			notify(Change::Type::Insert, insert.first, insert.count);
+		}
+	}
+
+	void FrameModel::setDuration(const std::vector<std::size_t>& indices, std::chrono::milliseconds duration)
+	{
+		for (auto index : indices)
+		{
+			m_frames[index].duration = duration;
+		}
+
+		++m_version;
+		for (const auto& run : findRuns(indices))
+		{
+			notify(Change::Type::Update, run.first, run.count);
+		}
+	}
+
+	void FrameModel::scaleDuration(const std::vector<std::size_t>& indices, double factor)
+	{
+		for (auto index : indices)
+		{
+			// clamped like the project files which store durations in 32 bits
+			constexpr double maxMs = (std::numeric_limits<std::uint32_t>::max)();
+			auto& duration = m_frames[index].duration;
+			const auto scaled = (std::min)(maxMs, (std::max)(0.0, static_cast<double>(duration.count()) * factor));
+			duration = std::chrono::milliseconds{ std::llround(scaled) };
+		}
+
+		++m_version;
+		for (const auto& run : findRuns(indices))
+		{
+			notify(Change::Type::Update, run.first, run.count);
+		}
+	}
+
+	void FrameModel::reverse(const std::vector<std::size_t>& indices)
+	{
+		if (indices.size() < 2)
+		{
+			return;
+		}
+
+		for (std::size_t front = 0, back = indices.size() - 1; front < back; ++front, --back)
+		{
+			std::swap(m_frames[indices[front]], m_frames[indices[back]]);
+		}
+
+		++m_version;
+		for (const auto& run : findRuns(indices))
+		{
+			notify(Change::Type::Replace, run.first, run.count);
+		}
+	}
+
+	std::size_t FrameModel::move(const std::vector<std::size_t>& indices, std::size_t target)
+	{
+		if (indices.empty())
+		{
+			return target;
+		}
+
+		// dropped onto one of the moved frames, nothing changes even if they aren't neighbours
+		if (std::binary_search(indices.begin(), indices.end(), target))
+		{
+			return indices.front();
+		}
+
+		// a frame before target makes it a move down, the block goes behind the frame at target
+		// however many frames come after it
+		const auto count = indices.size();
+		const auto before = static_cast<std::size_t>(std::lower_bound(indices.begin(), indices.end(), target) - indices.begin());
+		const auto first = before > 0 ? target + 1 - before : target;
+		const auto blockStart = (std::min)(first, m_frames.size() - count);
+
+		// one pass splits the frames into the block and the rest, the block goes between them
+		Frames block;
+		Frames rest;
+		block.reserve(count);
+		rest.reserve(m_frames.size() - count);
+		auto selected = indices.begin();
+		for (std::size_t index = 0; index < m_frames.size(); ++index)
+		{
+			if (selected != indices.end() && *selected == index)
+			{
+				block.push_back(m_frames[index]);
+				++selected;
+			}
+			else
+			{
+				rest.push_back(m_frames[index]);
+			}
+		}
+
+		auto begin = m_frames.begin();
+		std::copy(rest.begin(), rest.begin() + blockStart, begin);
+		std::copy(block.begin(), block.end(), begin + blockStart);
+		std::copy(rest.begin() + blockStart, rest.end(), begin + blockStart + count);
+
+		++m_version;
+		// every frame between the first moved one and the end of the block may have another place
+		const auto changedFirst = (std::min)(indices.front(), blockStart);
+		const auto changedLast = (std::max)(indices.back(), blockStart + count - 1);
+		notify(Change::Type::Replace, changedFirst, changedLast - changedFirst + 1);
+		return blockStart;
+	}
+
+	FrameModel::HandlerToken FrameModel::addHandler(OnChangeHandler handler)
+	{
+		auto token = m_nextToken++;
+		m_handlers.emplace_back(token, std::move(handler));
+		return token;
+	}
+
+	void FrameModel::removeHandler(HandlerToken token)
+	{
+		m_handlers.erase(std::remove_if(m_handlers.begin(), m_handlers.end(), [token](const auto& handler) { return handler.first == token; }),
+			m_handlers.end());
+	}
+
+	void FrameModel::notify(Change::Type type, std::size_t first, std::size_t count, std::size_t target)
+	{
+		const Change change{ type, first, count, target };
+		for (const auto& [token, handler] : m_handlers)
+		{
+			handler(change);
+		}
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "program_data.hpp"
+
+namespace SAV
+{
+	// The frames of the project in a flat array, the only copy the window keeps. The list, the
+	// timeline and the journal follow it through the change handlers, every edit goes through here.
+	class FrameModel
+	{
+	public:
+		using Frame = AnimationData::Frame;
+		using Frames = AnimationData::Frames;
+
+		struct Change
+		{
+			enum class Type
+			{
+				Reset,  // every frame was replaced
+				Insert, // frames [first, first + count) are new
+				Remove, // frames [first, first + count) were taken out
+				Move,   // the frame at first was taken out and inserted at target
+				Update, // frames [first, first + count) got another duration
+				Replace // frames [first, first + count) were swapped for other ones
+			};
+
+			Type type;
+			std::size_t first;
+			std::size_t count;
+			std::size_t target;
+		};
+
+		using HandlerToken = std::uint32_t;
+		// Called after the frames were changed
+		using OnChangeHandler = std::function<void(const Change&)>;
+
+	public:
+		const Frames& frames() const { return m_frames; }
+		std::size_t size() const { return m_frames.size(); }
+		const Frame& operator[](std::size_t index) const { return m_frames[index]; }
+		// Grows with every edit, the changes reported for one edit see the same value
+		std::uint64_t version() const { return m_version; }
+
+		void assign(Frames&& frames);
+		void append(const Frames& frames);
+		void insert(std::size_t index, const Frames& frames);
+		void remove(std::size_t first, std::size_t count = 1);
+		void move(std::size_t index, std::size_t target);
+		void setDuration(std::size_t index, std::chrono::milliseconds duration);
+
+		// Edits of the frames at ascending indices. They report one change per run of neighbouring
+		// frames once the whole edit is made, applied in the reported order the changes repeat it.
+		void remove(const std::vector<std::size_t>& indices);
+		// The copies of a run are inserted right after it
+		void duplicate(const std::vector<std::size_t>& indices);
+		void setDuration(const std::vector<std::size_t>& indices, std::chrono::milliseconds duration);
+		void scaleDuration(const std::vector<std::size_t>& indices, double factor);
+		// The frames keep the positions but come in the reverse order
+		void reverse(const std::vector<std::size_t>& indices);
+		// The frames are taken out and inserted as one block, right behind the frame at target when any
+		// of them is before it and right in front of it otherwise. Returns the index the block starts
+		// at. Nothing moves when target is one of the indices, the first index is returned then.
+		std::size_t move(const std::vector<std::size_t>& indices, std::size_t target);
+
+		HandlerToken addHandler(OnChangeHandler handler);
+		void removeHandler(HandlerToken token);
+
+	private:
+		void notify(Change::Type type, std::size_t first, std::size_t count, std::size_t target = 0);
+
+	private:
+		Frames m_frames;
+		std::uint64_t m_version = 0;
+		HandlerToken m_nextToken = 0;
+		std::vector<std::pair<HandlerToken, OnChangeHandler>> m_handlers;
+	};
+}
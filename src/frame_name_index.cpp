@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <cwctype>
+#include <numeric>
+
+#include "frame_name_index.hpp"
+
+namespace
+{
+	constexpr std::size_t GRAM_LENGTH = 3;
+
+	std::wstring toLower(std::wstring_view text)
+	{
+		std::wstring lower(text.size(), L'\0');
+		std::transform(text.begin(), text.end(), lower.begin(), [](wchar_t symbol) { return static_cast<wchar_t>(std::towlower(symbol)); });
+		return lower;
+	}
+
+	// Up to GRAM_LENGTH characters, the length keeps grams of different lengths apart
+	std::uint64_t gram(std::wstring_view text)
+	{
+		std::uint64_t key = text.size();
+		for (auto symbol : text)
+		{
+			key = (key << 16) | static_cast<std::uint16_t>(symbol);
+		}
+		return key;
+	}
+}
+
+namespace SAV
+{
+	void FrameNameIndex::add(FrameHandle handle, std::wstring_view name)
+	{
+		const auto entry = static_cast<std::uint32_t>(m_entries.size());
+		if (!m_entryOf.try_emplace(handle, entry).second)
+		{
+			return;
+		}
+
+		const auto lower = toLower(name);
+		m_entries.push_back(Entry{ static_cast<std::uint32_t>(m_names.size()), static_cast<std::uint32_t>(lower.size()) });
+		m_names += lower;
+
+		const std::wstring_view text{ lower };
+		for (std::size_t length = 1; length <= GRAM_LENGTH; ++length)
+		{
+			for (std::size_t position = 0; position + length <= text.size(); ++position)
+			{
+				// a name with the same characters twice is listed once
+				auto& entries = m_grams[gram(text.substr(position, length))];
+				if (entries.empty() || entries.back() != entry)
+				{
+					entries.push_back(entry);
+				}
+			}
+		}
+	}
+
+	void FrameNameIndex::setFrames(const std::vector<FrameHandle>& frames)
+	{
+		// counted first, so the positions of all names fit in one array
+		constexpr auto unknown = ~std::uint32_t{ 0 };
+		std::vector<std::uint32_t> frameEntries(frames.size(), unknown);
+		m_frameStarts.assign(m_entries.size() + 1, 0);
+		for (std::size_t position = 0; position < frames.size(); ++position)
+		{
+			if (auto it = m_entryOf.find(frames[position]); it != m_entryOf.end())
+			{
+				frameEntries[position] = it->second;
+				++m_frameStarts[it->second + 1];
+			}
+		}
+		std::partial_sum(m_frameStarts.begin(), m_frameStarts.end(), m_frameStarts.begin());
+
+		m_frameCount = frames.size();
+		m_framePositions.resize(m_frameStarts.back());
+		auto next = m_frameStarts;
+		for (std::size_t position = 0; position < frames.size(); ++position)
+		{
+			if (frameEntries[position] != unknown)
+			{
+				m_framePositions[next[frameEntries[position]]++] = static_cast<std::uint32_t>(position);
+			}
+		}
+	}
+
+	std::vector<std::size_t> FrameNameIndex::find(std::wstring_view text) const
+	{
+		const auto entries = findEntries(toLower(text));
+		// names added after the last setFrames() have no frames yet
+		const auto known = m_frameStarts.empty() ? 0 : m_frameStarts.size() - 1;
+
+		std::size_t count = 0;
+		for (auto entry : entries)
+		{
+			if (entry < known)
+			{
+				count += m_frameStarts[entry + 1] - m_frameStarts[entry];
+			}
+		}
+
+		std::vector<std::size_t> positions;
+		if (count == m_frameCount)
+		{
+			// every frame, a common character of the names was typed
+			positions.resize(count);
+			std::iota(positions.begin(), positions.end(), 0);
+			return positions;
+		}
+
+		positions.reserve(count);
+		if (count < m_frameCount / 16)
+		{
+			// a few frames, their positions are sorted
+			for (auto entry : entries)
+			{
+				if (entry < known)
+				{
+					positions.insert(positions.end(), m_framePositions.begin() + m_frameStarts[entry], m_framePositions.begin() + m_frameStarts[entry + 1]);
+				}
+			}
+			std::sort(positions.begin(), positions.end());
+			return positions;
+		}
+
+		// most of the frames, marking them is cheaper than sorting
+		std::vector<char> isFound(m_frameCount);
+		for (auto entry : entries)
+		{
+			if (entry < known)
+			{
+				for (auto index = m_frameStarts[entry]; index < m_frameStarts[entry + 1]; ++index)
+				{
+					isFound[m_framePositions[index]] = true;
+				}
+			}
+		}
+		for (std::size_t position = 0; position < m_frameCount; ++position)
+		{
+			if (isFound[position])
+			{
+				positions.push_back(position);
+			}
+		}
+		return positions;
+	}
+
+	std::vector<std::uint32_t> FrameNameIndex::findEntries(const std::wstring& lower) const
+	{
+		const std::wstring_view text{ lower };
+		if (text.empty())
+		{
+			std::vector<std::uint32_t> entries(m_entries.size());
+			std::iota(entries.begin(), entries.end(), 0);
+			return entries;
+		}
+
+		// a short text is a gram of its own, its names need no check
+		if (text.size() <= GRAM_LENGTH)
+		{
+			auto it = m_grams.find(gram(text));
+			return it != m_grams.end() ? it->second : std::vector<std::uint32_t>{};
+		}
+
+		const std::vector<std::uint32_t>* rarest = nullptr;
+		for (std::size_t position = 0; position + GRAM_LENGTH <= text.size(); ++position)
+		{
+			auto it = m_grams.find(gram(text.substr(position, GRAM_LENGTH)));
+			if (it == m_grams.end())
+			{
+				return {};
+			}
+			if (!rarest || it->second.size() < rarest->size())
+			{
+				rarest = &it->second;
+			}
+		}
+
+		const std::wstring_view names{ m_names };
+		std::vector<std::uint32_t> entries;
+		for (auto entry : *rarest)
+		{
+			if (names.substr(m_entries[entry].offset, m_entries[entry].length).find(text) != std::wstring_view::npos)
+			{
+				entries.push_back(entry);
+			}
+		}
+		return entries;
+	}
+}
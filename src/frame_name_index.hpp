@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "path_pool.hpp"
+
+namespace SAV
+{
+	// Finds frames by a part of their file name, case is ignored. Every one, two and three characters
+	// of a name point to the names holding them, a search only checks the names of its rarest three.
+	// Names are added once per frame handle, an edit of the frame list only redoes the positions of
+	// the frames of every name.
+	class FrameNameIndex
+	{
+	public:
+		// The frame handles of AnimationData
+		using FrameHandle = PathPool::Handle;
+
+	public:
+		// A handle which is known already is skipped
+		void add(FrameHandle handle, std::wstring_view name);
+		bool contains(FrameHandle handle) const { return m_entryOf.find(handle) != m_entryOf.end(); }
+
+		// The handles of the frame list in its order, after every edit of it. Frames with handles
+		// which weren't added are never found.
+		void setFrames(const std::vector<FrameHandle>& frames);
+		// Ascending positions of the frames whose names contain the text
+		std::vector<std::size_t> find(std::wstring_view text) const;
+
+	private:
+		struct Entry
+		{
+			std::uint32_t offset;
+			std::uint32_t length;
+		};
+
+	private:
+		// Ascending entries of the names containing the lower case text
+		std::vector<std::uint32_t> findEntries(const std::wstring& lower) const;
+
+	private:
+		std::wstring m_names; // lower case, one after another
+		std::vector<Entry> m_entries;
+		std::unordered_map<FrameHandle, std::uint32_t> m_entryOf;
+		std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> m_grams;
+		std::size_t m_frameCount = 0;
+		// The frame positions of every entry one after another, the ones of entry e start at
+		// m_frameStarts[e] and end at m_frameStarts[e + 1]
+		std::vector<std::uint32_t> m_frameStarts;
+		std::vector<std::uint32_t> m_framePositions;
+	};
+}
@@ -0,0 +1,186 @@
+#include <fstream>
+#include <unordered_set>
+
+#include "frame_pack.hpp"
+#include "utils.hpp"
+
+namespace
+{
+	constexpr std::size_t COPY_CHUNK_SIZE = 1024 * 1024;
+
+	constexpr std::uint64_t alignTo(std::uint64_t value, std::uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+namespace SAV
+{
+	namespace FramePackFile
+	{
+		std::filesystem::path sidecarPath(const std::filesystem::path& project)
+		{
+			auto path = project;
+			path += extension;
+			return path;
+		}
+
+		bool build(const std::filesystem::path& packFile, const std::vector<std::filesystem::path>& files)
+		{
+			std::vector<std::wstring> paths;
+			std::unordered_set<std::wstring> knownPaths;
+			for (const auto& file : files)
+			{
+				if (knownPaths.insert(file.wstring()).second)
+				{
+					paths.push_back(file.wstring());
+				}
+			}
+
+			Header header = { magic, version, static_cast<std::uint32_t>(paths.size()), 0, sizeof(Header), 0 };
+
+			std::vector<Entry> entries;
+			entries.reserve(paths.size());
+			std::uint64_t offset = header.entriesOffset + paths.size() * sizeof(Entry);
+			for (const auto& path : paths)
+			{
+				entries.push_back(Entry{ offset, static_cast<std::uint32_t>(path.size()), Codec::Stored, 0, 0, Utils::FNV_OFFSET_BASIS, 0, 0 });
+				offset += path.size() * sizeof(wchar_t);
+			}
+			header.payloadsOffset = alignTo(offset, payloadAlignment);
+
+			// the entries get their payload fields once the files are copied, they are written again then
+			std::ofstream output(packFile, std::ios_base::binary | std::ios_base::trunc);
+			Utils::writeValue(output, header);
+			output.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+			for (const auto& path : paths)
+			{
+				output.write(reinterpret_cast<const char*>(path.data()), static_cast<std::streamsize>(path.size() * sizeof(wchar_t)));
+			}
+			Utils::writePadding(output, header.payloadsOffset - offset);
+
+			std::vector<char> buffer(COPY_CHUNK_SIZE);
+			offset = header.payloadsOffset;
+			for (std::size_t index = 0; index < paths.size(); ++index)
+			{
+				auto& entry = entries[index];
+				auto stamp = Utils::stampOf(paths[index]);
+				if (!stamp)
+				{
+					return false;
+				}
+				entry.sourceSize = stamp->size;
+				entry.sourceModified = stamp->modified;
+
+				std::ifstream input(std::filesystem::path{ paths[index] }, std::ios_base::binary);
+				if (!input)
+				{
+					return false;
+				}
+
+				entry.payloadOffset = offset;
+				while (input)
+				{
+					input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+					const auto count = static_cast<std::size_t>(input.gcount());
+					entry.checksum = Utils::hash(buffer.data(), count, entry.checksum);
+					entry.payloadSize += count;
+					output.write(buffer.data(), static_cast<std::streamsize>(count));
+				}
+
+				offset = alignTo(entry.payloadOffset + entry.payloadSize, payloadAlignment);
+				Utils::writePadding(output, offset - entry.payloadOffset - entry.payloadSize);
+			}
+
+			output.seekp(static_cast<std::streamoff>(header.entriesOffset));
+			output.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+			return static_cast<bool>(output);
+		}
+	}
+
+	std::optional<FramePack> FramePack::open(const std::filesystem::path& file)
+	{
+		auto mappedFile = MappedFile::open(file);
+		if (!mappedFile)
+		{
+			return std::nullopt;
+		}
+
+		FramePack pack{ std::move(*mappedFile) };
+		if (!pack.validate())
+		{
+			return std::nullopt;
+		}
+		return std::optional<FramePack>{ std::move(pack) };
+	}
+
+	bool FramePack::validate()
+	{
+		const auto size = static_cast<std::uint64_t>(m_file.size());
+		if (size < sizeof(FramePackFile::Header))
+		{
+			return false;
+		}
+
+		const auto& fileHeader = header();
+		if (fileHeader.magic != FramePackFile::magic || fileHeader.version != FramePackFile::version ||
+			fileHeader.entriesOffset % alignof(FramePackFile::Entry) != 0 ||
+			!Utils::isRangeInside(fileHeader.entriesOffset, fileHeader.entryCount, sizeof(FramePackFile::Entry), size))
+		{
+			return false;
+		}
+
+		m_index.reserve(fileHeader.entryCount);
+		m_checks = std::make_unique<std::atomic<Check>[]>(fileHeader.entryCount);
+		for (std::uint32_t index = 0; index < fileHeader.entryCount; ++index)
+		{
+			const auto& entry = entries()[index];
+			if (entry.pathOffset % sizeof(wchar_t) != 0 || !Utils::isRangeInside(entry.pathOffset, entry.pathLength, sizeof(wchar_t), size) ||
+				entry.codec != FramePackFile::Codec::Stored || entry.payloadOffset > size || entry.payloadSize > size - entry.payloadOffset)
+			{
+				return false;
+			}
+
+			std::wstring_view path{ reinterpret_cast<const wchar_t*>(m_file.data() + entry.pathOffset), entry.pathLength };
+			m_index.emplace(path, index);
+		}
+
+		return true;
+	}
+
+	const FramePackFile::Entry* FramePack::findEntry(std::wstring_view path) const
+	{
+		if (auto it = m_index.find(path); it != m_index.end())
+		{
+			return &entries()[it->second];
+		}
+		return nullptr;
+	}
+
+	std::optional<FramePayload> FramePack::read(std::wstring_view path) const
+	{
+		auto it = m_index.find(path);
+		if (it == m_index.end())
+		{
+			return std::nullopt;
+		}
+
+		const auto& entry = entries()[it->second];
+		FramePayload payload{ m_file.data() + entry.payloadOffset, static_cast<std::size_t>(entry.payloadSize) };
+
+		// two threads may both hash a frame read for the first time, they come to the same result
+		auto& check = m_checks[it->second];
+		if (check.load(std::memory_order_acquire) == Check::Unknown)
+		{
+			// a damaged frame is read from its file instead, the caller can't tell the difference
+			const bool isValid = Utils::hash(payload.data, payload.size) == entry.checksum;
+			check.store(isValid ? Check::Valid : Check::Invalid, std::memory_order_release);
+		}
+
+		if (check.load(std::memory_order_acquire) != Check::Valid)
+		{
+			return std::nullopt;
+		}
+		return payload;
+	}
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+namespace SAV
+{
+	// Frame pack (.savpack): the image files of a project bundled into one file, so reading a frame
+	// costs a lookup in a mapped file instead of an open and a stat. All integers are little endian,
+	// paths are UTF-16.
+	//
+	//   Header
+	//   Entry[entryCount]
+	//   wchar_t[]            source paths
+	//   payloads             each one starts at a payloadAlignment boundary
+	namespace FramePackFile
+	{
+		inline constexpr std::array<char, 4> magic = { 'S', 'A', 'V', 'P' };
+		inline constexpr std::uint32_t version = 1;
+		inline constexpr std::wstring_view extension = L".savpack";
+		// payloads start on a page so reading one maps as few pages as possible
+		inline constexpr std::uint64_t payloadAlignment = 4096;
+
+		enum class Codec : std::uint32_t
+		{
+			Stored // the original file bytes
+		};
+
+		struct Header
+		{
+			std::array<char, 4> magic;
+			std::uint32_t version;
+			std::uint32_t entryCount;
+			std::uint32_t reserved;
+			std::uint64_t entriesOffset;
+			std::uint64_t payloadsOffset;
+		};
+
+		struct Entry
+		{
+			std::uint64_t pathOffset;
+			std::uint32_t pathLength;
+			Codec codec;
+			std::uint64_t payloadOffset;
+			std::uint64_t payloadSize;
+			std::uint64_t checksum; // FNV-1a of the payload
+			// the source file when the pack was built, a pack older than its sources is not used
+			std::uint64_t sourceSize;
+			std::int64_t sourceModified;
+		};
+
+		static_assert(sizeof(Header) == 32 && sizeof(Entry) == 56, "the layout is part of the format");
+
+		std::filesystem::path sidecarPath(const std::filesystem::path& project);
+
+		// Every distinct file is stored once. Fails if a file can't be read.
+		bool build(const std::filesystem::path& packFile, const std::vector<std::filesystem::path>& files);
+	}
+
+	struct FramePayload
+	{
+		const std::byte* data;
+		std::size_t size;
+	};
+
+	// Read-only access to a mapped frame pack, safe to share between threads
+	class FramePack
+	{
+	public:
+		// Returns nullopt if the file is not a valid pack
+		static std::optional<FramePack> open(const std::filesystem::path& file);
+
+		const FramePackFile::Entry* findEntry(std::wstring_view path) const;
+		// Returns nullopt if the frame is not packed or its checksum doesn't match.
+		// The checksum of a frame is checked the first time it is read, any thread may read.
+		std::optional<FramePayload> read(std::wstring_view path) const;
+
+		std::size_t size() const { return m_index.size(); }
+
+	private:
+		explicit FramePack(MappedFile&& file) :
+			m_file{ std::move(file) }
+		{}
+
+		bool validate();
+
+		const FramePackFile::Header& header() const { return *reinterpret_cast<const FramePackFile::Header*>(m_file.data()); }
+		const FramePackFile::Entry* entries() const
+		{
+			return reinterpret_cast<const FramePackFile::Entry*>(m_file.data() + header().entriesOffset);
+		}
+
+	private:
+		enum class Check : std::uint8_t
+		{
+			Unknown,
+			Valid,
+			Invalid
+		};
+
+	private:
+		MappedFile m_file;
+		std::unordered_map<std::wstring_view, std::uint32_t> m_index; // views into the mapping
+		std::unique_ptr<std::atomic<Check>[]> m_checks; // one per entry
+	};
+
+	using FramePackPtr = std::shared_ptr<const FramePack>;
+}
@@ -0,0 +1,338 @@
+#include <shlwapi.h>
+#include <winrt/base.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+#include "frame_pipeline.hpp"
+
+#pragma comment (lib, "Shlwapi.lib")
+
+namespace
+{
+	constexpr std::size_t READ_CHUNK_SIZE = 1024 * 1024;
+	constexpr std::chrono::milliseconds CANCEL_POLL_INTERVAL{ 10 };
+
+	// reads the whole file in chunks so a cancel request is noticed while a large image is still loading
+	std::optional<SAV::AsyncFileReader::Buffer> readFile(const std::filesystem::path& filepath, const SAV::CancellationToken& cancellationToken)
+	{
+		std::ifstream input(filepath, std::ios_base::binary | std::ios_base::ate);
+		if (!input)
+		{
+			return std::nullopt;
+		}
+
+		SAV::AsyncFileReader::Buffer data(static_cast<std::size_t>(input.tellg()));
+		input.seekg(0);
+
+		std::size_t offset = 0;
+		while (offset < data.size())
+		{
+			if (cancellationToken.isCanceled())
+			{
+				return std::nullopt;
+			}
+
+			auto chunkSize = (std::min)(READ_CHUNK_SIZE, data.size() - offset);
+			if (!input.read(reinterpret_cast<char*>(data.data() + offset), static_cast<std::streamsize>(chunkSize)))
+			{
+				return std::nullopt;
+			}
+			offset += chunkSize;
+		}
+
+		return data;
+	}
+
+	// nullopt if the read failed or the token was canceled first
+	const std::optional<SAV::AsyncFileReader::Buffer>* waitForRead(const SAV::AsyncFileReader::PendingRead& read,
+		const SAV::CancellationToken& cancellationToken)
+	{
+		while (read.wait_for(CANCEL_POLL_INTERVAL) != std::future_status::ready)
+		{
+			if (cancellationToken.isCanceled())
+			{
+				return nullptr;
+			}
+		}
+		return &read.get();
+	}
+
+}
+
+namespace SAV
+{
+	void DecodedFrame::prefetch(AsyncFileReader& reader)
+	{
+		std::lock_guard guard(m_mutex);
+		if (m_isDecoded || m_pendingRead || (m_pack && m_pack->findEntry(m_source.wstring())))
+		{
+			return;
+		}
+		m_pendingRead = reader.read(m_source);
+	}
+
+	bool DecodedFrame::decode(const CancellationToken& cancellationToken)
+	{
+		std::lock_guard guard(m_mutex);
+		if (m_isDecoded)
+		{
+			return *m_isDecoded;
+		}
+
+		std::optional<FramePayload> payload;
+		if (m_pack)
+		{
+			payload = m_pack->read(m_source.wstring());
+		}
+
+		std::optional<AsyncFileReader::Buffer> fileData;
+		if (!payload && m_pendingRead)
+		{
+			auto* read = waitForRead(*m_pendingRead, cancellationToken);
+			if (!read)
+			{
+				return false;
+			}
+			if (*read)
+			{
+				payload = FramePayload{ (*read)->data(), (*read)->size() };
+			}
+		}
+
+		if (!payload)
+		{
+			fileData = readFile(m_source, cancellationToken);
+			if (!fileData)
+			{
+				// a canceled read may be retried, a missing file may not
+				if (!cancellationToken.isCanceled())
+				{
+					m_isDecoded = false;
+				}
+				return false;
+			}
+			payload = FramePayload{ fileData->data(), fileData->size() };
+		}
+
+		winrt::com_ptr<IStream> stream;
+		stream.attach(::SHCreateMemStream(reinterpret_cast<const BYTE*>(payload->data), static_cast<UINT>(payload->size)));
+		// the stream has its own copy
+		m_pendingRead.reset();
+		if (!stream)
+		{
+			m_isDecoded = false;
+			return false;
+		}
+
+		Gdiplus::Bitmap bitmap{ stream.get() };
+		if (bitmap.GetLastStatus() != Gdiplus::Ok)
+		{
+			m_isDecoded = false;
+			return false;
+		}
+
+		m_width = bitmap.GetWidth();
+		m_height = bitmap.GetHeight();
+		m_pixels.resize(static_cast<std::size_t>(m_width) * m_height * 4);
+
+		Gdiplus::Rect rect{ 0, 0, static_cast<INT>(m_width), static_cast<INT>(m_height) };
+		Gdiplus::BitmapData bitmapData;
+		bitmapData.Width = m_width;
+		bitmapData.Height = m_height;
+		bitmapData.Stride = static_cast<INT>(m_width * 4);
+		bitmapData.PixelFormat = PixelFormat32bppARGB;
+		bitmapData.Scan0 = m_pixels.data();
+		bitmapData.Reserved = 0;
+
+		// the user buffer mode makes GDI+ decode straight into m_pixels
+		if (bitmap.LockBits(&rect, Gdiplus::ImageLockModeRead | Gdiplus::ImageLockModeUserInputBuf, PixelFormat32bppARGB, &bitmapData) != Gdiplus::Ok)
+		{
+			m_pixels.clear();
+			m_isDecoded = false;
+			return false;
+		}
+		bitmap.UnlockBits(&bitmapData);
+
+		m_isDecoded = true;
+		return true;
+	}
+
+	std::unique_ptr<Gdiplus::Bitmap> DecodedFrame::createBitmap() const
+	{
+		return std::make_unique<Gdiplus::Bitmap>(static_cast<INT>(m_width), static_cast<INT>(m_height), static_cast<INT>(m_width * 4),
+			PixelFormat32bppARGB, const_cast<BYTE*>(m_pixels.data()));
+	}
+
+	DecodedFramePtr DirectFrameSource::frame(std::size_t row)
+	{
+		const auto& source = m_data.at(row).path();
+		auto& frame = m_frames[source.wstring()];
+		if (auto decodedFrame = frame.lock(); decodedFrame)
+		{
+			return decodedFrame;
+		}
+
+		auto decodedFrame = std::make_shared<DecodedFrame>(source, m_pack);
+		decodedFrame->prefetch(m_reader);
+		frame = decodedFrame;
+		return decodedFrame;
+	}
+
+	DecodedFramePtr DirectFrameSource::acquire(std::size_t row, const CancellationToken&)
+	{
+		while (!m_ahead.empty() && m_ahead.front().first < row)
+		{
+			m_ahead.pop_front();
+		}
+
+		// keep the reads of the next rows in flight
+		m_nextPrefetch = (std::max)(m_nextPrefetch, row);
+		for (; m_nextPrefetch < m_data.size() && m_nextPrefetch <= row + m_readsInFlight; ++m_nextPrefetch)
+		{
+			m_ahead.emplace_back(m_nextPrefetch, frame(m_nextPrefetch));
+		}
+
+		return frame(row);
+	}
+
+	FanOutFrameSource::FanOutFrameSource(const std::vector<AnimationDescription>& data, std::size_t consumerCount, const CancellationToken& cancellationToken,
+		FramePackPtr pack, std::size_t readsInFlight) :
+		m_data{ data },
+		m_pack{ std::move(pack) },
+		m_reader{ readsInFlight },
+		m_cancellationToken{ cancellationToken }
+	{
+		for (std::size_t index = 0; index < consumerCount; ++index)
+		{
+			m_consumers.push_back(std::make_unique<Consumer>(*this));
+		}
+		m_producer = std::thread(&FanOutFrameSource::produce, this);
+	}
+
+	FanOutFrameSource::~FanOutFrameSource()
+	{
+		{
+			std::lock_guard guard(m_mutex);
+			for (auto& consumer : m_consumers)
+			{
+				consumer->m_isClosed = true;
+			}
+		}
+		m_condition.notify_all();
+
+		if (m_producer.joinable())
+		{
+			m_producer.join();
+		}
+	}
+
+	void FanOutFrameSource::close(std::size_t index)
+	{
+		{
+			std::lock_guard guard(m_mutex);
+			m_consumers[index]->m_isClosed = true;
+			m_consumers[index]->m_queue.clear();
+		}
+		m_condition.notify_all();
+	}
+
+	void FanOutFrameSource::produce()
+	{
+		std::unordered_map<std::wstring, std::weak_ptr<DecodedFrame>> frames;
+
+		for (std::size_t row = 0; row < m_data.size(); ++row)
+		{
+			// the frame is only a handle here, the first consumer which misses its scaled cache decodes it
+			const auto& source = m_data[row].path();
+			auto& frame = frames[source.wstring()];
+			auto decodedFrame = frame.lock();
+			if (!decodedFrame)
+			{
+				decodedFrame = std::make_shared<DecodedFrame>(source, m_pack);
+				decodedFrame->prefetch(m_reader);
+				frame = decodedFrame;
+			}
+
+			std::unique_lock lock(m_mutex);
+			auto hasRoom = [this]()
+			{
+				return std::all_of(m_consumers.begin(), m_consumers.end(),
+					[](const auto& consumer) { return consumer->m_isClosed || consumer->m_queue.size() < queueCapacity; });
+			};
+
+			while (!hasRoom())
+			{
+				if (m_cancellationToken.isCanceled())
+				{
+					break;
+				}
+				m_condition.wait_for(lock, CANCEL_POLL_INTERVAL);
+			}
+
+			if (m_cancellationToken.isCanceled())
+			{
+				break;
+			}
+
+			bool hasConsumers = false;
+			for (auto& consumer : m_consumers)
+			{
+				if (!consumer->m_isClosed)
+				{
+					consumer->m_queue.emplace_back(row, decodedFrame);
+					hasConsumers = true;
+				}
+			}
+			lock.unlock();
+			m_condition.notify_all();
+
+			if (!hasConsumers)
+			{
+				break;
+			}
+		}
+
+		{
+			std::lock_guard guard(m_mutex);
+			m_isProduced = true;
+		}
+		m_condition.notify_all();
+	}
+
+	DecodedFramePtr FanOutFrameSource::Consumer::acquire(std::size_t row, const CancellationToken& cancellationToken)
+	{
+		std::unique_lock lock(m_owner.m_mutex);
+		while (true)
+		{
+			// rows of segments finished by an earlier run are never requested
+			while (!m_queue.empty() && m_queue.front().first < row)
+			{
+				m_queue.pop_front();
+				m_owner.m_condition.notify_all();
+			}
+
+			if (!m_queue.empty())
+			{
+				if (m_queue.front().first != row)
+				{
+					return nullptr;
+				}
+
+				auto decodedFrame = std::move(m_queue.front().second);
+				m_queue.pop_front();
+				lock.unlock();
+				m_owner.m_condition.notify_all();
+				return decodedFrame;
+			}
+
+			if (m_owner.m_isProduced || cancellationToken.isCanceled())
+			{
+				return nullptr;
+			}
+
+			m_owner.m_condition.wait_for(lock, CANCEL_POLL_INTERVAL);
+		}
+	}
+}
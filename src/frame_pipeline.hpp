@@ -0,0 +1,161 @@
+#pragma once
+#include <Windows.h>
+#include <gdiplus.h>
+#include <gdiplusheaders.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "async_file_reader.hpp"
+#include "cancellation_token.hpp"
+#include "frame_pack.hpp"
+#include "program_data.hpp"
+
+namespace SAV
+{
+	// Source image decoded to 32bpp ARGB pixels. The file is decoded by the first caller of decode(),
+	// afterwards the pixels are read-only and may be shared between threads.
+	// If a frame pack holds the source, the image is decoded from the pack instead of its file.
+	class DecodedFrame
+	{
+	public:
+		explicit DecodedFrame(const std::filesystem::path& source, FramePackPtr pack = nullptr) :
+			m_source{ source },
+			m_pack{ std::move(pack) }
+		{}
+
+		DecodedFrame(const DecodedFrame&) = delete;
+		DecodedFrame& operator=(const DecodedFrame&) = delete;
+
+		const std::filesystem::path& source() const { return m_source; }
+
+		// Starts reading the file in the background, decode() then waits for that read instead of reading itself
+		void prefetch(AsyncFileReader& reader);
+
+		// Returns false if the image can't be decoded or the token was canceled meanwhile
+		bool decode(const CancellationToken& cancellationToken);
+
+		// Valid after decode() succeeded, a row is width() * 4 bytes
+		std::uint32_t width() const { return m_width; }
+		std::uint32_t height() const { return m_height; }
+		const std::vector<BYTE>& pixels() const { return m_pixels; }
+
+		// GDI+ objects must not be used from several threads, so every consumer wraps the pixels in its own bitmap
+		std::unique_ptr<Gdiplus::Bitmap> createBitmap() const;
+
+	private:
+		std::filesystem::path m_source;
+		FramePackPtr m_pack;
+		std::mutex m_mutex;
+		std::optional<AsyncFileReader::PendingRead> m_pendingRead;
+		std::optional<bool> m_isDecoded;
+		std::uint32_t m_width = 0;
+		std::uint32_t m_height = 0;
+		std::vector<BYTE> m_pixels;
+	};
+
+	using DecodedFramePtr = std::shared_ptr<DecodedFrame>;
+
+	// Supplies the source image of every export row. Rows are requested in increasing order, some may be skipped.
+	class FrameSource
+	{
+	public:
+		virtual ~FrameSource()
+		{};
+
+		virtual DecodedFramePtr acquire(std::size_t row, const CancellationToken& cancellationToken) = 0;
+	};
+
+	// Frame source for a single consumer. Rows showing the same file share one DecodedFrame.
+	// The files of the next readsInFlight rows are read in the background.
+	class DirectFrameSource final : public FrameSource
+	{
+	public:
+		explicit DirectFrameSource(const std::vector<AnimationDescription>& data, FramePackPtr pack = nullptr,
+			std::size_t readsInFlight = AsyncFileReader::defaultReadsInFlight) :
+			m_data{ data },
+			m_pack{ std::move(pack) },
+			m_readsInFlight{ readsInFlight },
+			m_reader{ readsInFlight }
+		{}
+
+		DecodedFramePtr acquire(std::size_t row, const CancellationToken& cancellationToken) override;
+
+	private:
+		DecodedFramePtr frame(std::size_t row);
+
+	private:
+		const std::vector<AnimationDescription>& m_data;
+		FramePackPtr m_pack;
+		std::size_t m_readsInFlight;
+		AsyncFileReader m_reader;
+		std::unordered_map<std::wstring, std::weak_ptr<DecodedFrame>> m_frames;
+		// keeps the prefetched frames alive until their rows are requested
+		std::deque<std::pair<std::size_t, DecodedFramePtr>> m_ahead;
+		std::size_t m_nextPrefetch = 0;
+	};
+
+	// Walks the rows once on its own thread and hands the same DecodedFrame to every consumer,
+	// so an image is decoded once however many outputs are encoded from it.
+	// Each consumer queue is bounded, a consumer that is far behind holds the producer back.
+	class FanOutFrameSource
+	{
+	public:
+		inline static constexpr std::size_t queueCapacity = 8;
+
+	public:
+		FanOutFrameSource(const std::vector<AnimationDescription>& data, std::size_t consumerCount, const CancellationToken& cancellationToken,
+			FramePackPtr pack = nullptr, std::size_t readsInFlight = AsyncFileReader::defaultReadsInFlight);
+		~FanOutFrameSource();
+
+		FanOutFrameSource(const FanOutFrameSource&) = delete;
+		FanOutFrameSource& operator=(const FanOutFrameSource&) = delete;
+
+		FrameSource& consumer(std::size_t index) { return *m_consumers[index]; }
+
+		// The consumer won't request rows anymore, the producer stops feeding it
+		void close(std::size_t index);
+
+	private:
+		class Consumer final : public FrameSource
+		{
+		public:
+			explicit Consumer(FanOutFrameSource& owner) :
+				m_owner{ owner }
+			{}
+
+			DecodedFramePtr acquire(std::size_t row, const CancellationToken& cancellationToken) override;
+
+		private:
+			friend class FanOutFrameSource;
+
+			FanOutFrameSource& m_owner;
+			std::deque<std::pair<std::size_t, DecodedFramePtr>> m_queue;
+			bool m_isClosed = false;
+		};
+
+	private:
+		void produce();
+
+	private:
+		const std::vector<AnimationDescription>& m_data;
+		FramePackPtr m_pack;
+		// the producer starts the reads, so files are in memory by the time a consumer decodes them
+		AsyncFileReader m_reader;
+		CancellationToken m_cancellationToken;
+		std::vector<std::unique_ptr<Consumer>> m_consumers;
+
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_isProduced = false;
+		std::thread m_producer;
+	};
+}
@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <cwctype>
+#include <exception>
+#include <iterator>
+
+#include "frame_sequence.hpp"
+
+namespace
+{
+	// more digits would not fit into the 32 bit frame numbers
+	constexpr std::size_t MAX_DIGITS = 9;
+
+	struct NumberedName
+	{
+		std::wstring_view prefix;
+		std::wstring_view digits;
+		std::wstring_view suffix;
+		std::uint32_t number;
+	};
+
+	bool isDigit(wchar_t symbol)
+	{
+		return symbol >= L'0' && symbol <= L'9';
+	}
+
+	std::wstring_view trim(std::wstring_view text)
+	{
+		while (!text.empty() && std::iswspace(text.front()))
+		{
+			text.remove_prefix(1);
+		}
+		while (!text.empty() && std::iswspace(text.back()))
+		{
+			text.remove_suffix(1);
+		}
+		return text;
+	}
+
+	std::optional<std::uint32_t> toNumber(std::wstring_view digits)
+	{
+		if (digits.empty() || digits.size() > MAX_DIGITS || !std::all_of(digits.begin(), digits.end(), isDigit))
+		{
+			return std::nullopt;
+		}
+
+		std::uint32_t number = 0;
+		for (auto digit : digits)
+		{
+			number = number * 10 + static_cast<std::uint32_t>(digit - L'0');
+		}
+		return number;
+	}
+
+	std::size_t digitCount(std::uint32_t number)
+	{
+		std::size_t count = 1;
+		while (number >= 10)
+		{
+			number /= 10;
+			++count;
+		}
+		return count;
+	}
+
+	// The last group of digits in the file name without its extension
+	std::optional<NumberedName> splitNumber(std::wstring_view path, const std::filesystem::path& file)
+	{
+		const auto filenameStart = path.size() - file.filename().wstring().size();
+		const auto stemEnd = path.size() - file.extension().wstring().size();
+
+		auto digitsEnd = stemEnd;
+		while (digitsEnd > filenameStart && !isDigit(path[digitsEnd - 1]))
+		{
+			--digitsEnd;
+		}
+		auto digitsStart = digitsEnd;
+		while (digitsStart > filenameStart && isDigit(path[digitsStart - 1]))
+		{
+			--digitsStart;
+		}
+
+		auto digits = path.substr(digitsStart, digitsEnd - digitsStart);
+		auto number = toNumber(digits);
+		if (!number)
+		{
+			return std::nullopt;
+		}
+		return NumberedName{ path.substr(0, digitsStart), digits, path.substr(digitsEnd), *number };
+	}
+
+	void appendEscaped(std::wstring& output, std::wstring_view text)
+	{
+		for (auto symbol : text)
+		{
+			output += symbol;
+			if (symbol == L'%')
+			{
+				output += L'%';
+			}
+		}
+	}
+}
+
+namespace SAV
+{
+	FrameSequence::FrameSequence(std::wstring prefix, std::wstring suffix, std::uint32_t padding, std::uint32_t first, std::uint32_t last) :
+		m_prefix{ std::move(prefix) },
+		m_suffix{ std::move(suffix) },
+		m_padding{ (std::max)(padding, 1u) },
+		m_first{ first },
+		m_last{ last }
+	{
+		if (m_first > m_last)
+		{
+			throw std::exception("the sequence has no frames");
+		}
+	}
+
+	std::optional<FrameSequence::Descriptor> FrameSequence::parse(std::wstring_view descriptor)
+	{
+		descriptor = trim(descriptor);
+
+		auto rangeEnd = descriptor.rfind(L']');
+		auto rangeStart = descriptor.rfind(L'[', rangeEnd);
+		if (rangeEnd == std::wstring_view::npos || rangeStart == std::wstring_view::npos)
+		{
+			return std::nullopt;
+		}
+
+		std::chrono::milliseconds duration{ 0 };
+		if (auto tail = trim(descriptor.substr(rangeEnd + 1)); !tail.empty())
+		{
+			if (tail.front() != L'@')
+			{
+				return std::nullopt;
+			}
+			tail = trim(tail.substr(1));
+			if (tail.size() > 2 && tail.substr(tail.size() - 2) == L"ms")
+			{
+				tail.remove_suffix(2);
+			}
+			auto value = toNumber(tail);
+			if (!value)
+			{
+				return std::nullopt;
+			}
+			duration = std::chrono::milliseconds{ *value };
+		}
+
+		auto range = descriptor.substr(rangeStart + 1, rangeEnd - rangeStart - 1);
+		auto dash = range.find(L'-');
+		if (dash == std::wstring_view::npos)
+		{
+			return std::nullopt;
+		}
+		auto first = toNumber(trim(range.substr(0, dash)));
+		auto last = toNumber(trim(range.substr(dash + 1)));
+		if (!first || !last || *first > *last)
+		{
+			return std::nullopt;
+		}
+
+		// exactly one "%d" or "%0<width>d", everything else is literal text
+		auto pattern = trim(descriptor.substr(0, rangeStart));
+		std::wstring prefix;
+		std::wstring suffix;
+		std::optional<std::uint32_t> padding;
+		for (std::size_t index = 0; index < pattern.size(); ++index)
+		{
+			auto& output = padding ? suffix : prefix;
+			if (pattern[index] != L'%')
+			{
+				output += pattern[index];
+				continue;
+			}
+
+			if (index + 1 < pattern.size() && pattern[index + 1] == L'%')
+			{
+				output += L'%';
+				++index;
+				continue;
+			}
+
+			auto end = pattern.find(L'd', index + 1);
+			if (padding || end == std::wstring_view::npos)
+			{
+				return std::nullopt;
+			}
+
+			auto width = pattern.substr(index + 1, end - index - 1);
+			if (width.empty())
+			{
+				padding = 0;
+			}
+			else if (width.front() == L'0' && toNumber(width))
+			{
+				padding = *toNumber(width);
+			}
+			else
+			{
+				return std::nullopt;
+			}
+			index = end;
+		}
+
+		if (!padding)
+		{
+			return std::nullopt;
+		}
+		return Descriptor{ FrameSequence{ std::move(prefix), std::move(suffix), *padding, *first, *last }, duration };
+	}
+
+	std::vector<FrameSequence::Run> FrameSequence::findRuns(const std::vector<std::filesystem::path>& files)
+	{
+		std::vector<std::wstring> paths;
+		paths.reserve(files.size());
+		std::transform(files.begin(), files.end(), std::back_inserter(paths), [](const auto& file) { return file.wstring(); });
+
+		std::vector<Run> runs;
+		std::size_t index = 0;
+		while (index < files.size())
+		{
+			auto start = splitNumber(paths[index], files[index]);
+			auto end = index + 1;
+			auto next = start ? start->number + 1 : 0;
+			while (start && end < files.size())
+			{
+				// the value matches, so the length tells whether the padding does
+				auto name = splitNumber(paths[end], files[end]);
+				if (!name || name->number != next || name->prefix != start->prefix || name->suffix != start->suffix ||
+					name->digits.size() != (std::max)(start->digits.size(), digitCount(next)))
+				{
+					break;
+				}
+				++next;
+				++end;
+			}
+
+			if (end - index >= minRunLength)
+			{
+				runs.push_back(Run{ index, end - index,
+					FrameSequence{ std::wstring{ start->prefix }, std::wstring{ start->suffix }, static_cast<std::uint32_t>(start->digits.size()), start->number, next - 1 } });
+			}
+			else
+			{
+				for (auto single = index; single < end; ++single)
+				{
+					runs.push_back(Run{ single, 1, std::nullopt });
+				}
+			}
+			index = end;
+		}
+		return runs;
+	}
+
+	std::filesystem::path FrameSequence::path(std::uint32_t index) const
+	{
+		auto number = std::to_wstring(m_first + index);
+
+		std::wstring path;
+		path.reserve(m_prefix.size() + (std::max<std::size_t>)(m_padding, number.size()) + m_suffix.size());
+		path += m_prefix;
+		if (number.size() < m_padding)
+		{
+			path.append(m_padding - number.size(), L'0');
+		}
+		path += number;
+		path += m_suffix;
+		return std::filesystem::path{ path };
+	}
+
+	std::wstring FrameSequence::pattern() const
+	{
+		std::wstring pattern;
+		appendEscaped(pattern, m_prefix);
+		pattern += m_padding > 1 ? L"%0" + std::to_wstring(m_padding) + L"d" : L"%d";
+		appendEscaped(pattern, m_suffix);
+		return pattern;
+	}
+
+	std::wstring FrameSequence::descriptor(std::chrono::milliseconds duration) const
+	{
+		return pattern() + L" [" + std::to_wstring(m_first) + L"-" + std::to_wstring(m_last) + L"] @ " + std::to_wstring(duration.count()) + L"ms";
+	}
+
+	FrameSequence FrameSequence::slice(std::uint32_t index, std::uint32_t count) const
+	{
+		return FrameSequence{ m_prefix, m_suffix, m_padding, m_first + index, m_first + index + count - 1 };
+	}
+
+	bool FrameSequence::hasSamePattern(const FrameSequence& other) const
+	{
+		return m_padding == other.m_padding && m_prefix == other.m_prefix && m_suffix == other.m_suffix;
+	}
+
+	bool FrameSequence::extend(const FrameSequence& next)
+	{
+		if (!hasSamePattern(next) || next.m_first != m_last + 1)
+		{
+			return false;
+		}
+
+		m_last = next.m_last;
+		return true;
+	}
+}
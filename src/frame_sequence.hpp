@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace SAV
+{
+	// A run of numbered image files like shot_00001.exr ... shot_50000.exr. Only the pattern and the
+	// range are kept, the path of a frame is formed when it is asked for.
+	// The text form is "shot_%05d.exr [1-50000] @ 41ms", '%' in the file name is written as "%%".
+	class FrameSequence
+	{
+	public:
+		// fewer numbered files in a row are kept as separate images
+		inline static constexpr std::size_t minRunLength = 3;
+
+		struct Descriptor;
+		struct Run;
+
+	public:
+		FrameSequence(std::wstring prefix, std::wstring suffix, std::uint32_t padding, std::uint32_t first, std::uint32_t last);
+
+		// "pattern [first-last]" with an optional " @ <duration>ms", nullopt if it isn't one
+		static std::optional<Descriptor> parse(std::wstring_view descriptor);
+		// Splits the files into numbered runs and single files, their order is kept
+		static std::vector<Run> findRuns(const std::vector<std::filesystem::path>& files);
+
+		std::uint32_t first() const { return m_first; }
+		std::uint32_t last() const { return m_last; }
+		std::uint32_t size() const { return m_last - m_first + 1; }
+
+		std::filesystem::path path(std::uint32_t index) const;
+		std::wstring pattern() const;
+		std::wstring descriptor(std::chrono::milliseconds duration) const;
+
+		// Frames [index, index + count) as a sequence of their own
+		FrameSequence slice(std::uint32_t index, std::uint32_t count) const;
+		// Whether the other sequence uses the same file names
+		bool hasSamePattern(const FrameSequence& other) const;
+
+		// Appends the frames of a sequence which starts right after this one ends
+		bool extend(const FrameSequence& next);
+
+	private:
+		std::wstring m_prefix;
+		std::wstring m_suffix;
+		std::uint32_t m_padding;
+		std::uint32_t m_first;
+		std::uint32_t m_last;
+	};
+
+	struct FrameSequence::Descriptor
+	{
+		FrameSequence sequence;
+		std::chrono::milliseconds duration;
+	};
+
+	// Consecutive files of findRuns(), sequence is set if they form a numbered run
+	struct FrameSequence::Run
+	{
+		std::size_t offset;
+		std::size_t count;
+		std::optional<FrameSequence> sequence;
+	};
+}
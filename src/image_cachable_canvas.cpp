@@ -1,17 +1,34 @@
+#include <iterator>
+#include <string>
+#include <unordered_set>
+
 #include "image_cachable_canvas.hpp"
 
 namespace
 {
 	constexpr const  wchar_t* wndCanvasClsName = L"Simple.Animation.Viewer.Canvas";
+
+	// Change notifications may spell a path differently from the project, file names compare case-insensitively
+	std::wstring comparablePath(const std::filesystem::path& file)
+	{
+		auto path = file.lexically_normal().make_preferred().wstring();
+		while (path.size() > 1 && path.back() == L'\\')
+		{
+			path.pop_back();
+		}
+		::CharUpperBuffW(path.data(), static_cast<DWORD>(path.size()));
+		return path;
+	}
 }
 
 namespace SAV
 {
-	ImageCachableCanvas::ImageCachableCanvas(HWND parent, const RECT& position) :
+	ImageCachableCanvas::ImageCachableCanvas(HWND parent, const RECT& position, std::size_t readsInFlight) :
 		m_handle{ nullptr },
 		m_graphics{ std::nullopt },
 		m_width{position.right - position.left},
-		m_height{position.bottom - position.top}
+		m_height{position.bottom - position.top},
+		m_reader{ readsInFlight }
 	{
 		WNDCLASSEX wndclass;
 		ZeroMemory(&wndclass, sizeof(WNDCLASSEX));
@@ -58,24 +75,98 @@ namespace SAV
 	{
 		if (auto it = m_cache.find(imagePath.wstring()); it != m_cache.end())
 		{
-			return it->second.get();
+			return it->second.bitmap.get();
 		}
 
-		auto [it, result] = m_cache.insert(std::pair(imagePath.wstring(), std::make_unique<Gdiplus::Bitmap>(imagePath.wstring().c_str())));
-		return it->second.get();
+		// a failed decode is cached as well, the watcher reports when the file gets fixed
+		CachedImage image{ nullptr, nullptr };
+		if (auto it = m_prefetched.find(imagePath.wstring()); it != m_prefetched.end())
+		{
+			image.frame = std::move(it->second);
+			m_prefetched.erase(it);
+		}
+		else
+		{
+			image.frame = std::make_unique<DecodedFrame>(imagePath, m_pack);
+		}
+
+		if (image.frame->decode({}))
+		{
+			image.bitmap = image.frame->createBitmap();
+		}
+
+		auto [it, result] = m_cache.insert(std::pair(imagePath.wstring(), std::move(image)));
+		return it->second.bitmap.get();
 	}
 
 	void ImageCachableCanvas::drawImage(const std::filesystem::path& imagePath)
 	{
+		m_currentImage = imagePath;
 		auto* image = getImage(imagePath);
-		m_graphics->DrawImage(image, 0, 0, m_width, m_height);
+		if (image)
+		{
+			m_graphics->DrawImage(image, 0, 0, m_width, m_height);
+		}
+	}
+
+	void ImageCachableCanvas::prefetch(const std::vector<std::filesystem::path>& imagePaths)
+	{
+		std::unordered_map<std::wstring, std::unique_ptr<DecodedFrame>> prefetched;
+		for (const auto& imagePath : imagePaths)
+		{
+			auto key = imagePath.wstring();
+			if (m_cache.count(key) > 0 || prefetched.count(key) > 0)
+			{
+				continue;
+			}
+
+			if (auto it = m_prefetched.find(key); it != m_prefetched.end())
+			{
+				prefetched.emplace(std::move(key), std::move(it->second));
+				continue;
+			}
+
+			auto frame = std::make_unique<DecodedFrame>(imagePath, m_pack);
+			frame->prefetch(m_reader);
+			prefetched.emplace(std::move(key), std::move(frame));
+		}
+		m_prefetched = std::move(prefetched);
+	}
+
+	void ImageCachableCanvas::invalidate(const std::vector<std::filesystem::path>& changedFiles)
+	{
+		std::unordered_set<std::wstring> changed;
+		for (const auto& file : changedFiles)
+		{
+			changed.insert(comparablePath(file));
+		}
+
+		auto isAffected = [&changed](const std::filesystem::path& image)
+		{
+			return changed.count(comparablePath(image)) > 0 || changed.count(comparablePath(image.parent_path())) > 0;
+		};
+
+		// one pass over the cache however large the batch is
+		for (auto it = m_cache.begin(); it != m_cache.end();)
+		{
+			it = isAffected(it->first) ? m_cache.erase(it) : std::next(it);
+		}
+		for (auto it = m_prefetched.begin(); it != m_prefetched.end();)
+		{
+			it = isAffected(it->first) ? m_prefetched.erase(it) : std::next(it);
+		}
+
+		if (m_currentImage && isAffected(*m_currentImage))
+		{
+			drawImage(*m_currentImage);
+		}
 	}
 
-	void ImageCachableCanvas::onResize(const RECT& position)
+	HDWP ImageCachableCanvas::onResize(HDWP positions, const RECT& position)
 	{
-		::SetWindowPos(m_handle, HWND_TOP, position.left, position.top,
+		return ::DeferWindowPos(positions, m_handle, HWND_TOP, position.left, position.top,
 			position.right - position.left,
 			position.bottom - position.top,
-			SWP_NOZORDER);
+			SWP_NOZORDER | SWP_NOACTIVATE);
 	}
 }
\ No newline at end of file
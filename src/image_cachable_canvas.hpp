@@ -2,22 +2,49 @@
 
 #include <filesystem>
 #include <map>
+#include <memory>
 #include <optional>
+#include <unordered_map>
+#include <vector>
 
 #include <Windows.h>
 #include <gdiplus.h>
 #include <gdiplusheaders.h>
 
+#include "frame_pipeline.hpp"
+
 namespace SAV
 {
 	class ImageCachableCanvas
 	{
 	public:
-		ImageCachableCanvas(HWND parent, const RECT& position);
+		ImageCachableCanvas(HWND parent, const RECT& position, std::size_t readsInFlight = AsyncFileReader::defaultReadsInFlight);
 		~ImageCachableCanvas() noexcept;
 
 		void drawImage(const std::filesystem::path& imagePath);
-		void onResize(const RECT& position);
+		// Starts reading the images which will be drawn soon, prefetched images not listed anymore are dropped
+		void prefetch(const std::vector<std::filesystem::path>& imagePaths);
+		// Adds the move to a batch of BeginDeferWindowPos, returns the batch to go on with
+		HDWP onResize(HDWP positions, const RECT& position);
+
+		// Drops the cached images of changed files, a folder stands for every file in it.
+		// The shown image is decoded and drawn again if it is among them.
+		void invalidate(const std::vector<std::filesystem::path>& changedFiles);
+
+		// Images decoded from now on are read from the pack if it holds them
+		void setFramePack(FramePackPtr pack)
+		{
+			m_pack = std::move(pack);
+			m_prefetched.clear();
+		}
+
+	private:
+		struct CachedImage
+		{
+			// the bitmap draws straight from the decoded pixels, so the file stays unlocked
+			std::unique_ptr<DecodedFrame> frame;
+			std::unique_ptr<Gdiplus::Bitmap> bitmap;
+		};
 
 	private:
 		Gdiplus::Bitmap* getImage(const std::filesystem::path& imagePath);
@@ -28,6 +55,10 @@ namespace SAV
 		int m_width;
 		int m_height;
 
-		std::map<std::wstring, std::unique_ptr<Gdiplus::Bitmap>> m_cache;
+		std::map<std::wstring, CachedImage> m_cache;
+		AsyncFileReader m_reader;
+		std::unordered_map<std::wstring, std::unique_ptr<DecodedFrame>> m_prefetched;
+		std::optional<std::filesystem::path> m_currentImage;
+		FramePackPtr m_pack;
 	};
 }
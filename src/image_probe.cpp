@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+#include "image_probe.hpp"
+
+namespace
+{
+	using Bytes = std::vector<std::uint8_t>;
+
+	constexpr std::array<std::uint8_t, 8> PNG_SIGNATURE = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+	constexpr std::size_t SIGNATURE_SIZE = 32;
+	// a JPEG may keep a large EXIF block before the frame header, only segment headers are read though
+	constexpr std::uint32_t MAX_JPEG_SEGMENTS = 256;
+	constexpr std::uint32_t MAX_TIFF_ENTRIES = 1024;
+
+	std::optional<Bytes> readAt(std::istream& input, std::uint64_t offset, std::size_t size)
+	{
+		input.clear();
+		input.seekg(static_cast<std::streamoff>(offset));
+		Bytes data(size);
+		if (!input.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(size)))
+		{
+			return std::nullopt;
+		}
+		return data;
+	}
+
+	std::uint32_t be16(const std::uint8_t* data) { return (data[0] << 8) | data[1]; }
+	std::uint32_t be32(const std::uint8_t* data) { return (std::uint32_t{ data[0] } << 24) | (data[1] << 16) | (data[2] << 8) | data[3]; }
+	std::uint32_t le16(const std::uint8_t* data) { return data[0] | (data[1] << 8); }
+	std::uint32_t le32(const std::uint8_t* data) { return data[0] | (data[1] << 8) | (data[2] << 16) | (std::uint32_t{ data[3] } << 24); }
+
+	std::optional<SAV::ImageInfo> probePng(const Bytes& header)
+	{
+		// the IHDR chunk always comes first
+		if (header.size() < 26 || std::equal(header.begin() + 12, header.begin() + 16, "IHDR") == false)
+		{
+			return std::nullopt;
+		}
+
+		const std::uint32_t bitDepth = header[24];
+		const std::uint32_t colorType = header[25];
+		std::uint32_t channels = 1;
+		switch (colorType)
+		{
+			case 2: channels = 3; break;
+			case 4: channels = 2; break;
+			case 6: channels = 4; break;
+		}
+
+		return SAV::ImageInfo{ SAV::ImageFormat::Png, be32(&header[16]), be32(&header[20]), bitDepth * channels };
+	}
+
+	std::optional<SAV::ImageInfo> probeGif(const Bytes& header)
+	{
+		const std::uint32_t bitsPerPixel = (header[10] & 0x80) ? (header[10] & 0x07) + 1 : 0;
+		return SAV::ImageInfo{ SAV::ImageFormat::Gif, le16(&header[6]), le16(&header[8]), bitsPerPixel };
+	}
+
+	std::optional<SAV::ImageInfo> probeBmp(const Bytes& header)
+	{
+		const auto dibHeaderSize = le32(&header[14]);
+		if (dibHeaderSize == 12)
+		{
+			return SAV::ImageInfo{ SAV::ImageFormat::Bmp, le16(&header[18]), le16(&header[20]), le16(&header[24]) };
+		}
+
+		if (dibHeaderSize < 40)
+		{
+			return std::nullopt;
+		}
+
+		// a negative height marks a top-down bitmap
+		const auto height = static_cast<std::int32_t>(le32(&header[22]));
+		return SAV::ImageInfo{ SAV::ImageFormat::Bmp, le32(&header[18]), static_cast<std::uint32_t>(std::abs(height)), le16(&header[28]) };
+	}
+
+	std::optional<SAV::ImageInfo> probeJpeg(std::istream& input)
+	{
+		std::uint64_t offset = 2;
+		for (std::uint32_t segment = 0; segment < MAX_JPEG_SEGMENTS; ++segment)
+		{
+			auto marker = readAt(input, offset, 4);
+			if (!marker || (*marker)[0] != 0xFF)
+			{
+				return std::nullopt;
+			}
+
+			const std::uint8_t type = (*marker)[1];
+			// fill bytes before a marker
+			if (type == 0xFF)
+			{
+				++offset;
+				continue;
+			}
+
+			const bool isFrameHeader = type >= 0xC0 && type <= 0xCF && type != 0xC4 && type != 0xC8 && type != 0xCC;
+			if (isFrameHeader)
+			{
+				auto frame = readAt(input, offset + 4, 6);
+				if (!frame)
+				{
+					return std::nullopt;
+				}
+				const std::uint32_t components = (*frame)[5];
+				return SAV::ImageInfo{ SAV::ImageFormat::Jpeg, be16(&(*frame)[3]), be16(&(*frame)[1]), (*frame)[0] * components };
+			}
+
+			// start of scan reached without a frame header
+			if (type == 0xDA || type == 0xD9)
+			{
+				return std::nullopt;
+			}
+
+			offset += 2 + be16(&(*marker)[2]);
+		}
+		return std::nullopt;
+	}
+
+	std::optional<SAV::ImageInfo> probeTiff(std::istream& input, const Bytes& header)
+	{
+		const bool isLittleEndian = header[0] == 'I';
+		auto read16 = [isLittleEndian](const std::uint8_t* data) { return isLittleEndian ? le16(data) : be16(data); };
+		auto read32 = [isLittleEndian](const std::uint8_t* data) { return isLittleEndian ? le32(data) : be32(data); };
+
+		const std::uint64_t directoryOffset = read32(&header[4]);
+		auto entryCountData = readAt(input, directoryOffset, 2);
+		if (!entryCountData)
+		{
+			return std::nullopt;
+		}
+
+		const auto entryCount = read16(entryCountData->data());
+		if (entryCount > MAX_TIFF_ENTRIES)
+		{
+			return std::nullopt;
+		}
+
+		auto entries = readAt(input, directoryOffset + 2, static_cast<std::size_t>(entryCount) * 12);
+		if (!entries)
+		{
+			return std::nullopt;
+		}
+
+		SAV::ImageInfo info{ SAV::ImageFormat::Tiff, 0, 0, 0 };
+		std::uint32_t samplesPerPixel = 1;
+		std::uint32_t bitsPerSample = 0;
+		for (std::uint32_t index = 0; index < entryCount; ++index)
+		{
+			const auto* entry = entries->data() + index * 12;
+			const auto tag = read16(entry);
+			const auto type = read16(entry + 2);
+			// SHORT values are left aligned in the value field
+			const auto value = type == 3 ? read16(entry + 8) : read32(entry + 8);
+
+			switch (tag)
+			{
+				case 256: info.width = value; break;
+				case 257: info.height = value; break;
+				case 258: bitsPerSample = value; break;
+				case 277: samplesPerPixel = value; break;
+			}
+		}
+
+		if (info.width == 0 || info.height == 0)
+		{
+			return std::nullopt;
+		}
+		info.bitsPerPixel = bitsPerSample * samplesPerPixel;
+		return info;
+	}
+}
+
+namespace SAV::ImageProbe
+{
+	std::optional<ImageInfo> probe(const std::filesystem::path& file)
+	{
+		std::ifstream input(file, std::ios_base::binary);
+		if (!input)
+		{
+			return std::nullopt;
+		}
+		return probe(input);
+	}
+
+	std::optional<ImageInfo> probe(std::istream& input)
+	{
+		Bytes header(SIGNATURE_SIZE, 0);
+		input.read(reinterpret_cast<char*>(header.data()), static_cast<std::streamsize>(header.size()));
+		header.resize(static_cast<std::size_t>(input.gcount()));
+
+		if (header.size() >= 26 && std::equal(PNG_SIGNATURE.begin(), PNG_SIGNATURE.end(), header.begin()))
+		{
+			return probePng(header);
+		}
+
+		if (header.size() >= 11 && (std::equal(header.begin(), header.begin() + 6, "GIF87a") || std::equal(header.begin(), header.begin() + 6, "GIF89a")))
+		{
+			return probeGif(header);
+		}
+
+		if (header.size() >= 30 && header[0] == 'B' && header[1] == 'M')
+		{
+			return probeBmp(header);
+		}
+
+		if (header.size() >= 3 && header[0] == 0xFF && header[1] == 0xD8 && header[2] == 0xFF)
+		{
+			return probeJpeg(input);
+		}
+
+		if (header.size() >= 8 &&
+			((header[0] == 'I' && header[1] == 'I' && header[2] == 42 && header[3] == 0) ||
+			 (header[0] == 'M' && header[1] == 'M' && header[2] == 0 && header[3] == 42)))
+		{
+			return probeTiff(input, header);
+		}
+
+		return std::nullopt;
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <optional>
+
+namespace SAV
+{
+	enum class ImageFormat : std::uint32_t
+	{
+		Unknown,
+		Png,
+		Jpeg,
+		Bmp,
+		Gif,
+		Tiff
+	};
+
+	struct ImageInfo
+	{
+		ImageFormat format;
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint32_t bitsPerPixel; // 0 if the header doesn't tell
+	};
+
+	// Recognizes the formats GDI+ can decode by their signature and reads the size from the header only,
+	// the pixel data is never touched
+	namespace ImageProbe
+	{
+		std::optional<ImageInfo> probe(const std::filesystem::path& file);
+		std::optional<ImageInfo> probe(std::istream& input);
+	}
+}
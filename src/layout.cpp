@@ -1,16 +1,9 @@
+#include <stdexcept>
+
 #include "layout.hpp"
-#include "utils.hpp"
 
 namespace SAV::Layout
 {
-	ItemDimensions::operator ::RECT() const
-	{
-		return { static_cast<int>(x),
-			static_cast<int>(y),
-			static_cast<int>(x + width),
-			static_cast<int>(y + height) };
-	}
-
 	ItemDimensions ItemDimensions::operator*(const Vector2& ratios) const
 	{
 		ItemDimensions dimensions = { 0 };
@@ -23,6 +16,11 @@ namespace SAV::Layout
 		return dimensions;
 	}
 
+	bool ItemDimensions::operator==(const ItemDimensions& other) const
+	{
+		return x == other.x && y == other.y && width == other.width && height == other.height;
+	}
+
 	ItemMargin ItemMargin::operator*(const Vector2& ratios) const
 	{
 		ItemMargin margins;
@@ -37,94 +35,70 @@ namespace SAV::Layout
 
 	std::optional<ItemDimensions> getDimensions(const BoxLayout& root, const std::string& name)
 	{
-		std::stack<std::reference_wrapper<const std::vector<std::shared_ptr<BoxLayout>>>> stack;
-		if (!root.m_children.empty())
-		{
-			stack.push(std::cref(root.m_children));
-		}
-
-		while (!stack.empty())
+		if (auto it = root.m_index.find(name); it != root.m_index.end())
 		{
-			auto items = stack.top();
-			stack.pop();
-			for (const auto& item : items.get())
-			{
-				if (item->m_name == name)
-				{
-					return item->getDimensions();
-				}
-				if (!item->m_children.empty())
-				{
-					stack.push(std::cref(item->m_children));
-				}
-			}
+			return root.m_items[it->second].scaledDimensions;
 		}
 		return std::nullopt;
 	}
 
 	void BoxLayout::resize(std::uint32_t width, std::uint32_t height)
 	{
-		Vector2 ratios{ static_cast<float>(width) / static_cast<float>(m_dimensions.width),
-						static_cast<float>(height) / static_cast<float>(m_dimensions.height) };
-		resize(ratios);
-	}
+		// every box scales by the same ratios, so either all of them change or none
+		const auto& dimensions = m_items.front().dimensions;
+		Vector2 ratios{ static_cast<float>(width) / static_cast<float>(dimensions.width),
+						static_cast<float>(height) / static_cast<float>(dimensions.height) };
+		if (ratios.x == m_ratios.x && ratios.y == m_ratios.y)
+		{
+			return;
+		}
 
-	void BoxLayout::resize(const Vector2& ratios)
-	{
 		m_ratios = ratios;
-		for (auto& child : m_children)
+		for (auto& item : m_items)
 		{
-			child->resize(ratios);
+			item.scaledDimensions = item.dimensions * m_ratios;
 		}
 	}
 
-	std::optional<ItemDimensions> BoxLayout::calculate(const ItemDimensions& dimensions)
+	std::vector<ItemChange> BoxLayout::findChanges() const
 	{
-		// do nothing
-		return std::optional<ItemDimensions>{dimensions};
-	}
-
-	std::uint32_t BoxLayout::toNumber(const std::string& value, std::uint32_t maxValue) const
-	{
-		if (value.empty())
-		{
-			return 0;
-		}
-
-		auto last = value.size() - 1;
-		if (value[last] == '*')
+		std::vector<ItemChange> changes;
+		for (const auto& [name, id] : m_index)
 		{
-			if (value.size() == 1)
-			{
-				return maxValue;
-			}
-			else
+			const auto& item = m_items[id];
+			if (item.scaledDimensions != item.appliedDimensions)
 			{
-				return 0;
+				changes.push_back({ name, item.scaledDimensions });
 			}
 		}
+		return changes;
+	}
 
-		if (value[last] == '%')
+	void BoxLayout::setApplied(const std::vector<ItemChange>& changes)
+	{
+		for (const auto& change : changes)
 		{
-			if (value.size() == 1)
-			{
-				return 0;
-			}
-			auto stringOfNumber = value.substr(0, last);
-			if (auto percent = ::SAV::Utils::fromString(stringOfNumber); percent)
+			if (auto it = m_index.find(change.name); it != m_index.end())
 			{
-				float result = maxValue / 100.0f * percent.value();
-				return static_cast<std::uint32_t>(result);
+				m_items[it->second].appliedDimensions = change.dimensions;
 			}
-			return 0;
 		}
+	}
 
-		if (auto number = ::SAV::Utils::fromString(value); number)
+	void BoxLayout::addItem(const ItemPlacement& placement)
+	{
+		if (!placement.isPlaced)
 		{
-			return static_cast<std::uint32_t>(*number);
+			throw std::logic_error("The layout doesn't fit in its window");
 		}
 
-		return 0;
+		const auto scaledDimensions = placement.dimensions * m_ratios;
+		m_items.push_back({ std::string(placement.name), placement.parent, placement.dimensions, scaledDimensions, scaledDimensions });
+		// the first box of a name is the one found
+		if (!placement.name.empty())
+		{
+			m_index.emplace(placement.name, m_items.size() - 1);
+		}
 	}
 
 } // namespace SAV::Layout
\ No newline at end of file
@@ -1,22 +1,23 @@
 #pragma once
-#include <Windows.h>
 
-#include <functional>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string>
-#include <stack>
-#include <memory>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include <optional>
-#include <utility>
 
 namespace SAV
 {
 	namespace Layout
 	{
-		enum class LayoutDirectionType : std::uint32_t
+		enum class ItemType : std::uint32_t
 		{
-			Vertical,
-			Horizontal
+			Box,  // its children take all of its room
+			HBox, // its children are placed from left to right
+			VBox  // its children are placed from top to bottom
 		};
 
 		struct Vector2
@@ -32,8 +33,9 @@ namespace SAV
 			std::uint32_t width;
 			std::uint32_t height;
 
-			operator ::RECT() const;
 			ItemDimensions operator*(const Vector2& ratios) const;
+			bool operator==(const ItemDimensions& other) const;
+			bool operator!=(const ItemDimensions& other) const { return !(*this == other); }
 		};
 
 		struct ItemMargin
@@ -46,137 +48,209 @@ namespace SAV
 			ItemMargin operator*(const Vector2& ratios) const;
 		};
 
-		class BoxLayout
+		// A named box which has to be moved to its new dimensions
+		struct ItemChange
 		{
-		public:
-			BoxLayout(const std::string& name, const ItemDimensions& dimensions, const ItemMargin& margins = {0, 0, 0, 0}) :
-				m_name{ name },
-				m_dimensions{ dimensions },
-				m_restWidth{ dimensions.width - (margins.left + margins.right) },
-				m_restHeight{ dimensions.height - (margins.top + margins.bottom) },
-				m_margins{ margins }
-			{}
-
-			virtual ~BoxLayout()
-			{};
-
-			ItemDimensions getDimensions() const { return m_dimensions * m_ratios; };
+			std::string name;
+			ItemDimensions dimensions;
+		};
 
-			template<typename LayoutType>
-			auto addItem(const std::string& name, const ItemMargin& margins = { 0, 0, 0, 0 }) -> std::pair<BoxLayout*, std::shared_ptr<LayoutType>>
+		// The size goes along the direction of a linear parent, a plain box gives its children all of its room
+		struct ItemSize
+		{
+			enum class Unit : std::uint32_t
 			{
-				ItemDimensions dimensions = { m_dimensions.x + m_margins.left, m_dimensions.y + m_margins.top, m_restWidth, m_restHeight };
-				return { this, addItem<LayoutType>(name, dimensions, margins) };
-			}
+				Pixels,
+				Percent, // a part of the room left
+				Rest     // all of the room left
+			};
 
-			void resize(std::uint32_t width, std::uint32_t height);
-			friend std::optional<ItemDimensions> getDimensions(const BoxLayout& root, const std::string& name);
+			std::uint32_t value;
+			Unit unit;
+		};
 
-		protected:
-			template<typename LayoutType>
-			std::shared_ptr<LayoutType> addItem(const std::string& name, const ItemDimensions& dimensions, const ItemMargin& margins)
-			{
-				auto calculatedDim = calculate(dimensions);
-				if (calculatedDim)
-				{
-					auto item = std::make_shared<LayoutType>(name, *calculatedDim, margins);
-					m_children.push_back(item);
-					return item;
-				}
-				return nullptr;
-			}
+		constexpr ItemSize pixels(std::uint32_t value) { return { value, ItemSize::Unit::Pixels }; }
+		constexpr ItemSize percent(std::uint32_t value) { return { value, ItemSize::Unit::Percent }; }
+		constexpr ItemSize rest() { return { 0, ItemSize::Unit::Rest }; }
 
-			void resize(const Vector2& ratios);
-			std::uint32_t toNumber(const std::string& value, std::uint32_t maxValue = 0) const;
+		// A box of a layout, its parent is the root (0) or one of the boxes before it counted from 1
+		struct ItemSpec
+		{
+			std::size_t parent;
+			ItemType type;
+			std::string_view name;
+			ItemSize size = pixels(0);
+			ItemMargin margins = { 0, 0, 0, 0 };
+		};
 
-			virtual std::optional<ItemDimensions> calculate(const ItemDimensions& dimensions);
-		protected:
-			std::string m_name;
-			ItemDimensions m_dimensions;
-			Vector2 m_ratios = { 1.f, 1.f };
-			std::uint32_t m_restWidth;
-			std::uint32_t m_restHeight;
-			ItemMargin m_margins;
-			std::vector<std::shared_ptr<BoxLayout>> m_children = {};
+		// A box laid out at the size the layout was made for
+		struct ItemPlacement
+		{
+			std::string_view name;
+			std::size_t parent;
+			ItemDimensions dimensions;
+			bool isPlaced; // false if its parent had no room left for it
 		};
 
-		template<LayoutDirectionType direction>
-		class LinearBox final : public BoxLayout
+		template <std::size_t N>
+		using LayoutTable = std::array<ItemPlacement, N>;
+
+		// Lays the boxes out one after another like the children of a window, the root comes first in the table.
+		// Meant to be evaluated at compile time, so the window only scales the table.
+		template <std::size_t N>
+		constexpr LayoutTable<N + 1> layOut(std::string_view name, const ItemDimensions& dimensions, const ItemMargin& margins,
+			const std::array<ItemSpec, N>& items)
 		{
-		public:
-			template<typename ... Args>
-			LinearBox(const Args& ... args) :
-				BoxLayout{ args... },
-				m_position{ direction == LayoutDirectionType::Horizontal ? m_margins.left : m_margins.top }
-			{};
-
-			template<typename LayoutType>
-			auto addItem(const std::string& name, std::uint32_t size, const ItemMargin& margins = { 0, 0, 0, 0 }) -> std::pair<decltype(this), std::shared_ptr<LayoutType>>
+			// room left for the children to come
+			struct Room
+			{
+				ItemType type;
+				ItemMargin margins;
+				std::uint32_t position;
+				std::uint32_t restWidth;
+				std::uint32_t restHeight;
+			};
+
+			const auto makeRoom = [](ItemType type, const ItemDimensions& dimensions, const ItemMargin& margins)
+			{
+				return Room{ type, margins,
+					type == ItemType::HBox ? margins.left : margins.top,
+					dimensions.width - (margins.left + margins.right),
+					dimensions.height - (margins.top + margins.bottom) };
+			};
+
+			LayoutTable<N + 1> table{};
+			std::array<Room, N + 1> rooms{};
+			table[0] = { name, 0, dimensions, true };
+			rooms[0] = makeRoom(ItemType::Box, dimensions, margins);
+
+			for (std::size_t i = 0; i < N; ++i)
 			{
-				ItemDimensions dimensions{ 0, 0, 0, 0 };
-				if constexpr (direction == LayoutDirectionType::Horizontal)
+				const auto& item = items[i];
+				auto& placement = table[i + 1];
+				placement = { item.name, item.parent, { 0, 0, 0, 0 }, false };
+				if (item.parent > i || !table[item.parent].isPlaced)
+				{
+					continue;
+				}
+
+				const auto& parent = table[item.parent].dimensions;
+				auto& room = rooms[item.parent];
+				const auto maxSize = room.type == ItemType::HBox ? room.restWidth : room.restHeight;
+				std::uint32_t size = item.size.value;
+				if (item.size.unit == ItemSize::Unit::Percent)
 				{
-					dimensions.width = size;
+					size = static_cast<std::uint32_t>(maxSize / 100.0f * item.size.value);
 				}
-				else
+				else if (item.size.unit == ItemSize::Unit::Rest)
 				{
-					dimensions.height = size;
+					size = maxSize;
 				}
 
-				return { this, BoxLayout::addItem<LayoutType>(name, dimensions, margins) };
+				switch (room.type)
+				{
+					case ItemType::HBox:
+						if (room.restWidth < size)
+						{
+							continue;
+						}
+						placement.dimensions = { parent.x + room.position, parent.y, size, room.restHeight };
+						room.position += size;
+						room.restWidth -= size;
+						break;
+
+					case ItemType::VBox:
+						if (room.restHeight < size)
+						{
+							continue;
+						}
+						placement.dimensions = { parent.x + room.margins.left, parent.y + room.position, room.restWidth, size };
+						room.position += size;
+						room.restHeight -= size;
+						break;
+
+					default:
+						placement.dimensions = { parent.x + room.margins.left, parent.y + room.margins.top, room.restWidth, room.restHeight };
+						break;
+				}
+
+				placement.isPlaced = true;
+				rooms[i + 1] = makeRoom(item.type, placement.dimensions, item.margins);
 			}
 
-			template<typename LayoutType>
-			auto addItem(const std::string& name, const std::string& size, const ItemMargin& margins = { 0, 0, 0, 0 })
+			return table;
+		}
+
+		// Every box was placed and lies within the given size
+		template <std::size_t N>
+		constexpr bool fits(const LayoutTable<N>& table, std::uint32_t width, std::uint32_t height)
+		{
+			for (const auto& item : table)
 			{
-				std::uint32_t sizeValue = 0;
-				if constexpr (direction == LayoutDirectionType::Horizontal)
+				const auto& dimensions = item.dimensions;
+				if (!item.isPlaced || dimensions.width > width || dimensions.height > height ||
+					dimensions.x > width - dimensions.width || dimensions.y > height - dimensions.height)
 				{
-					sizeValue = toNumber(size, m_restWidth);
+					return false;
 				}
-				else
-				{
-					sizeValue = toNumber(size, m_restHeight);
-				}
-				return addItem<LayoutType>(name, sizeValue, margins);
 			}
+			return true;
+		}
 
-		protected:
-			std::optional<ItemDimensions> calculate(const ItemDimensions& dimensions) override
+		template <std::size_t N>
+		constexpr ItemDimensions findDimensions(const LayoutTable<N>& table, std::string_view name)
+		{
+			for (const auto& item : table)
 			{
-				if constexpr (direction == LayoutDirectionType::Horizontal)
+				if (item.name == name)
 				{
-					const auto& width = dimensions.width;
-					if (m_restWidth >= width)
-					{
-						ItemDimensions newDimensions{ m_dimensions.x + m_position, m_dimensions.y, width, m_restHeight };
-						m_position += width;
-						m_restWidth -= width;
-						return std::optional<ItemDimensions>(newDimensions);
-					}
-					return std::nullopt;
+					return item.dimensions;
 				}
-				else if constexpr (direction == LayoutDirectionType::Vertical)
+			}
+			return { 0, 0, 0, 0 };
+		}
+
+		// The boxes of a window, laid out for the size it was made for and scaled along with the window.
+		// The boxes are kept in one array, parents before their children, and found by their names through an index.
+		class BoxLayout
+		{
+		public:
+			template <std::size_t N>
+			explicit BoxLayout(const LayoutTable<N>& table)
+			{
+				m_items.reserve(N);
+				for (const auto& item : table)
 				{
-					const auto& height = dimensions.height;
-					if (m_restHeight >= height)
-					{
-						ItemDimensions newDimensions{ m_dimensions.x + m_margins.left, m_dimensions.y + m_position, m_restWidth, height };
-						m_position += height;
-						m_restHeight -= height;
-						return std::optional<ItemDimensions>(newDimensions);
-					}
-					return std::nullopt;
+					addItem(item);
 				}
-
-				return std::nullopt;
 			}
 
+			// Nothing is computed again if the window kept its size
+			void resize(std::uint32_t width, std::uint32_t height);
+			// The named boxes whose dimensions differ from the applied ones. The layout starts out applied,
+			// the windows are created with the dimensions it was made for.
+			std::vector<ItemChange> findChanges() const;
+			// The windows were moved, the changes aren't found again until the next resize
+			void setApplied(const std::vector<ItemChange>& changes);
+			friend std::optional<ItemDimensions> getDimensions(const BoxLayout& root, const std::string& name);
+
 		private:
-			std::uint32_t m_position = 0;
-		};
+			struct Item
+			{
+				std::string name;
+				std::size_t parent;
+				ItemDimensions dimensions; // at the size the layout was made for
+				ItemDimensions scaledDimensions;
+				ItemDimensions appliedDimensions;
+			};
+
+		private:
+			void addItem(const ItemPlacement& placement);
 
-		using HBoxLayout = LinearBox<LayoutDirectionType::Horizontal>;
-		using VBoxLayout = LinearBox<LayoutDirectionType::Vertical>;
+		private:
+			std::vector<Item> m_items;
+			std::unordered_map<std::string, std::size_t> m_index;
+			Vector2 m_ratios = { 1.f, 1.f };
+		};
 	} // namespace Layout
 } // namespace SAV
@@ -3,23 +3,38 @@
 #include <gdiplusheaders.h>
 #include <CommCtrl.h>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
-#include <charconv>
 #include <vector>
 #include <filesystem>
 #include <future>
+#include <iterator>
+#include <limits>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <string_view>
 
 #include "resource.h"
 
+#include "cancellation_token.hpp"
 #include "dialogs.hpp"
 #include "editable_list_view.hpp"
+#include "folder_scanner.hpp"
+#include "folder_watcher.hpp"
+#include "frame_list_model.hpp"
+#include "frame_model.hpp"
+#include "frame_name_index.hpp"
 #include "image_cachable_canvas.hpp"
 #include "layout.hpp"
+#include "main_window_layout.hpp"
+#include "number_parser.hpp"
 #include "program_data.hpp"
+#include "project_journal.hpp"
+#include "rendition_exporter.hpp"
+#include "thumbnail_cache.hpp"
 #include "time_line.hpp"
 #include "video_file_creator.hpp"
 #include "utils.hpp"
@@ -32,112 +47,570 @@ processorArchitecture='*' publicKeyToken='6595b64144ccf1df' language='*'\"")
 
 namespace
 {
-	constexpr int WINDOW_WIDTH = 1480;
-	constexpr int WINDOW_HEIGHT = 768;
+	using SAV::MainWindowLayout::WINDOW_WIDTH;
+	using SAV::MainWindowLayout::WINDOW_HEIGHT;
 
 	constexpr std::uint64_t IDC_TIMER_EDIT = 0x2;
 	constexpr std::uint64_t IDC_LOOP_BOX = 0x3;
 	constexpr std::uint64_t IDC_PLAY = 0x5;
+	constexpr std::uint64_t IDC_FILTER_EDIT = 0x6;
 
 	constexpr std::wstring_view APP_STATE_PROP = L"AppState";
 	constexpr std::uint32_t WM_CONVERSION_FINISHED = WM_USER + 1;
+	constexpr std::uint32_t WM_CONVERSION_PROGRESS = WM_USER + 2;
+	constexpr std::uint32_t WM_FOLDER_SCANNED = WM_USER + 3;
+	constexpr std::uint32_t WM_FILES_CHANGED = WM_USER + 4;
+	constexpr std::uint32_t WM_FRAMES_CHANGED = WM_USER + 5;
+	constexpr std::uint32_t WM_THUMBNAILS_READY = WM_USER + 6;
+	constexpr std::uint32_t WM_METADATA_READY = WM_USER + 7;
+	constexpr std::uint32_t WM_JOURNAL_FAILED = WM_USER + 8;
 
 	constexpr std::wstring_view DEFAULT_VIDEO_WIDTH_TXT_VALUE = L"1920";
 	constexpr std::wstring_view DEFAULT_VIDEO_HEIGHT_TXT_VALUE = L"1080";
 	constexpr std::wstring_view DEFAULT_VIDEO_BITRATE_TXT_VALUE = L"8000";
 	constexpr std::wstring_view DEFAULT_VIDEO_FILENAME_VALUE = L"output.mp4";
 
-	constexpr std::string_view LAYOUT_ROOT_NAME = "Root";
-	constexpr std::string_view LAYOUT_IMAGE_CANVAS_NAME = "ImageCanvas";
-	constexpr std::string_view LAYOUT_TIME_LINE_NAME = "TimeLine";
-	constexpr std::string_view LAYOUT_PLAY_BUTTON_NAME = "PlayButton";
+	using SAV::MainWindowLayout::LAYOUT_IMAGE_CANVAS_NAME;
+	using SAV::MainWindowLayout::LAYOUT_FILTER_BOX_NAME;
+	using SAV::MainWindowLayout::LAYOUT_TIME_LINE_NAME;
+	using SAV::MainWindowLayout::LAYOUT_PLAY_BUTTON_NAME;
+
+	// The layout knows nothing of Win32, its boxes become window rectangles here
+	::RECT toRect(const SAV::Layout::ItemDimensions& dimensions)
+	{
+		return { static_cast<LONG>(dimensions.x),
+			static_cast<LONG>(dimensions.y),
+			static_cast<LONG>(dimensions.x + dimensions.width),
+			static_cast<LONG>(dimensions.y + dimensions.height) };
+	}
 
 	struct VideoConversionOptions
 	{
-		std::uint32_t width;
-		std::uint32_t height;
-		SAV::Bitrate bitrate;
-		std::wstring filename;
+		std::vector<SAV::Rendition> renditions;
+		// collected on the window thread, the worker must not touch the list or the path pool
+		std::vector<SAV::AnimationDescription> frames;
+		SAV::FramePackPtr pack;
 	};
 
 	struct ApplicationState
 	{
 		SAV::AnimationData animationData;
+		// the only copy of the frames, the list, the timeline and the journal follow its changes
+		SAV::FrameModel frameModel;
+		SAV::FrameListModel frameList{ frameModel, animationData };
+		// names of every frame seen since the start, the filter box searches them
+		SAV::FrameNameIndex nameIndex;
+		std::uint64_t filterVersion = 0;
+		// the frame model version the index knows the frame positions of
+		std::optional<std::uint64_t> nameIndexVersion;
+		std::optional<std::filesystem::path> projectFile;
+		// set while autosave is on, the edits of the list go there
+		std::optional<SAV::ProjectJournal> journal;
+		// the first failure of the journal turns autosave off, the later ones are dropped
+		std::atomic<bool> isJournalFailurePosted = false;
 		bool isExit = false;
-		std::mutex vfc_mutex;
-		std::unique_ptr<SAV::VideoFileCreator> vfc;
+		SAV::CancellationSource exportCancellation;
 		std::optional<std::future<HRESULT>> conversionTask; 
+		std::mutex progressMutex;
+		SAV::ExportProgress exportProgress;
+		std::atomic<bool> isProgressPosted = false;
 		std::optional<SAV::Layout::BoxLayout> layout;
 
+		// images probed by the folder scanner wait here until the window thread takes them
+		SAV::CancellationSource scanCancellation;
+		std::optional<SAV::FolderScanner> folderScanner;
+		std::uint32_t scanGeneration = 0;
+		std::mutex scanMutex;
+		std::vector<SAV::ScannedImage> scannedImages;
+		std::atomic<bool> isScanPosted = false;
+
+		// changes reported by the watcher of the image folders, same hand-over as above
+		std::optional<SAV::FolderWatcher> folderWatcher;
+		std::vector<std::filesystem::path> watchedFolders;
+		std::mutex changesMutex;
+		std::vector<std::filesystem::path> changedFiles;
+		std::atomic<bool> isChangePosted = false;
+
+		// a bulk edit reports many changes, the timeline and the journal compaction look at the
+		// frames once all of them were handled
+		bool isFramesChangePosted = false;
+
+		// thumbnails of the visible rows are made in the background, same hand-over as above
+		std::optional<SAV::ThumbnailCache> thumbnails;
+		std::atomic<bool> isThumbnailsPosted = false;
+		// the metadata of the project frames is read in the background after a load or a save
+		std::atomic<bool> isMetadataPosted = false;
+
 		struct
 		{
 			HWND appHandle = nullptr;
 			HWND playButton = nullptr;
 			HWND loopBox = nullptr;
 			HWND timerEdit = nullptr;
+			HWND filterEdit = nullptr;
 			std::optional<SAV::EditableListView> nfileList;
 			std::optional<SAV::ImageCachableCanvas> imageCanvas;
 			std::optional<SAV::TimeLine> timeline;
 		} appHandles;
 	};
 
-	std::optional<std::chrono::milliseconds> msFromWstring(const std::wstring& data)
+	// The list only asks the model for the rows it paints
+	void updateFileListView(const SAV::FrameModel::Change& change, ApplicationState& appState)
 	{
-		auto ms = SAV::Utils::fromString(data);
-		if (ms)
+		auto& listView = *appState.appHandles.nfileList;
+		switch (change.type)
 		{
-			return std::optional<std::chrono::milliseconds>(ms);
+			case SAV::FrameModel::Change::Type::Update:
+			case SAV::FrameModel::Change::Type::Replace:
+				listView.redrawRows(static_cast<int>(change.first), static_cast<int>(change.first + change.count - 1));
+				break;
+
+			case SAV::FrameModel::Change::Type::Move:
+				listView.redrawRows(static_cast<int>((std::min)(change.first, change.target)), static_cast<int>((std::max)(change.first, change.target)));
+				break;
+
+			default:
+				listView.refresh();
+				break;
 		}
-		return std::nullopt;
 	}
 
-	bool updateFileListView(SAV::AnimationData::Animations&& animations, SAV::EditableListView& listView)
+	void indexFrameNames(const SAV::FrameModel::Change& change, ApplicationState& appState)
 	{
-		std::vector<std::vector<std::wstring>> listViewData;
+		if (change.type != SAV::FrameModel::Change::Type::Reset && change.type != SAV::FrameModel::Change::Type::Insert)
+		{
+			return;
+		}
 
-		for (auto&& animation : animations)
+		const auto first = change.type == SAV::FrameModel::Change::Type::Reset ? 0 : change.first;
+		const auto last = change.type == SAV::FrameModel::Change::Type::Reset ? appState.frameModel.size() : change.first + change.count;
+		for (auto index = first; index < last; ++index)
 		{
-			auto duration = std::to_wstring(animation.duration().count());
-			listViewData.push_back({ animation.name(), std::move(duration) });
+			auto handle = appState.frameModel[index].handle;
+			if (!appState.nameIndex.contains(handle))
+			{
+				appState.nameIndex.add(handle, appState.animationData.getName(handle));
+			}
 		}
-		listView.updateData(listViewData);
+	}
 
-		return true;
+	// The list shows the frames whose names hold the text of the filter box, all of them if it is empty
+	void applyFilter(ApplicationState& appState)
+	{
+		std::wstring text(::GetWindowTextLength(appState.appHandles.filterEdit) + 1, L'\0');
+		text.resize(::GetWindowText(appState.appHandles.filterEdit, text.data(), static_cast<int>(text.size())));
+
+		appState.filterVersion = appState.frameModel.version();
+		if (text.empty())
+		{
+			if (!appState.frameList.isFiltered())
+			{
+				return;
+			}
+			appState.frameList.clearFilter();
+		}
+		else
+		{
+			// the positions change once per edit, every key typed then only searches the index
+			if (appState.nameIndexVersion != appState.filterVersion)
+			{
+				const auto& frames = appState.frameModel.frames();
+				std::vector<SAV::FrameNameIndex::FrameHandle> handles;
+				handles.reserve(frames.size());
+				std::transform(frames.begin(), frames.end(), std::back_inserter(handles), [](const auto& frame) { return frame.handle; });
+				appState.nameIndex.setFrames(handles);
+				appState.nameIndexVersion = appState.filterVersion;
+			}
+			appState.frameList.setFilter(appState.nameIndex.find(text));
+		}
+		appState.appHandles.nfileList->refresh();
 	}
 
-	HRESULT doVideoConversion(const VideoConversionOptions& options, ApplicationState* appState, HWND dlg)
+	// A filtered list maps its rows to other frames after an edit, it is filtered again once per edit
+	void updateFilteredList(ApplicationState& appState)
 	{
-		auto data = appState->appHandles.nfileList->getListViewData();
-		std::vector<SAV::AnimationDescription> videoData;
-		for (const auto& row : data)
+		if (appState.filterVersion != appState.frameModel.version())
 		{
-			auto filepath = appState->animationData.getAnimationFilePath(row[0]);
-			if (filepath)
+			applyFilter(appState);
+		}
+	}
+
+	// Shows the frame in the whole list and plays on from it
+	void jumpToFrame(std::size_t index, ApplicationState& appState)
+	{
+		::SetWindowText(appState.appHandles.filterEdit, L"");
+		applyFilter(appState);
+		appState.appHandles.nfileList->selectRow(static_cast<int>(index));
+
+		if (appState.appHandles.timeline->isPlaying())
+		{
+			appState.appHandles.timeline->seek(index);
+		}
+	}
+
+	void addTimeLineFrames(ApplicationState& appState)
+	{
+		for (const auto& frame : appState.frameModel.frames())
+		{
+			appState.appHandles.timeline->add(static_cast<SAV::TimeLine::FrameId>(frame.handle), frame.duration);
+		}
+	}
+
+	void postFramesChanged(ApplicationState& appState)
+	{
+		if (!appState.isFramesChangePosted)
+		{
+			appState.isFramesChangePosted = true;
+			PostMessage(appState.appHandles.appHandle, WM_FRAMES_CHANGED, 0, 0);
+		}
+	}
+
+	// A playing timeline takes the edited frames and goes on at the same position
+	void updateTimeLine(ApplicationState& appState)
+	{
+		auto& timeline = *appState.appHandles.timeline;
+		if (!timeline.isPlaying())
+		{
+			return;
+		}
+
+		auto position = timeline.position();
+		timeline.clear();
+		addTimeLineFrames(appState);
+		timeline.seek(position);
+	}
+
+	void processFramesChanged(ApplicationState& appState)
+	{
+		appState.isFramesChangePosted = false;
+		updateTimeLine(appState);
+
+		// the rows of a compaction must hold every edit in the journal, so not in the middle of one
+		if (appState.journal && appState.journal->needsCompaction())
+		{
+			appState.journal->compact(appState.animationData.toProjectRows(appState.frameModel.frames()));
+		}
+	}
+
+	void journalFrameChange(const SAV::FrameModel::Change& change, ApplicationState& appState)
+	{
+		// a load replaces the frames, its journal is opened afterwards
+		if (!appState.journal || change.type == SAV::FrameModel::Change::Type::Reset)
+		{
+			return;
+		}
+
+		auto append = [&appState](SAV::JournalOp::Type type, std::size_t index, std::size_t target = 0)
+		{
+			SAV::JournalOp op{ type, static_cast<std::uint32_t>(index), static_cast<std::uint32_t>(target), std::chrono::milliseconds{ 0 }, {} };
+			if (type == SAV::JournalOp::Type::Insert || type == SAV::JournalOp::Type::SetDuration)
+			{
+				const auto& frame = appState.frameModel[index];
+				op.duration = frame.duration;
+				if (type == SAV::JournalOp::Type::Insert)
+				{
+					op.path = appState.animationData.getAnimationFilePath(frame.handle).wstring();
+				}
+			}
+			appState.journal->append(op);
+		};
+
+		const auto last = change.first + change.count;
+		switch (change.type)
+		{
+			case SAV::FrameModel::Change::Type::Insert:
+				for (auto index = change.first; index < last; ++index)
+				{
+					append(SAV::JournalOp::Type::Insert, index);
+				}
+				break;
+
+			case SAV::FrameModel::Change::Type::Remove:
+				// the frames behind move up, so every remove takes the same index
+				for (auto index = change.first; index < last; ++index)
+				{
+					append(SAV::JournalOp::Type::Remove, change.first);
+				}
+				break;
+
+			case SAV::FrameModel::Change::Type::Move:
+				append(SAV::JournalOp::Type::Move, change.first, change.target);
+				break;
+
+			case SAV::FrameModel::Change::Type::Update:
+				for (auto index = change.first; index < last; ++index)
+				{
+					append(SAV::JournalOp::Type::SetDuration, index);
+				}
+				break;
+
+			case SAV::FrameModel::Change::Type::Replace:
+				// the journal knows no replace, the old frames are removed and the new ones inserted
+				for (auto index = change.first; index < last; ++index)
+				{
+					append(SAV::JournalOp::Type::Remove, change.first);
+				}
+				for (auto index = change.first; index < last; ++index)
+				{
+					append(SAV::JournalOp::Type::Insert, index);
+				}
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	// The project is written in full once, afterwards only the edits are appended to its journal
+	// Autosave stays off if the journal can't be opened
+	void openJournal(const std::filesystem::path& project, ApplicationState& appState)
+	{
+		auto hwnd = appState.appHandles.appHandle;
+		auto* state = &appState;
+		appState.isJournalFailurePosted = false;
+		try
+		{
+			appState.journal.emplace(project,
+				[state, hwnd](SAV::ProjectJournal::Error error)
+				{
+					if (!state->isJournalFailurePosted.exchange(true))
+					{
+						PostMessage(hwnd, WM_JOURNAL_FAILED, static_cast<WPARAM>(error), 0);
+					}
+				});
+		}
+		catch (const std::exception&)
+		{
+			appState.journal.reset();
+			::MessageBox(hwnd, L"Autosave can't be started, the journal next to the project can't be written.",
+				L"Autosave", MB_OK | MB_ICONERROR);
+		}
+		::CheckMenuItem(::GetMenu(hwnd), ID_PROGRAMM_AUTOSAVE, appState.journal ? MF_CHECKED : MF_UNCHECKED);
+	}
+
+	void processJournalFailed(WPARAM wp, ApplicationState& appState)
+	{
+		if (!appState.journal)
+		{
+			return;
+		}
+
+		// the journal is left on the disk as it is, unlike stopAutosave() the project isn't written over here
+		appState.journal.reset();
+		::CheckMenuItem(::GetMenu(appState.appHandles.appHandle), ID_PROGRAMM_AUTOSAVE, MF_UNCHECKED);
+
+		const wchar_t* reason = L"The edits could not be written to the journal.";
+		switch (static_cast<SAV::ProjectJournal::Error>(wp))
+		{
+			case SAV::ProjectJournal::Error::Compaction:
+				reason = L"The compacted project could not be written.";
+				break;
+
+			case SAV::ProjectJournal::Error::Replace:
+				reason = L"The compacted project could not replace the project file.";
+				break;
+
+			default:
+				break;
+		}
+
+		std::wstring message = reason;
+		message += L"\nAutosave is turned off, save the project to keep your changes.";
+		::MessageBox(appState.appHandles.appHandle, message.c_str(), L"Autosave", MB_OK | MB_ICONERROR);
+	}
+
+	// The thumbnails are kept next to the project, so it opens with them
+	void saveThumbnails(ApplicationState& appState)
+	{
+		if (appState.projectFile && appState.thumbnails->isModified())
+		{
+			appState.thumbnails->save(SAV::ThumbnailFile::sidecarPath(*appState.projectFile));
+		}
+	}
+
+	void startAutosave(ApplicationState& appState)
+	{
+		if (!appState.projectFile)
+		{
+			auto filepath = SAV::saveFileDialog(SAV::program_save_data);
+			if (!filepath)
 			{
-				videoData.push_back(SAV::AnimationDescription{ filepath->wstring(), row[1] });
+				return;
 			}
+			appState.projectFile = *filepath;
 		}
 
-		auto progressHWND = GetDlgItem(dlg, IDC_CREATION_PROGRESS);
-		SendMessage(progressHWND, PBM_SETRANGE, 0, MAKELPARAM(0, videoData.size()));
-		SendMessage(progressHWND, PBM_SETSTEP, (WPARAM)1, 0);
-		
-		std::unique_lock vfcLock(appState->vfc_mutex, std::defer_lock);
-		vfcLock.lock();
-		appState->vfc = std::make_unique<SAV::VideoFileCreator>(options.filename, options.width, options.height, options.bitrate);
-		vfcLock.unlock();
+		appState.journal.reset();
+		appState.animationData.saveToFile(*appState.projectFile, appState.frameModel.frames());
+		openJournal(*appState.projectFile, appState);
+		saveThumbnails(appState);
+	}
+
+	void processThumbnailsReady(ApplicationState& appState)
+	{
+		appState.isThumbnailsPosted = false;
+		if (appState.thumbnails->collect() > 0)
+		{
+			appState.appHandles.nfileList->refresh();
+		}
+	}
+
+	void processMetadataReady(ApplicationState& appState)
+	{
+		appState.isMetadataPosted = false;
+		appState.animationData.collectMetadata();
+	}
+
+	void stopAutosave(ApplicationState& appState)
+	{
+		if (!appState.journal)
+		{
+			return;
+		}
+
+		// the project takes the edits in, so the journal isn't needed anymore
+		appState.journal.reset();
+		appState.animationData.saveToFile(*appState.projectFile, appState.frameModel.frames());
+		SAV::ProjectJournalFile::remove(*appState.projectFile);
+	}
+
+	void updateWatchedFolders(ApplicationState& appState)
+	{
+		auto folders = appState.animationData.getFolders();
+		if (folders == appState.watchedFolders)
+		{
+			return;
+		}
+
+		if (!appState.folderWatcher)
+		{
+			auto hwnd = appState.appHandles.appHandle;
+			auto* state = &appState;
+			appState.folderWatcher.emplace(
+				[state, hwnd](std::vector<std::filesystem::path>&& files)
+				{
+					{
+						std::lock_guard guard(state->changesMutex);
+						std::move(files.begin(), files.end(), std::back_inserter(state->changedFiles));
+					}
+
+					if (!state->isChangePosted.exchange(true))
+					{
+						PostMessage(hwnd, WM_FILES_CHANGED, 0, 0);
+					}
+				});
+		}
+
+		appState.folderWatcher->watch(folders);
+		appState.watchedFolders = std::move(folders);
+	}
+
+	void processFilesChanged(ApplicationState& appState)
+	{
+		std::vector<std::filesystem::path> files;
+		{
+			std::lock_guard guard(appState.changesMutex);
+			appState.isChangePosted = false;
+			files.swap(appState.changedFiles);
+		}
+
+		// the pack holds the old bytes of a changed frame, it is not used until it is built again
+		if (auto pack = appState.animationData.getFramePack(); pack &&
+			std::any_of(files.begin(), files.end(),
+				[&pack](const auto& file) { return pack->findEntry(file.wstring()) || std::filesystem::is_directory(file); }))
+		{
+			appState.animationData.dropFramePack();
+			appState.appHandles.imageCanvas->setFramePack(nullptr);
+			appState.thumbnails->setFramePack(nullptr);
+		}
+
+		appState.appHandles.imageCanvas->invalidate(files);
+		appState.thumbnails->invalidate(files);
+	}
+
+	void stopFolderScan(ApplicationState& appState)
+	{
+		appState.scanCancellation.cancel();
+		appState.folderScanner.reset();
+
+		std::lock_guard guard(appState.scanMutex);
+		appState.scannedImages.clear();
+	}
 
-		auto result = appState->vfc->write(videoData,
-								[progressHWND]()
+	void startFolderScan(const std::filesystem::path& folder, bool isRecursive, ApplicationState& appState)
+	{
+		stopFolderScan(appState);
+
+		appState.scanCancellation = SAV::CancellationSource{};
+		auto generation = ++appState.scanGeneration;
+		auto hwnd = appState.appHandles.appHandle;
+		auto* state = &appState;
+		appState.folderScanner.emplace(folder, isRecursive, appState.scanCancellation.token(),
+			[state, hwnd](std::vector<SAV::ScannedImage>&& images)
+			{
+				{
+					std::lock_guard guard(state->scanMutex);
+					std::move(images.begin(), images.end(), std::back_inserter(state->scannedImages));
+				}
+
+				// the window takes everything collected so far, one pending message is enough
+				if (!state->isScanPosted.exchange(true))
+				{
+					PostMessage(hwnd, WM_FOLDER_SCANNED, 0, 0);
+				}
+			},
+			[hwnd, generation]()
+			{
+				PostMessage(hwnd, WM_FOLDER_SCANNED, 1, generation);
+			});
+	}
+
+	void processFolderScanned(WPARAM wp, LPARAM lp, ApplicationState& appState)
+	{
+		std::vector<SAV::ScannedImage> images;
+		{
+			std::lock_guard guard(appState.scanMutex);
+			appState.isScanPosted = false;
+			images.swap(appState.scannedImages);
+		}
+
+		if (!images.empty())
+		{
+			appState.frameModel.append(appState.animationData.addScannedImages(std::move(images)));
+			updateWatchedFolders(appState);
+		}
+
+		// the scanner is done, a message from an older scan must not stop the current one
+		if (wp == 1 && static_cast<std::uint32_t>(lp) == appState.scanGeneration)
+		{
+			appState.folderScanner.reset();
+		}
+	}
+
+	HRESULT doVideoConversion(const VideoConversionOptions& options, SAV::CancellationToken cancellationToken, ApplicationState* appState, HWND dlg)
+	{
+		appState->isProgressPosted = false;
+
+		SAV::RenditionExporter exporter{ options.renditions, options.pack };
+		auto result = exporter.write(options.frames, cancellationToken,
+								[appState, dlg](const SAV::ExportProgress& progress)
 								{
-									PostMessage(progressHWND, PBM_STEPIT, 0, 0);
+									{
+										std::lock_guard guard(appState->progressMutex);
+										appState->exportProgress = progress;
+									}
+
+									// the dialog always reads the latest report, so one pending message is enough
+									if (!appState->isProgressPosted.exchange(true))
+									{
+										PostMessage(dlg, WM_CONVERSION_PROGRESS, 0, 0);
+									}
 								});
 
-		vfcLock.lock();
-		appState->vfc.reset();
-		vfcLock.unlock();
-
-		::Sleep(1000);
+		if (!cancellationToken.isCanceled())
+		{
+			::Sleep(1000);
+		}
 		PostMessage(dlg, WM_CONVERSION_FINISHED, 0, 0);
 
 		return result;
@@ -156,7 +629,7 @@ namespace
 
 		if constexpr (std::is_integral_v<T>)
 		{
-			if (auto value = SAV::Utils::fromString<std::wstring>(buffer.data()); value)
+			if (auto value = SAV::NumberParser::parseNumber(buffer.data(), (std::numeric_limits<T>::max)()); value)
 			{
 				return std::optional{ static_cast<T>(*value) };
 			}
@@ -169,18 +642,77 @@ namespace
 		return std::nullopt;
 	}
 
+	// "1280x720@4000;3840x2160@35000" - size and bitrate in kbps of every additional rendition,
+	// each one is written next to the main file with its height as a suffix, e.g. output_720p.mp4.
+	// On failure invalidItem is the rendition which can't be read.
+	std::optional<std::vector<SAV::Rendition>> parseExtraRenditions(std::wstring_view text, const std::filesystem::path& filename,
+		std::wstring_view& invalidItem)
+	{
+		std::vector<SAV::Rendition> renditions;
+		while (!text.empty())
+		{
+			auto end = text.find(L';');
+			auto item = text.substr(0, end);
+			text = end == std::wstring_view::npos ? std::wstring_view{} : text.substr(end + 1);
+			if (item.empty())
+			{
+				continue;
+			}
+
+			auto sizeDelim = item.find(L'x');
+			auto bitrateDelim = item.find(L'@');
+			if (sizeDelim == std::wstring_view::npos || bitrateDelim == std::wstring_view::npos || bitrateDelim < sizeDelim)
+			{
+				invalidItem = item;
+				return std::nullopt;
+			}
+
+			constexpr std::uint64_t maxValue = (std::numeric_limits<std::uint32_t>::max)();
+			auto width = SAV::NumberParser::parseNumber(item.substr(0, sizeDelim), maxValue);
+			auto height = SAV::NumberParser::parseNumber(item.substr(sizeDelim + 1, bitrateDelim - sizeDelim - 1), maxValue);
+			auto bitrate = SAV::NumberParser::parseNumber(item.substr(bitrateDelim + 1), maxValue);
+			if (!width || !height || !bitrate)
+			{
+				invalidItem = item;
+				return std::nullopt;
+			}
+
+			auto renditionFilename = filename.parent_path() /
+				(filename.stem().wstring() + L"_" + std::to_wstring(*height) + L"p" + filename.extension().wstring());
+			renditions.push_back(SAV::Rendition{ renditionFilename.wstring(), static_cast<std::uint32_t>(*width), static_cast<std::uint32_t>(*height),
+											   SAV::Bitrate{ static_cast<std::uint32_t>(*bitrate), SAV::Bitrate::KBPS() } });
+		}
+		return renditions;
+	}
+
 	void makeVideo(HWND dlgHWND, ApplicationState& appState)
 	{
 		auto width = getValueFromDlgItem<std::uint32_t>(dlgHWND, IDC_W_EDIT);
 		auto height = getValueFromDlgItem<std::uint32_t>(dlgHWND, IDC_H_EDIT);
 		auto bitrate = getValueFromDlgItem<std::uint32_t>(dlgHWND, IDC_BITRATE_EDIT);
 		auto filename = getValueFromDlgItem<std::wstring>(dlgHWND, IDC_FILE_NAME_EDIT);
+		auto extraRenditions = getValueFromDlgItem<std::wstring>(dlgHWND, IDC_RENDITIONS_EDIT);
 
 		if (width && height && bitrate && filename && !filename->empty())
 		{
+			const std::wstring extraText = extraRenditions ? *extraRenditions : std::wstring{};
+			std::wstring_view invalidItem;
+			auto renditions = parseExtraRenditions(extraText, *filename, invalidItem);
+			if (!renditions)
+			{
+				std::wstring message = L"Can't read the extra size \"";
+				message.append(invalidItem);
+				message += L"\", expected <width>x<height>@<bitrate in kbps>, e.g. 1280x720@4000.";
+				::MessageBox(dlgHWND, message.c_str(), L"Save video", MB_OK | MB_ICONERROR);
+				return;
+			}
+			renditions->insert(renditions->begin(), SAV::Rendition{ *filename, *width, *height, SAV::Bitrate{*bitrate, SAV::Bitrate::KBPS()} });
+
+			appState.exportCancellation = SAV::CancellationSource{};
 			appState.conversionTask.emplace( std::async( std::launch::async, doVideoConversion,
-				VideoConversionOptions{ *width, *height, SAV::Bitrate{*bitrate, SAV::Bitrate::KBPS()}, *filename },
-				&appState, dlgHWND ) );
+				VideoConversionOptions{ std::move(*renditions), appState.animationData.toAnimations(appState.frameModel.frames()),
+					appState.animationData.getFramePack() },
+				appState.exportCancellation.token(), &appState, dlgHWND ) );
 		}
 	}
 
@@ -188,11 +720,7 @@ namespace
 	{
 		if (appState.conversionTask)
 		{
-			std::lock_guard guard(appState.vfc_mutex);
-			if (appState.vfc)
-			{
-				appState.vfc->cancel();
-			}
+			appState.exportCancellation.cancel();
 		}
 		else
 		{
@@ -251,6 +779,32 @@ namespace
 		return false;
 	}
 
+	void updateVideoCreationProgress(HWND dlgHwnd, ApplicationState& appState)
+	{
+		appState.isProgressPosted = false;
+
+		SAV::ExportProgress progress;
+		{
+			std::lock_guard guard(appState.progressMutex);
+			progress = appState.exportProgress;
+		}
+
+		auto progressHWND = GetDlgItem(dlgHwnd, IDC_CREATION_PROGRESS);
+		SendMessage(progressHWND, PBM_SETRANGE32, 0, static_cast<LPARAM>(progress.totalFrames));
+		SendMessage(progressHWND, PBM_SETPOS, static_cast<WPARAM>(progress.framesWritten), 0);
+
+		std::array<wchar_t, 64> totalTime = { 0 };
+		swprintf_s(totalTime.data(), totalTime.size(), L"%.1f / %.1f s",
+			progress.encodedTime.count(), progress.totalTime.count());
+		SetDlgItemText(dlgHwnd, IDC_TOTAL_TIME, totalTime.data());
+
+		std::array<wchar_t, 128> stats = { 0 };
+		swprintf_s(stats.data(), stats.size(), L"%llu/%llu frames, %.1f fps, ETA %.0f s\ndecode %.1f s, scale %.1f s, encode %.1f s",
+			progress.framesWritten, progress.totalFrames, progress.framesPerSecond, progress.eta.count(),
+			progress.decodeTime.count(), progress.scaleTime.count(), progress.encodeTime.count());
+		SetDlgItemText(dlgHwnd, IDC_EXPORT_STATS, stats.data());
+	}
+
 	void finishVideoCreationDialog(HWND dlgHwnd, ApplicationState& appState)
 	{
 		if (appState.conversionTask)
@@ -284,6 +838,10 @@ namespace
 			}
 			return TRUE;
 
+			case WM_CONVERSION_PROGRESS:
+				updateVideoCreationProgress(hwnd, *appState);
+				return TRUE;
+
 			case WM_CONVERSION_FINISHED:
 				finishVideoCreationDialog(hwnd, *appState);
 				return TRUE;
@@ -297,18 +855,7 @@ namespace
 	bool processPlayButton(ApplicationState& appState)
 	{
 		appState.appHandles.timeline->reset();
-		auto data = appState.appHandles.nfileList->getListViewData();
-		for (const auto& row : data)
-		{
-			const auto& name = row[0];
-			const auto& timerString = row[1];
-
-			auto value = msFromWstring(timerString);
-			if (value)
-			{
-				appState.appHandles.timeline->add(name, *value);
-			}
-		}
+		addTimeLineFrames(appState);
 
 		bool isLooped = SendMessage(appState.appHandles.loopBox, BM_GETCHECK, 0, 0) == BST_CHECKED;
 
@@ -330,8 +877,26 @@ namespace
 			auto folder = SAV::selectFolderDialog();
 			if (folder)
 			{
-				auto&& animations = appState.animationData.loadFromFolder(std::filesystem::path(*folder));
-				updateFileListView(std::move(animations), *appState.appHandles.nfileList);
+				startFolderScan(std::filesystem::path(*folder), false, appState);
+			}
+			return true;
+		}
+
+		if (LOWORD(wp) == ID_IMAGE_ADDFOLDER_RECURSIVE)
+		{
+			auto folder = SAV::selectFolderDialog();
+			if (folder)
+			{
+				startFolderScan(std::filesystem::path(*folder), true, appState);
+			}
+			return true;
+		}
+
+		if (LOWORD(wp) == IDC_FILTER_EDIT)
+		{
+			if (HIWORD(wp) == EN_CHANGE)
+			{
+				applyFilter(appState);
 			}
 			return true;
 		}
@@ -342,6 +907,15 @@ namespace
 			return true;
 		}
 
+		if (LOWORD(wp) == ID_IMAGES_THUMBNAILS)
+		{
+			const bool isShown = !appState.frameList.hasThumbnails();
+			appState.frameList.setThumbnails(isShown ? &*appState.thumbnails : nullptr);
+			appState.appHandles.nfileList->showImages(isShown ? static_cast<int>(SAV::ThumbnailCache::tileSize) : 0);
+			::CheckMenuItem(::GetMenu(appState.appHandles.appHandle), ID_IMAGES_THUMBNAILS, isShown ? MF_CHECKED : MF_UNCHECKED);
+			return true;
+		}
+
 		if (LOWORD(wp) == ID_IMAGES_WRITEVIDEO)
 		{
 			DialogBoxParam(nullptr,
@@ -356,8 +930,57 @@ namespace
 			auto filepath = SAV::saveFileDialog(SAV::program_save_data);
 			if (filepath)
 			{
-				auto data = appState.appHandles.nfileList->getListViewData();
-				appState.animationData.saveToFile( *filepath, data );
+				// the journal belongs to the project file as it was written
+				const bool isAutosaved = appState.journal.has_value();
+				appState.journal.reset();
+
+				appState.animationData.saveToFile( *filepath, appState.frameModel.frames() );
+				appState.projectFile = *filepath;
+				appState.thumbnails->save(SAV::ThumbnailFile::sidecarPath(*filepath));
+
+				if (isAutosaved)
+				{
+					openJournal(*filepath, appState);
+				}
+			}
+			return true;
+		}
+
+		if (LOWORD(wp) == ID_PROGRAMM_EXPORT_TEXT)
+		{
+			auto filepath = SAV::saveFileDialog(SAV::program_export_text_data);
+			if (filepath)
+			{
+				appState.animationData.saveToFile( *filepath, appState.frameModel.frames(), SAV::ProjectFormat::Text );
+			}
+			return true;
+		}
+
+		if (LOWORD(wp) == ID_PROGRAMM_BUILD_PACK)
+		{
+			auto filepath = SAV::loadFileDialog(SAV::program_save_data);
+			if (filepath)
+			{
+				auto cursor = ::SetCursor(::LoadCursor(nullptr, IDC_WAIT));
+				if (appState.journal)
+				{
+					appState.journal->flush();
+				}
+
+				std::error_code ec;
+				if (appState.projectFile && std::filesystem::equivalent(*appState.projectFile, *filepath, ec))
+				{
+					// the open project uses the pack right away
+					appState.animationData.buildFramePack(*filepath, appState.animationData.loadFromFile(*filepath));
+					appState.appHandles.imageCanvas->setFramePack(appState.animationData.getFramePack());
+					appState.thumbnails->setFramePack(appState.animationData.getFramePack());
+				}
+				else
+				{
+					SAV::AnimationData project;
+					project.buildFramePack(*filepath, project.loadFromFile(*filepath));
+				}
+				::SetCursor(cursor);
 			}
 			return true;
 		}
@@ -367,35 +990,88 @@ namespace
 			auto filepath = SAV::loadFileDialog(SAV::program_save_data);
 			if (filepath)
 			{
-				auto&& animations = appState.animationData.loadFromFile(*filepath);
-				updateFileListView(std::move(animations), *appState.appHandles.nfileList);
+				const bool isAutosaved = appState.journal.has_value();
+				appState.journal.reset();
+				saveThumbnails(appState);
+
+				appState.thumbnails->load(SAV::ThumbnailFile::sidecarPath(*filepath));
+				appState.frameModel.assign(appState.animationData.loadFromFile(*filepath));
+				appState.appHandles.imageCanvas->setFramePack(appState.animationData.getFramePack());
+				appState.thumbnails->setFramePack(appState.animationData.getFramePack());
+				appState.projectFile = *filepath;
+				updateWatchedFolders(appState);
+
+				// the replayed journal is continued
+				if (isAutosaved)
+				{
+					openJournal(*filepath, appState);
+				}
 			}
 			return true;
 		}
+
+		if (LOWORD(wp) == ID_PROGRAMM_AUTOSAVE)
+		{
+			if (appState.journal)
+			{
+				stopAutosave(appState);
+			}
+			else
+			{
+				startAutosave(appState);
+			}
+			::CheckMenuItem(::GetMenu(appState.appHandles.appHandle), ID_PROGRAMM_AUTOSAVE, appState.journal ? MF_CHECKED : MF_UNCHECKED);
+			return true;
+		}
 		return false;
 	}
 
 	void processResizeWindow(ApplicationState& appState)
 	{
-		auto dimension = getDimensions(*appState.layout, std::string(LAYOUT_IMAGE_CANVAS_NAME));
-		if (dimension)
+		auto changes = appState.layout->findChanges();
+		if (changes.empty())
 		{
-			appState.appHandles.imageCanvas->onResize(*dimension);
+			return;
 		}
 
-		dimension = getDimensions(*appState.layout, std::string(LAYOUT_TIME_LINE_NAME));
-		if (dimension)
+		// The children are moved together when the batch ends, the ones which kept their place are left alone.
+		// A failed batch moves none of them, they are tried again on the next resize.
+		auto positions = ::BeginDeferWindowPos(static_cast<int>(changes.size()));
+		for (const auto& change : changes)
 		{
-			appState.appHandles.nfileList->onResize(*dimension);
+			if (positions == nullptr)
+			{
+				return;
+			}
+
+			const auto position = toRect(change.dimensions);
+			if (change.name == LAYOUT_IMAGE_CANVAS_NAME)
+			{
+				positions = appState.appHandles.imageCanvas->onResize(positions, position);
+			}
+			else if (change.name == LAYOUT_FILTER_BOX_NAME)
+			{
+				positions = ::DeferWindowPos(positions, appState.appHandles.filterEdit, HWND_TOP, position.left, position.top,
+					position.right - position.left,
+					position.bottom - position.top,
+					SWP_NOZORDER | SWP_NOACTIVATE);
+			}
+			else if (change.name == LAYOUT_TIME_LINE_NAME)
+			{
+				positions = appState.appHandles.nfileList->onResize(positions, position);
+			}
+			else if (change.name == LAYOUT_PLAY_BUTTON_NAME)
+			{
+				positions = ::DeferWindowPos(positions, appState.appHandles.playButton, HWND_TOP, position.left, position.top,
+					position.right - position.left,
+					position.bottom - position.top,
+					SWP_NOZORDER | SWP_NOACTIVATE);
+			}
 		}
 
-		dimension = getDimensions(*appState.layout, std::string(LAYOUT_PLAY_BUTTON_NAME));
-		if (dimension)
+		if (positions != nullptr && ::EndDeferWindowPos(positions))
 		{
-			::SetWindowPos(appState.appHandles.playButton, HWND_TOP, dimension->x, dimension->y,
-				dimension->width,
-				dimension->height,
-				SWP_NOZORDER);
+			appState.layout->setApplied(changes);
 		}
 	}
 
@@ -404,38 +1080,97 @@ namespace
 		auto dimension = getDimensions(*appState.layout, std::string(LAYOUT_IMAGE_CANVAS_NAME));
 		if (dimension)
 		{
-			appState.appHandles.imageCanvas.emplace(appState.appHandles.appHandle, *dimension);
+			appState.appHandles.imageCanvas.emplace(appState.appHandles.appHandle, toRect(*dimension));
+		}
+
+		dimension = getDimensions(*appState.layout, std::string(LAYOUT_FILTER_BOX_NAME));
+		if (dimension)
+		{
+			appState.appHandles.filterEdit = ::CreateWindowEx(
+				WS_EX_CLIENTEDGE,
+				WC_EDIT,
+				L"",
+				WS_TABSTOP | WS_VISIBLE | WS_CHILD | ES_AUTOHSCROLL,
+				static_cast<int>(dimension->x),
+				static_cast<int>(dimension->y),
+				static_cast<int>(dimension->width),
+				static_cast<int>(dimension->height),
+				appState.appHandles.appHandle,
+				reinterpret_cast<HMENU>(IDC_FILTER_EDIT),
+				hInstance,
+				NULL);
+			Edit_SetCueBannerText(appState.appHandles.filterEdit, L"Filter by name");
 		}
 		
 		dimension = getDimensions(*appState.layout, std::string(LAYOUT_TIME_LINE_NAME));
 		if (dimension)
 		{
-			appState.appHandles.nfileList.emplace(appState.appHandles.appHandle, *dimension);
+			appState.appHandles.nfileList.emplace(appState.appHandles.appHandle, toRect(*dimension), &appState.frameList);
 		}
 		
 		appState.appHandles.nfileList->setOnSelectHandler(
-			[&appState](const std::vector<std::wstring>& data)
+			[&appState](const std::vector<std::wstring>& data, LPARAM param, int row)
 			{
 				if (!data.empty())
 				{
-					const auto& name = data[0];
-					auto animationFilePath = appState.animationData.getAnimationFilePath(name);
-					if (animationFilePath)
-					{
-						appState.appHandles.imageCanvas->drawImage(*animationFilePath);
-					}
+					auto handle = static_cast<SAV::AnimationData::FrameHandle>(param);
+					appState.appHandles.imageCanvas->drawImage(appState.animationData.getAnimationFilePath(handle));
+				}
+
+				// a found frame is shown among the others
+				if (row >= 0 && appState.frameList.isFiltered())
+				{
+					jumpToFrame(appState.frameList.frameIndex(row), appState);
+				}
+			});
+
+		auto hwnd = appState.appHandles.appHandle;
+		auto* state = &appState;
+		appState.thumbnails.emplace(
+			[state, hwnd]()
+			{
+				if (!state->isThumbnailsPosted.exchange(true))
+				{
+					PostMessage(hwnd, WM_THUMBNAILS_READY, 0, 0);
+				}
+			});
+		appState.animationData.setOnMetadataReady(
+			[state, hwnd]()
+			{
+				if (!state->isMetadataPosted.exchange(true))
+				{
+					PostMessage(hwnd, WM_METADATA_READY, 0, 0);
 				}
 			});
 
 		appState.appHandles.nfileList->createHeaders(std::initializer_list<SAV::HeaderDescription>{ {L"Pictures", 70}, {L"Time", 30} });
 		appState.appHandles.timeline.emplace(appState.appHandles.appHandle,
-			[&appState](const std::wstring& name)
+			[&appState](SAV::TimeLine::FrameId frame)
 			{
-				auto aimationFilePath = appState.animationData.getAnimationFilePath(name);
-				if (aimationFilePath)
+				appState.appHandles.imageCanvas->drawImage(appState.animationData.getAnimationFilePath(frame));
+
+				std::vector<std::filesystem::path> upcoming;
+				for (auto next : appState.appHandles.timeline->upcoming(SAV::AsyncFileReader::defaultReadsInFlight))
 				{
-					appState.appHandles.imageCanvas->drawImage(*aimationFilePath);
+					upcoming.push_back(appState.animationData.getAnimationFilePath(next));
 				}
+				appState.appHandles.imageCanvas->prefetch(upcoming);
+			});
+
+		appState.frameModel.addHandler(
+			[&appState](const SAV::FrameModel::Change& change)
+			{
+				indexFrameNames(change, appState);
+				if (appState.frameList.isFiltered())
+				{
+					updateFilteredList(appState);
+				}
+				else
+				{
+					updateFileListView(change, appState);
+				}
+				postFramesChanged(appState);
+				journalFrameChange(change, appState);
 			});
 
 		dimension = getDimensions(*appState.layout, std::string(LAYOUT_PLAY_BUTTON_NAME));
@@ -505,7 +1240,36 @@ namespace
 				appState->appHandles.nfileList->processEndDragAndDrop(lp);
 				break;
 
+			case WM_FOLDER_SCANNED:
+				processFolderScanned(wp, lp, *appState);
+				return 0;
+
+			case WM_FILES_CHANGED:
+				processFilesChanged(*appState);
+				return 0;
+
+			case WM_FRAMES_CHANGED:
+				processFramesChanged(*appState);
+				return 0;
+
+			case WM_THUMBNAILS_READY:
+				processThumbnailsReady(*appState);
+				return 0;
+
+			case WM_METADATA_READY:
+				processMetadataReady(*appState);
+				return 0;
+
+			case WM_JOURNAL_FAILED:
+				processJournalFailed(wp, *appState);
+				return 0;
+
 			case WM_DESTROY:
+				stopFolderScan(*appState);
+				appState->folderWatcher.reset();
+				appState->journal.reset();
+				saveThumbnails(*appState);
+				appState->thumbnails.reset();
 				PostQuitMessage(0);
 				appState->isExit = true;
 				return 0;
@@ -564,22 +1328,14 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine
 	::RECT viewportRect{ 0L, 0L, static_cast<LONG>(WINDOW_WIDTH), static_cast<LONG>(WINDOW_HEIGHT) };
 	::AdjustWindowRect(&viewportRect, WS_OVERLAPPEDWINDOW, true);
 
-	appState.layout.emplace(
-		std::string(LAYOUT_ROOT_NAME),
-		SAV::Layout::ItemDimensions{ 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT },
-		SAV::Layout::ItemMargin{ 10, 10, 10, 10 })
-		.addItem<SAV::Layout::HBoxLayout>("").second
-		->addItem<SAV::Layout::BoxLayout>(std::string(LAYOUT_IMAGE_CANVAS_NAME), 1110).first
-		->addItem<SAV::Layout::VBoxLayout>("", "*", SAV::Layout::ItemMargin{ 10, 0, 0, 0 }).second
-		->addItem<SAV::Layout::BoxLayout>(std::string(LAYOUT_TIME_LINE_NAME), "90%").first
-		->addItem<SAV::Layout::BoxLayout>("", "*", SAV::Layout::ItemMargin{ 0, 10, 0, 0 }).second
-		->addItem<SAV::Layout::BoxLayout>(std::string(LAYOUT_PLAY_BUTTON_NAME));
+	appState.layout.emplace(SAV::MainWindowLayout::TABLE);
 
 	appState.appHandles.appHandle = ::CreateWindowEx(
 		0,
 		wndClsName,
 		L"Simple.Animation.Viewer",
-		WS_OVERLAPPEDWINDOW,
+		// the background is not painted over the children which a resize left in place
+		WS_OVERLAPPEDWINDOW | WS_CLIPCHILDREN,
 		10, 10,
 		viewportRect.right - viewportRect.left, viewportRect.bottom - viewportRect.top,
 		nullptr,
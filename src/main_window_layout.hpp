@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "layout.hpp"
+
+// The boxes of the main window. They are laid out at compile time, the window scales the table.
+namespace SAV::MainWindowLayout
+{
+	inline constexpr int WINDOW_WIDTH = 1480;
+	inline constexpr int WINDOW_HEIGHT = 768;
+
+	inline constexpr std::string_view LAYOUT_ROOT_NAME = "Root";
+	inline constexpr std::string_view LAYOUT_IMAGE_CANVAS_NAME = "ImageCanvas";
+	inline constexpr std::string_view LAYOUT_FILTER_BOX_NAME = "FilterBox";
+	inline constexpr std::string_view LAYOUT_TIME_LINE_NAME = "TimeLine";
+	inline constexpr std::string_view LAYOUT_PLAY_BUTTON_NAME = "PlayButton";
+
+	// between the filter box and the time line, margins only keep the children of a box apart
+	inline constexpr std::uint32_t FILTER_BOX_GAP = 10;
+
+	namespace Details
+	{
+		using namespace SAV::Layout;
+
+		// root (0), row (1), column (3), buttons (7)
+		inline constexpr std::array<ItemSpec, 8> ITEMS = { {
+			{ 0, ItemType::HBox, "" },
+			{ 1, ItemType::Box, LAYOUT_IMAGE_CANVAS_NAME, pixels(1110) },
+			{ 1, ItemType::VBox, "", rest(), ItemMargin{ 10, 0, 0, 0 } },
+			{ 3, ItemType::Box, LAYOUT_FILTER_BOX_NAME, pixels(24) },
+			{ 3, ItemType::Box, "", pixels(FILTER_BOX_GAP) },
+			{ 3, ItemType::Box, LAYOUT_TIME_LINE_NAME, percent(90) },
+			{ 3, ItemType::Box, "", rest(), ItemMargin{ 0, 10, 0, 0 } },
+			{ 7, ItemType::Box, LAYOUT_PLAY_BUTTON_NAME },
+		} };
+	}
+
+	inline constexpr auto TABLE = Layout::layOut(LAYOUT_ROOT_NAME, Layout::ItemDimensions{ 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT },
+		Layout::ItemMargin{ 10, 10, 10, 10 }, Details::ITEMS);
+
+	static_assert(Layout::fits(TABLE, WINDOW_WIDTH, WINDOW_HEIGHT), "the main window layout doesn't fit in the window");
+	static_assert(Layout::findDimensions(TABLE, LAYOUT_IMAGE_CANVAS_NAME).x + Layout::findDimensions(TABLE, LAYOUT_IMAGE_CANVAS_NAME).width
+		< Layout::findDimensions(TABLE, LAYOUT_TIME_LINE_NAME).x, "the image canvas overlaps the time line");
+	static_assert(Layout::findDimensions(TABLE, LAYOUT_FILTER_BOX_NAME).y + Layout::findDimensions(TABLE, LAYOUT_FILTER_BOX_NAME).height
+		+ FILTER_BOX_GAP == Layout::findDimensions(TABLE, LAYOUT_TIME_LINE_NAME).y, "the filter box touches the time line");
+	static_assert(Layout::findDimensions(TABLE, LAYOUT_PLAY_BUTTON_NAME).height > 0, "no room is left for the play button");
+}
@@ -0,0 +1,104 @@
+#include <Windows.h>
+
+#include "mapped_file.hpp"
+
+namespace SAV
+{
+	std::optional<MappedFile> MappedFile::open(const std::filesystem::path& filepath)
+	{
+		HANDLE file = ::CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return std::nullopt;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!::GetFileSizeEx(file, &fileSize))
+		{
+			::CloseHandle(file);
+			return std::nullopt;
+		}
+
+		// an empty file can't be mapped, it is still a valid (empty) view
+		if (fileSize.QuadPart == 0)
+		{
+			return MappedFile{ file, nullptr, nullptr, 0 };
+		}
+
+		HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			::CloseHandle(file);
+			return std::nullopt;
+		}
+
+		auto* data = static_cast<const std::byte*>(::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (data == nullptr)
+		{
+			::CloseHandle(mapping);
+			::CloseHandle(file);
+			return std::nullopt;
+		}
+
+		return MappedFile{ file, mapping, data, static_cast<std::size_t>(fileSize.QuadPart) };
+	}
+
+	MappedFile::~MappedFile() noexcept
+	{
+		release();
+	}
+
+	MappedFile::MappedFile(MappedFile&& file) noexcept :
+		m_file{ file.m_file },
+		m_mapping{ file.m_mapping },
+		m_data{ file.m_data },
+		m_size{ file.m_size }
+	{
+		file.m_file = INVALID_HANDLE_VALUE;
+		file.m_mapping = nullptr;
+		file.m_data = nullptr;
+		file.m_size = 0;
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& file) noexcept
+	{
+		if (this != &file)
+		{
+			release();
+
+			m_file = file.m_file;
+			m_mapping = file.m_mapping;
+			m_data = file.m_data;
+			m_size = file.m_size;
+
+			file.m_file = INVALID_HANDLE_VALUE;
+			file.m_mapping = nullptr;
+			file.m_data = nullptr;
+			file.m_size = 0;
+		}
+		return *this;
+	}
+
+	void MappedFile::release() noexcept
+	{
+		if (m_data != nullptr)
+		{
+			::UnmapViewOfFile(m_data);
+			m_data = nullptr;
+		}
+
+		if (m_mapping != nullptr)
+		{
+			::CloseHandle(m_mapping);
+			m_mapping = nullptr;
+		}
+
+		if (m_file != INVALID_HANDLE_VALUE)
+		{
+			::CloseHandle(m_file);
+			m_file = INVALID_HANDLE_VALUE;
+		}
+		m_size = 0;
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+
+namespace SAV
+{
+	// Read-only view of a whole file mapped into memory
+	class MappedFile
+	{
+	public:
+		static std::optional<MappedFile> open(const std::filesystem::path& filepath);
+
+		~MappedFile() noexcept;
+
+		MappedFile(MappedFile&& file) noexcept;
+		MappedFile& operator=(MappedFile&& file) noexcept;
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const std::byte* data() const { return m_data; }
+		std::size_t size() const { return m_size; }
+
+	private:
+		// a Win32 HANDLE, the header is kept free of Windows.h
+		using Handle = void*;
+
+		MappedFile(Handle file, Handle mapping, const std::byte* data, std::size_t size) noexcept :
+			m_file{ file },
+			m_mapping{ mapping },
+			m_data{ data },
+			m_size{ size }
+		{}
+
+		void release() noexcept;
+
+	private:
+		Handle m_file;
+		Handle m_mapping;
+		const std::byte* m_data;
+		std::size_t m_size;
+	};
+}
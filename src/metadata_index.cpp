@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include <unordered_set>
+
+#include "mapped_file.hpp"
+#include "metadata_index.hpp"
+#include "utils.hpp"
+
+namespace
+{
+	constexpr std::size_t HASH_CHUNK_SIZE = 1024 * 1024;
+
+	std::optional<std::uint64_t> hashFile(const std::filesystem::path& file)
+	{
+		std::ifstream input(file, std::ios_base::binary);
+		if (!input)
+		{
+			return std::nullopt;
+		}
+
+		std::vector<char> buffer(HASH_CHUNK_SIZE);
+		std::uint64_t hash = SAV::Utils::FNV_OFFSET_BASIS;
+		while (input)
+		{
+			input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+			hash = SAV::Utils::hash(buffer.data(), static_cast<std::size_t>(input.gcount()), hash);
+		}
+		return input.eof() ? std::optional<std::uint64_t>{ hash } : std::nullopt;
+	}
+}
+
+namespace SAV
+{
+	std::filesystem::path MetadataIndex::sidecarPath(const std::filesystem::path& project)
+	{
+		auto path = project;
+		path += MetadataIndexFile::extension;
+		return path;
+	}
+
+	MetadataIndex::~MetadataIndex()
+	{
+		stop();
+	}
+
+	void MetadataIndex::load(const std::filesystem::path& indexFile)
+	{
+		stop();
+		m_entries.clear();
+		m_pending.clear();
+		m_isModified = false;
+
+		auto mappedFile = MappedFile::open(indexFile);
+		if (!mappedFile || mappedFile->size() < sizeof(MetadataIndexFile::Header))
+		{
+			return;
+		}
+
+		const auto size = static_cast<std::uint64_t>(mappedFile->size());
+		const auto& header = *reinterpret_cast<const MetadataIndexFile::Header*>(mappedFile->data());
+		if (header.magic != MetadataIndexFile::magic || header.version != MetadataIndexFile::version ||
+			header.entriesOffset % alignof(MetadataIndexFile::Entry) != 0 ||
+			!Utils::isRangeInside(header.entriesOffset, header.entryCount, sizeof(MetadataIndexFile::Entry), size))
+		{
+			return;
+		}
+
+		auto* entries = reinterpret_cast<const MetadataIndexFile::Entry*>(mappedFile->data() + header.entriesOffset);
+		m_entries.reserve(header.entryCount);
+		for (std::uint32_t index = 0; index < header.entryCount; ++index)
+		{
+			const auto& entry = entries[index];
+			if (entry.pathOffset % sizeof(wchar_t) != 0 || !Utils::isRangeInside(entry.pathOffset, entry.pathLength, sizeof(wchar_t), size) ||
+				entry.format > static_cast<std::uint32_t>(ImageFormat::Tiff))
+			{
+				m_entries.clear();
+				return;
+			}
+
+			std::wstring path{ reinterpret_cast<const wchar_t*>(mappedFile->data() + entry.pathOffset), entry.pathLength };
+			ImageInfo info{ static_cast<ImageFormat>(entry.format), entry.width, entry.height, entry.bitsPerPixel };
+			m_entries.emplace(std::move(path), FileMetadata{ entry.size, entry.modified, info, entry.contentHash });
+		}
+	}
+
+	bool MetadataIndex::save(const std::filesystem::path& indexFile)
+	{
+		// an entry without its hash would be taken for up to date by the next load
+		auto isSaved = [this](const std::wstring& path) { return m_pending.count(path) == 0; };
+		const auto entryCount = m_entries.size() - m_pending.size();
+		MetadataIndexFile::Header header = { MetadataIndexFile::magic, MetadataIndexFile::version,
+			static_cast<std::uint32_t>(entryCount), 0, sizeof(MetadataIndexFile::Header) };
+
+		std::vector<MetadataIndexFile::Entry> entries;
+		entries.reserve(entryCount);
+		std::uint64_t offset = header.entriesOffset + entryCount * sizeof(MetadataIndexFile::Entry);
+		for (const auto& [path, metadata] : m_entries)
+		{
+			if (!isSaved(path))
+			{
+				continue;
+			}
+			entries.push_back(MetadataIndexFile::Entry{ offset, static_cast<std::uint32_t>(path.size()),
+				static_cast<std::uint32_t>(metadata.info.format), metadata.size, metadata.modified,
+				metadata.info.width, metadata.info.height, metadata.info.bitsPerPixel, 0, metadata.contentHash });
+			offset += path.size() * sizeof(wchar_t);
+		}
+
+		std::ofstream output(indexFile, std::ios_base::binary | std::ios_base::trunc);
+		Utils::writeValue(output, header);
+		output.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(MetadataIndexFile::Entry)));
+		for (const auto& [path, metadata] : m_entries)
+		{
+			if (!isSaved(path))
+			{
+				continue;
+			}
+			output.write(reinterpret_cast<const char*>(path.data()), static_cast<std::streamsize>(path.size() * sizeof(wchar_t)));
+		}
+
+		if (!output)
+		{
+			return false;
+		}
+		m_isModified = false;
+		return true;
+	}
+
+	std::size_t MetadataIndex::refresh(const std::vector<std::filesystem::path>& files)
+	{
+		stop();
+
+		std::unordered_set<std::wstring> listed;
+		std::unordered_set<std::wstring> pending;
+		std::vector<std::filesystem::path> stale;
+		for (const auto& file : files)
+		{
+			auto key = file.wstring();
+			if (!listed.insert(key).second)
+			{
+				continue;
+			}
+
+			auto it = m_entries.find(key);
+			auto stamp = Utils::stampOf(file);
+			if (!stamp)
+			{
+				if (it != m_entries.end())
+				{
+					m_entries.erase(it);
+					m_isModified = true;
+				}
+				continue;
+			}
+
+			// a file whose reading was canceled has the right size and time already
+			if (it == m_entries.end() || it->second.size != stamp->size || it->second.modified != stamp->modified || m_pending.count(key) > 0)
+			{
+				m_entries.insert_or_assign(key, FileMetadata{ stamp->size, stamp->modified, ImageInfo{ ImageFormat::Unknown, 0, 0, 0 }, 0 });
+				pending.insert(std::move(key));
+				stale.push_back(file);
+			}
+		}
+		m_pending = std::move(pending);
+
+		for (auto it = m_entries.begin(); it != m_entries.end();)
+		{
+			if (listed.count(it->first) == 0)
+			{
+				it = m_entries.erase(it);
+				m_isModified = true;
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		if (stale.empty())
+		{
+			return 0;
+		}
+
+		const auto count = stale.size();
+		if (!m_onReady)
+		{
+			apply(readFiles(stale, CancellationToken{}));
+			return count;
+		}
+
+		m_cancellation = CancellationSource{};
+		m_worker = std::thread([this, stale = std::move(stale), cancellationToken = m_cancellation.token()]()
+			{
+				auto results = readFiles(stale, cancellationToken);
+				if (cancellationToken.isCanceled())
+				{
+					return;
+				}
+
+				{
+					std::lock_guard lock(m_mutex);
+					m_results = std::move(results);
+				}
+				m_onReady();
+			});
+		return count;
+	}
+
+	bool MetadataIndex::collect()
+	{
+		ReadResults results;
+		{
+			std::lock_guard lock(m_mutex);
+			results = std::move(m_results);
+			m_results.clear();
+		}
+		if (results.empty())
+		{
+			return false;
+		}
+
+		// the worker is done once it handed over its results
+		if (m_worker.joinable())
+		{
+			m_worker.join();
+		}
+		apply(std::move(results));
+		return true;
+	}
+
+	void MetadataIndex::apply(ReadResults results)
+	{
+		for (auto& [file, metadata] : results)
+		{
+			auto key = file.wstring();
+			// dropped by a refresh or a load meanwhile
+			if (m_pending.erase(key) == 0)
+			{
+				continue;
+			}
+
+			if (metadata)
+			{
+				m_entries.insert_or_assign(std::move(key), *metadata);
+			}
+			else
+			{
+				m_entries.erase(key);
+			}
+			m_isModified = true;
+		}
+	}
+
+	void MetadataIndex::stop()
+	{
+		m_cancellation.cancel();
+		if (m_worker.joinable())
+		{
+			m_worker.join();
+		}
+
+		std::lock_guard lock(m_mutex);
+		m_results.clear();
+	}
+
+	MetadataIndex::ReadResults MetadataIndex::readFiles(const std::vector<std::filesystem::path>& files, const CancellationToken& cancellationToken)
+	{
+		ReadResults results(files.size());
+		std::atomic<std::size_t> next = 0;
+		auto worker = [&files, &results, &next, &cancellationToken]()
+		{
+			for (auto index = next++; index < files.size() && !cancellationToken.isCanceled(); index = next++)
+			{
+				results[index] = { files[index], read(files[index]) };
+			}
+		};
+
+		const auto threadCount = (std::min)(static_cast<std::size_t>((std::max)(1u, std::thread::hardware_concurrency())), files.size());
+		std::vector<std::thread> threads;
+		for (std::size_t index = 1; index < threadCount; ++index)
+		{
+			threads.emplace_back(worker);
+		}
+		worker();
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+		return results;
+	}
+
+	std::optional<FileMetadata> MetadataIndex::find(const std::filesystem::path& file) const
+	{
+		if (auto it = m_entries.find(file.wstring()); it != m_entries.end())
+		{
+			return it->second;
+		}
+		return std::nullopt;
+	}
+
+	std::optional<FileMetadata> MetadataIndex::read(const std::filesystem::path& file)
+	{
+		auto stamp = Utils::stampOf(file);
+		if (!stamp)
+		{
+			return std::nullopt;
+		}
+		FileMetadata metadata{ stamp->size, stamp->modified, ImageInfo{ ImageFormat::Unknown, 0, 0, 0 }, 0 };
+
+		if (auto info = ImageProbe::probe(file); info)
+		{
+			metadata.info = *info;
+		}
+
+		auto contentHash = hashFile(file);
+		if (!contentHash)
+		{
+			return std::nullopt;
+		}
+		metadata.contentHash = *contentHash;
+		return metadata;
+	}
+}
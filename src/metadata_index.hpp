@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "cancellation_token.hpp"
+#include "image_probe.hpp"
+
+namespace SAV
+{
+	struct FileMetadata
+	{
+		std::uint64_t size;
+		std::int64_t modified; // last write time in file clock ticks
+		ImageInfo info;        // format is Unknown if the file isn't an image
+		std::uint64_t contentHash;
+	};
+
+	// Sidecar index (<project>.savidx) of everything known about the frames of a project.
+	// All integers are little endian, paths are UTF-16.
+	//
+	//   Header
+	//   Entry[entryCount]
+	//   wchar_t[]           path characters
+	namespace MetadataIndexFile
+	{
+		inline constexpr std::array<char, 4> magic = { 'S', 'A', 'V', 'I' };
+		inline constexpr std::uint32_t version = 1;
+		inline constexpr std::wstring_view extension = L".savidx";
+
+		struct Header
+		{
+			std::array<char, 4> magic;
+			std::uint32_t version;
+			std::uint32_t entryCount;
+			std::uint32_t reserved;
+			std::uint64_t entriesOffset;
+		};
+
+		struct Entry
+		{
+			std::uint64_t pathOffset;
+			std::uint32_t pathLength;
+			std::uint32_t format;
+			std::uint64_t size;
+			std::int64_t modified;
+			std::uint32_t width;
+			std::uint32_t height;
+			std::uint32_t bitsPerPixel;
+			std::uint32_t reserved;
+			std::uint64_t contentHash;
+		};
+
+		static_assert(sizeof(Header) == 24 && sizeof(Entry) == 56, "the layout is part of the format");
+	}
+
+	class MetadataIndex
+	{
+	public:
+		// Called on the worker thread once the files of refresh() were read, collect() takes them on the window thread
+		using OnReady = std::function<void()>;
+
+	public:
+		static std::filesystem::path sidecarPath(const std::filesystem::path& project);
+
+		MetadataIndex() = default;
+		~MetadataIndex();
+
+		MetadataIndex(const MetadataIndex&) = delete;
+		MetadataIndex& operator=(const MetadataIndex&) = delete;
+
+		// Without a handler refresh() reads the files itself before it returns
+		void setOnReady(const OnReady& onReady) { m_onReady = onReady; }
+
+		// A missing or damaged index simply starts empty
+		void load(const std::filesystem::path& indexFile);
+		// Files still being read are left out
+		bool save(const std::filesystem::path& indexFile);
+
+		// Only files whose size or modification time differ from the index are probed and hashed again,
+		// on a worker if there is a handler. Until collect() takes them their entries hold just the size and
+		// the time. Entries of files that are not listed are dropped, a refresh still running is canceled.
+		// Returns the number of files to read.
+		std::size_t refresh(const std::vector<std::filesystem::path>& files);
+		// Moves the files read by the worker into the index, returns false if it had nothing ready
+		bool collect();
+
+		std::optional<FileMetadata> find(const std::filesystem::path& file) const;
+
+		bool isModified() const { return m_isModified; }
+
+	private:
+		using ReadResults = std::vector<std::pair<std::filesystem::path, std::optional<FileMetadata>>>;
+
+	private:
+		static std::optional<FileMetadata> read(const std::filesystem::path& file);
+		// Hashing reads whole files, they are spread over the cores
+		static ReadResults readFiles(const std::vector<std::filesystem::path>& files, const CancellationToken& cancellationToken);
+
+		void apply(ReadResults results);
+		// Cancels the worker and waits for it, what it has read is dropped
+		void stop();
+
+	private:
+		std::unordered_map<std::wstring, FileMetadata> m_entries;
+		// files of the last refresh which are not read yet
+		std::unordered_set<std::wstring> m_pending;
+		bool m_isModified = false;
+
+		OnReady m_onReady;
+		CancellationSource m_cancellation;
+		std::thread m_worker;
+		std::mutex m_mutex;
+		ReadResults m_results;
+	};
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+
+// Numbers and durations typed by the user or read from text projects. Nothing is allocated and
+// nothing depends on the platform, a value which doesn't fit is rejected instead of cut off.
+namespace SAV::NumberParser
+{
+	// The frame rate of the made videos, an "f" duration counts frames of it
+	inline constexpr std::uint32_t projectFps = 30;
+
+	namespace Details
+	{
+		template <typename CharT>
+		constexpr std::optional<std::uint64_t> parseNumber(std::basic_string_view<CharT> text, std::uint64_t maxValue)
+		{
+			if (text.empty())
+			{
+				return std::nullopt;
+			}
+
+			std::uint64_t value = 0;
+			for (auto symbol : text)
+			{
+				if (symbol < CharT('0') || symbol > CharT('9'))
+				{
+					return std::nullopt;
+				}
+
+				const std::uint64_t digit = static_cast<std::uint64_t>(symbol - CharT('0'));
+				if (digit > maxValue || value > (maxValue - digit) / 10)
+				{
+					return std::nullopt;
+				}
+				value = value * 10 + digit;
+			}
+			return value;
+		}
+
+		template <typename CharT>
+		constexpr std::optional<std::uint32_t> parseDuration(std::basic_string_view<CharT> text, std::uint32_t fps)
+		{
+			constexpr std::uint64_t maxMs = (std::numeric_limits<std::uint32_t>::max)();
+
+			if (text.size() > 2 && text[text.size() - 2] == CharT('m') && text.back() == CharT('s'))
+			{
+				text.remove_suffix(2);
+				auto value = parseNumber(text, maxMs);
+				return value ? std::optional{ static_cast<std::uint32_t>(*value) } : std::nullopt;
+			}
+
+			if (text.size() > 1 && text.back() == CharT('s'))
+			{
+				text.remove_suffix(1);
+				auto value = parseNumber(text, maxMs / 1000);
+				return value ? std::optional{ static_cast<std::uint32_t>(*value * 1000) } : std::nullopt;
+			}
+
+			if (text.size() > 1 && text.back() == CharT('f'))
+			{
+				text.remove_suffix(1);
+				auto value = fps > 0 ? parseNumber(text, maxMs) : std::nullopt;
+				if (!value)
+				{
+					return std::nullopt;
+				}
+
+				// rounded to the closest millisecond, the frame count is small enough to not overflow
+				const auto ms = (*value * 1000 + fps / 2) / fps;
+				return ms <= maxMs ? std::optional{ static_cast<std::uint32_t>(ms) } : std::nullopt;
+			}
+
+			auto value = parseNumber(text, maxMs);
+			return value ? std::optional{ static_cast<std::uint32_t>(*value) } : std::nullopt;
+		}
+	}
+
+	// Decimal digits only, nullopt if there are none or the value is above maxValue
+	constexpr std::optional<std::uint64_t> parseNumber(std::wstring_view text,
+		std::uint64_t maxValue = (std::numeric_limits<std::uint64_t>::max)())
+	{
+		return Details::parseNumber(text, maxValue);
+	}
+
+	constexpr std::optional<std::uint64_t> parseNumber(std::string_view text,
+		std::uint64_t maxValue = (std::numeric_limits<std::uint64_t>::max)())
+	{
+		return Details::parseNumber(text, maxValue);
+	}
+
+	// "<n>ms", "<n>s", "<n>f" (frames at fps) or a plain "<n>" in milliseconds, returned in milliseconds.
+	// nullopt if the text is malformed or the duration doesn't fit in 32 bits like in the project files.
+	constexpr std::optional<std::uint32_t> parseDuration(std::wstring_view text, std::uint32_t fps = projectFps)
+	{
+		return Details::parseDuration(text, fps);
+	}
+
+	constexpr std::optional<std::uint32_t> parseDuration(std::string_view text, std::uint32_t fps = projectFps)
+	{
+		return Details::parseDuration(text, fps);
+	}
+}
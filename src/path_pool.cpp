@@ -0,0 +1,87 @@
+#include "path_pool.hpp"
+#include "utils.hpp"
+
+namespace
+{
+	constexpr std::size_t INITIAL_SLOT_COUNT = 1024;
+}
+
+namespace SAV
+{
+	std::uint32_t PathPool::hash(std::wstring_view path)
+	{
+		auto value = Utils::hash(path.data(), path.size() * sizeof(wchar_t));
+		return static_cast<std::uint32_t>(value ^ (value >> 32));
+	}
+
+	std::size_t PathPool::findSlot(std::wstring_view path, std::uint32_t pathHash) const
+	{
+		const auto mask = m_slots.size() - 1;
+		for (auto slot = pathHash & mask;; slot = (slot + 1) & mask)
+		{
+			auto handle = m_slots[slot];
+			if (handle == invalidHandle)
+			{
+				return slot;
+			}
+
+			const auto& entry = m_entries[handle];
+			if (entry.hash == pathHash && this->path(handle) == path)
+			{
+				return slot;
+			}
+		}
+	}
+
+	std::optional<PathPool::Handle> PathPool::find(std::wstring_view path) const
+	{
+		if (m_slots.empty())
+		{
+			return std::nullopt;
+		}
+
+		auto handle = m_slots[findSlot(path, hash(path))];
+		if (handle == invalidHandle)
+		{
+			return std::nullopt;
+		}
+		return handle;
+	}
+
+	PathPool::Handle PathPool::intern(std::wstring_view path)
+	{
+		// keep the load factor under one half
+		if ((m_entries.size() + 1) * 2 > m_slots.size())
+		{
+			grow();
+		}
+
+		const auto pathHash = hash(path);
+		auto& handle = m_slots[findSlot(path, pathHash)];
+		if (handle != invalidHandle)
+		{
+			return handle;
+		}
+
+		handle = static_cast<Handle>(m_entries.size());
+		m_entries.push_back(Entry{ m_arena.size(), static_cast<std::uint32_t>(path.size()), pathHash });
+		m_arena.insert(m_arena.end(), path.begin(), path.end());
+		return handle;
+	}
+
+	void PathPool::grow()
+	{
+		m_slots.assign(m_slots.empty() ? INITIAL_SLOT_COUNT : m_slots.size() * 2, invalidHandle);
+
+		const auto mask = m_slots.size() - 1;
+		for (Handle handle = 0; handle < m_entries.size(); ++handle)
+		{
+			auto slot = m_entries[handle].hash & mask;
+			while (m_slots[slot] != invalidHandle)
+			{
+				slot = (slot + 1) & mask;
+			}
+			m_slots[slot] = handle;
+		}
+	}
+}
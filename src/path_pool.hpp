@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace SAV
+{
+	// Interns paths into one contiguous arena. Every distinct path is stored once and identified by
+	// a small integer handle that stays valid for the lifetime of the pool. Lookups by string view
+	// hash the characters in place and never allocate.
+	class PathPool
+	{
+	public:
+		using Handle = std::uint32_t;
+
+		inline static constexpr Handle invalidHandle = ~Handle{ 0 };
+
+	public:
+		// Returns the handle of an equal path if there is one
+		Handle intern(std::wstring_view path);
+		std::optional<Handle> find(std::wstring_view path) const;
+
+		// The view is invalidated by the next intern() because the arena may grow
+		std::wstring_view path(Handle handle) const
+		{
+			const auto& entry = m_entries[handle];
+			return std::wstring_view{ m_arena.data() + entry.offset, entry.length };
+		}
+
+		std::size_t size() const { return m_entries.size(); }
+
+	private:
+		struct Entry
+		{
+			std::uint64_t offset;
+			std::uint32_t length;
+			std::uint32_t hash;
+		};
+
+	private:
+		static std::uint32_t hash(std::wstring_view path);
+		std::size_t findSlot(std::wstring_view path, std::uint32_t pathHash) const;
+		void grow();
+
+	private:
+		std::vector<wchar_t> m_arena;
+		std::vector<Entry> m_entries;
+		// open addressing with linear probing, the size is a power of two
+		std::vector<Handle> m_slots;
+	};
+}
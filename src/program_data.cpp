@@ -1,137 +1,471 @@
-#include <charconv>
+#include <algorithm>
 #include <cstdint>
 #include <fstream>
+#include <iterator>
+#include <set>
+#include <unordered_map>
+#include "image_probe.hpp"
+#include "mapped_file.hpp"
 #include "program_data.hpp"
+#include "project_file.hpp"
+#include "project_journal.hpp"
+#include "text_project_parser.hpp"
 
 // disable narrow conversion warning because of std::string(wstring)
 #pragma warning( disable : 4244 ) 
 
 namespace SAV
 {
-	std::chrono::milliseconds AnimationDescription::toMs(std::wstring_view duration)
+	std::wstring AnimationDescription::name() const
+	{
+		std::filesystem::path path{ m_filepath };
+		return path.filename().wstring();
+	}
+
+	std::wstring AnimationDescription::toRowData() const
+	{
+		return m_filepath + delim + std::to_wstring(m_duration.count());
+	}
+
+	AnimationData::Animations AnimationData::toAnimations(const Frames& frames) const
 	{
-		std::string durationString(duration.begin(), duration.end());
-		std::uint32_t value = 0;
-		if (auto [c, ec] = std::from_chars(durationString.data(), durationString.data() + durationString.size(), value); ec != std::errc())
+		Animations animations;
+		animations.reserve(frames.size());
+		for (const auto& frame : frames)
 		{
-			value = 0;
+			animations.emplace_back(getAnimationFilePath(frame.handle).wstring(), frame.duration);
 		}
+		return animations;
+	}
 
-		return std::chrono::milliseconds{value};
+	ProjectRows AnimationData::toProjectRows(const Frames& frames) const
+	{
+		ProjectRows rows;
+		for (std::size_t index = 0; index < frames.size();)
+		{
+			const auto& frame = frames[index];
+			if (const auto* range = findSequence(frame.handle); range)
+			{
+				const auto offset = frame.handle - range->firstHandle;
+				auto end = index + 1;
+				while (end < frames.size() && offset + (end - index) < range->sequence.size() &&
+					frames[end].handle == frame.handle + (end - index) && frames[end].duration == frame.duration)
+				{
+					++end;
+				}
+
+				if (end - index >= FrameSequence::minRunLength)
+				{
+					auto run = range->sequence.slice(offset, static_cast<std::uint32_t>(end - index));
+					rows.push_back(ProjectRow{ run.descriptor(frame.duration), frame.duration, true });
+					index = end;
+					continue;
+				}
+			}
+
+			rows.push_back(ProjectRow{ getAnimationFilePath(frame.handle).wstring(), frame.duration, false });
+			++index;
+		}
+		return rows;
 	}
 
-	AnimationDescription::AnimationDescription(std::wstring_view rowData) :
-		m_filepath{},
-		m_duration{ 0 }
+	void AnimationData::saveToFile(const std::filesystem::path& file, const Frames& frames, ProjectFormat format)
 	{
-		auto pos = rowData.find(AnimationDescription::delim);
-		if (pos == std::wstring::npos)
+		auto rows = toProjectRows(frames);
+		if (format == ProjectFormat::Binary)
 		{
-			throw std::exception();
+			ProjectFile::write(file, rows);
+		}
+		else
+		{
+			std::wofstream output(file.wstring(), std::ios_base::trunc);
+			for (const auto& row : rows)
+			{
+				output << (row.isSequence ? row.path : AnimationDescription{ row.path, row.duration }.toRowData()) << L'\n';
+			}
 		}
-		auto filepath = rowData.substr(0, pos);
-		m_filepath.assign(filepath);
 
-		m_duration = toMs(rowData.substr(pos + 1));
+		updateMetadataIndex(file, frames);
 	}
 
-	std::wstring AnimationDescription::name() const
+	void AnimationData::updateMetadataIndex(const std::filesystem::path& file, const Frames& frames)
 	{
-		std::filesystem::path path{ m_filepath };
-		return path.filename().wstring();
+		std::vector<std::filesystem::path> files;
+		files.reserve(frames.size());
+		std::transform(frames.begin(), frames.end(), std::back_inserter(files),
+			[this](const auto& frame) { return getAnimationFilePath(frame.handle); });
+
+		m_metadataFile = MetadataIndex::sidecarPath(file);
+		m_metadataIndex.refresh(files);
+		if (m_metadataIndex.isModified())
+		{
+			m_metadataIndex.save(m_metadataFile);
+		}
 	}
 
-	std::wstring AnimationDescription::toRowData() const
+	void AnimationData::collectMetadata()
 	{
-		return m_filepath + delim + std::to_wstring(m_duration.count());
+		if (m_metadataIndex.collect() && m_metadataIndex.isModified() && !m_metadataFile.empty())
+		{
+			m_metadataIndex.save(m_metadataFile);
+		}
 	}
 
-	void AnimationData::saveToFile(const std::filesystem::path& file, const std::vector<std::vector<std::wstring>>& rawAnimationData) const
+	AnimationData::Frames AnimationData::loadFromFolder(const std::filesystem::path& folder, const CancellationToken& cancellationToken)
 	{
-		Animations animations;
-		for (const auto& row : rawAnimationData)
+		std::vector<std::filesystem::path> files;
+		for (const auto& file : std::filesystem::directory_iterator(folder))
+		{
+			files.push_back(file.path());
+		}
+		// the directory order is not specified everywhere, sorted names keep numbered runs together
+		std::sort(files.begin(), files.end());
+
+		// only the first frame of a numbered run is probed
+		Frames frames;
+		for (const auto& run : FrameSequence::findRuns(files))
 		{
-			const auto& name = row[0];
-			auto animationFile = getAnimationFilePath(name);
-			if (animationFile)
+			if (cancellationToken.isCanceled())
 			{
-				const auto& duration = row[1];
-				animations.emplace_back( animationFile->wstring(), duration );
+				break;
 			}
+
+			auto info = ImageProbe::probe(files[run.offset]);
+			if (!info)
+			{
+				continue;
+			}
+
+			if (run.sequence)
+			{
+				appendSequence(*run.sequence, std::chrono::milliseconds{ 0 }, frames, info);
+				continue;
+			}
+
+			auto handle = m_paths.intern(files[run.offset].native());
+			m_imageInfos[handle] = *info;
+			frames.push_back(Frame{ handle, std::chrono::milliseconds{ 0 } });
 		}
-		saveToFile(file, animations);
+
+		return frames;
 	}
 
-	void AnimationData::saveToFile(const std::filesystem::path& file, const Animations& animations) const
+	AnimationData::Frames AnimationData::addScannedImages(std::vector<ScannedImage>&& images)
 	{
-		std::wofstream output(file.wstring(), std::ios_base::trunc);
-		for (const auto& animation : animations)
+		std::vector<std::filesystem::path> files;
+		files.reserve(images.size());
+		std::transform(images.begin(), images.end(), std::back_inserter(files), [](const auto& image) { return image.path; });
+
+		Frames frames;
+		frames.reserve(images.size());
+		for (const auto& run : FrameSequence::findRuns(files))
 		{
-			output << animation.toRowData() << std::endl;
+			const auto& image = images[run.offset];
+			if (run.sequence)
+			{
+				appendSequence(*run.sequence, std::chrono::milliseconds{ 0 }, frames, image.info);
+				continue;
+			}
+
+			auto handle = m_paths.intern(image.path.native());
+			m_imageInfos[handle] = image.info;
+			frames.push_back(Frame{ handle, std::chrono::milliseconds{ 0 } });
 		}
+
+		return frames;
 	}
 
-	AnimationData::Animations AnimationData::loadFromFolder(const std::filesystem::path& folder)
+	AnimationData::FrameHandle AnimationData::addSequence(const FrameSequence& sequence, const std::optional<ImageInfo>& info)
 	{
-		Animations animations;
-		std::transform(std::filesystem::directory_iterator(folder), std::filesystem::directory_iterator(), std::back_inserter(animations),
-			[this](const auto& file)
+		for (const auto& range : m_sequences)
+		{
+			if (range.sequence.hasSamePattern(sequence) && range.sequence.first() <= sequence.first() && sequence.last() <= range.sequence.last())
 			{
-				SAV::AnimationDescription desc{ file.path() };
-				if (auto it = this->m_animationFiles.find(desc.name()); it == this->m_animationFiles.end())
+				return range.firstHandle + (sequence.first() - range.sequence.first());
+			}
+		}
+
+		if (sequence.size() > PathPool::invalidHandle - m_nextSequenceHandle)
+		{
+			throw std::exception("too many sequence frames");
+		}
+
+		const auto handle = m_nextSequenceHandle;
+		m_nextSequenceHandle += sequence.size();
+
+		// a folder scan delivers a long run in several batches
+		if (!m_sequences.empty() && m_sequences.back().sequence.extend(sequence))
+		{
+			return handle;
+		}
+
+		m_sequences.push_back(SequenceRange{ sequence, handle, info });
+		return handle;
+	}
+
+	void AnimationData::appendSequence(const FrameSequence& sequence, std::chrono::milliseconds duration, Frames& frames,
+		const std::optional<ImageInfo>& info)
+	{
+		const auto handle = addSequence(sequence, info);
+		for (std::uint32_t index = 0; index < sequence.size(); ++index)
+		{
+			frames.push_back(Frame{ handle + index, duration });
+		}
+	}
+
+	const AnimationData::SequenceRange* AnimationData::findSequence(FrameHandle handle) const
+	{
+		if (handle < sequenceHandleBase || handle >= m_nextSequenceHandle)
+		{
+			return nullptr;
+		}
+
+		auto it = std::upper_bound(m_sequences.begin(), m_sequences.end(), handle,
+			[](FrameHandle value, const auto& range) { return value < range.firstHandle; });
+		return &*std::prev(it);
+	}
+
+	std::filesystem::path AnimationData::getAnimationFilePath(FrameHandle handle) const
+	{
+		if (const auto* range = findSequence(handle); range)
+		{
+			return range->sequence.path(handle - range->firstHandle);
+		}
+
+		return std::filesystem::path{ m_paths.path(handle) };
+	}
+
+	AnimationData::Frames AnimationData::loadFromFile(const std::filesystem::path& file)
+	{
+		m_metadataIndex.load(MetadataIndex::sidecarPath(file));
+
+		Frames frames;
+		if (auto project = ProjectView::open(file); project)
+		{
+			frames = loadFromProject(*project);
+		}
+		else
+		{
+			frames = loadFromTextFile(file);
+		}
+
+		if (auto ops = ProjectJournalFile::read(file); !ops.empty())
+		{
+			applyJournal(frames, ops);
+		}
+
+		updateMetadataIndex(file, frames);
+		openFramePack(file, frames);
+		return frames;
+	}
+
+	bool AnimationData::buildFramePack(const std::filesystem::path& project, const Frames& frames)
+	{
+		std::vector<std::filesystem::path> files;
+		files.reserve(frames.size());
+		std::transform(frames.begin(), frames.end(), std::back_inserter(files),
+			[this](const auto& frame) { return getAnimationFilePath(frame.handle); });
+
+		// the mapping of an old pack would keep the file open
+		m_framePack.reset();
+		if (!FramePackFile::build(FramePackFile::sidecarPath(project), files))
+		{
+			return false;
+		}
+
+		updateMetadataIndex(project, frames);
+		return openFramePack(project, frames);
+	}
+
+	bool AnimationData::openFramePack(const std::filesystem::path& project, const Frames& frames)
+	{
+		m_framePack.reset();
+		auto pack = FramePack::open(FramePackFile::sidecarPath(project));
+		if (!pack)
+		{
+			return false;
+		}
+
+		// the index was refreshed on load, so comparing with it costs no extra stat
+		for (const auto& frame : frames)
+		{
+			auto path = getAnimationFilePath(frame.handle);
+			auto* entry = pack->findEntry(path.wstring());
+			auto metadata = m_metadataIndex.find(path);
+			if (!entry || !metadata || entry->sourceSize != metadata->size || entry->sourceModified != metadata->modified)
+			{
+				return false;
+			}
+		}
+
+		m_framePack = std::make_shared<const FramePack>(std::move(*pack));
+		return true;
+	}
+
+	void AnimationData::applyJournal(Frames& frames, const std::vector<JournalOp>& ops)
+	{
+		for (const auto& op : ops)
+		{
+			const auto size = frames.size();
+			const bool isValid = op.type == JournalOp::Type::Insert ? op.index <= size :
+				op.index < size && (op.type != JournalOp::Type::Move || op.target < size);
+			if (!isValid)
+			{
+				break;
+			}
+
+			switch (op.type)
+			{
+				case JournalOp::Type::Insert:
+					frames.insert(frames.begin() + op.index, Frame{ m_paths.intern(op.path), op.duration });
+					break;
+
+				case JournalOp::Type::Remove:
+					frames.erase(frames.begin() + op.index);
+					break;
+
+				case JournalOp::Type::Move:
 				{
-					this->m_animationFiles[desc.name()] = desc.path();
+					auto frame = frames[op.index];
+					frames.erase(frames.begin() + op.index);
+					frames.insert(frames.begin() + op.target, frame);
+					break;
 				}
-				return desc;
-			});
 
-		return animations;
+				case JournalOp::Type::SetDuration:
+					frames[op.index].duration = op.duration;
+					break;
+			}
+		}
 	}
 
-	AnimationData::Animations AnimationData::loadFromFile(const std::filesystem::path& file)
+	AnimationData::Frames AnimationData::loadFromProject(const ProjectView& project)
 	{
-		std::wifstream input(file.wstring());
-		std::wstring rowData;
-		AnimationData::Animations animations;
-		while (std::getline(input, rowData))
+		// every distinct path is interned once instead of once per frame
+		std::vector<FrameHandle> handles;
+		std::vector<std::optional<FrameSequence>> sequences;
+		handles.reserve(project.pathCount());
+		sequences.resize(project.pathCount());
+		for (std::uint32_t pathIndex = 0; pathIndex < project.pathCount(); ++pathIndex)
+		{
+			if (!project.isSequence(pathIndex))
+			{
+				handles.push_back(m_paths.intern(project.path(pathIndex)));
+				continue;
+			}
+
+			auto descriptor = FrameSequence::parse(project.path(pathIndex));
+			if (!descriptor)
+			{
+				throw std::exception("invalid sequence descriptor");
+			}
+			handles.push_back(PathPool::invalidHandle);
+			sequences[pathIndex] = std::move(descriptor->sequence);
+		}
+
+		Frames frames;
+		frames.reserve(project.frameCount());
+		for (std::uint32_t frame = 0; frame < project.frameCount(); ++frame)
+		{
+			const auto pathIndex = project.pathIndex(frame);
+			if (const auto& sequence = sequences[pathIndex]; sequence)
+			{
+				appendSequence(*sequence, project.duration(frame), frames);
+				continue;
+			}
+			frames.push_back(Frame{ handles[pathIndex], project.duration(frame) });
+		}
+
+		return frames;
+	}
+
+	AnimationData::Frames AnimationData::loadFromTextFile(const std::filesystem::path& file)
+	{
+		auto mappedFile = MappedFile::open(file);
+		if (!mappedFile)
+		{
+			return {};
+		}
+
+		auto rows = TextProjectParser::parse(std::string_view{ reinterpret_cast<const char*>(mappedFile->data()), mappedFile->size() });
+
+		Frames frames;
+		frames.reserve(rows.size());
+		std::unordered_map<std::string_view, FrameHandle> knownPaths;
+		std::wstring filepath;
+		for (const auto& row : rows)
 		{
-			if (!rowData.empty())
+			if (row.isSequence)
 			{
-				AnimationDescription desc{ std::wstring_view{rowData} };
-				auto it = m_animationFiles.find(desc.name());
-				if (it == m_animationFiles.end())
+				filepath.resize(row.path.size());
+				std::transform(row.path.begin(), row.path.end(), filepath.begin(),
+					[](char symbol) { return static_cast<wchar_t>(static_cast<unsigned char>(symbol)); });
+				auto descriptor = FrameSequence::parse(filepath);
+				if (!descriptor)
 				{
-					m_animationFiles[desc.name()] = desc.path().wstring();
+					throw std::exception("invalid sequence descriptor");
 				}
-				
-				animations.emplace_back( std::move(desc) );
+				appendSequence(descriptor->sequence, std::chrono::milliseconds{ row.durationMs }, frames);
+				continue;
 			}
+
+			auto [it, isInserted] = knownPaths.try_emplace(row.path, PathPool::invalidHandle);
+			if (isInserted)
+			{
+				// wifstream in the "C" locale widens every byte as is
+				filepath.resize(row.path.size());
+				std::transform(row.path.begin(), row.path.end(), filepath.begin(),
+					[](char symbol) { return static_cast<wchar_t>(static_cast<unsigned char>(symbol)); });
+				it->second = m_paths.intern(filepath);
+			}
+
+			frames.push_back(Frame{ it->second, std::chrono::milliseconds{ row.durationMs } });
 		}
 
-		return animations;
+		return frames;
 	}
 
-	std::optional<std::filesystem::path> AnimationData::getAnimationFilePath(std::wstring_view name) const
+	std::wstring AnimationData::getName(FrameHandle handle) const
 	{
-		if (auto it = m_animationFiles.find(std::wstring(name)); it != m_animationFiles.end())
+		return getAnimationFilePath(handle).filename().wstring();
+	}
+
+	std::optional<ImageInfo> AnimationData::getImageInfo(FrameHandle handle) const
+	{
+		if (auto it = m_imageInfos.find(handle); it != m_imageInfos.end())
+		{
+			return it->second;
+		}
+
+		if (const auto* range = findSequence(handle); range && range->info)
 		{
-			return std::optional<std::filesystem::path>{ std::in_place, it->second };
+			return range->info;
+		}
+
+		if (auto metadata = getFileMetadata(handle); metadata && metadata->info.format != ImageFormat::Unknown)
+		{
+			return metadata->info;
 		}
 
 		return std::nullopt;
 	}
 
-	/*bool AnimationData::update(std::wstring_view animationName, std::wstring_view duration)
+	std::optional<FileMetadata> AnimationData::getFileMetadata(FrameHandle handle) const
+	{
+		return m_metadataIndex.find(getAnimationFilePath(handle));
+	}
+
+	std::vector<std::filesystem::path> AnimationData::getFolders() const
 	{
-		auto it = std::find_if(animations.begin(), animations.end(),
-								[animationName]( const auto& animation)
-								{ return animationName == animation.name(); });
-		if (it != animations.end())
+		std::set<std::filesystem::path> folders;
+		for (FrameHandle handle = 0; handle < m_paths.size(); ++handle)
 		{
-			it->setDuration(duration);
-			return true;
+			folders.insert(getAnimationFilePath(handle).parent_path());
 		}
-
-		return false;
-	}*/
+		for (const auto& range : m_sequences)
+		{
+			folders.insert(range.sequence.path(0).parent_path());
+		}
+		return std::vector<std::filesystem::path>(folders.begin(), folders.end());
+	}
 }
\ No newline at end of file
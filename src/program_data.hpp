@@ -1,10 +1,20 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <filesystem>
 #include <string>
 #include <unordered_map>
 #include <optional>
+#include <vector>
+
+#include "cancellation_token.hpp"
+#include "folder_scanner.hpp"
+#include "frame_pack.hpp"
+#include "frame_sequence.hpp"
+#include "image_probe.hpp"
+#include "metadata_index.hpp"
+#include "path_pool.hpp"
 
 namespace SAV
 {
@@ -23,47 +33,118 @@ namespace SAV
 			AnimationDescription{ filepath.wstring(), std::chrono::milliseconds{ 0 } }
 		{}
 
-		AnimationDescription(std::wstring_view filepath, std::wstring_view duration) :
-			AnimationDescription{filepath, toMs(duration)}
-		{}
-
-		explicit AnimationDescription(std::wstring_view rowData);
-
 		std::wstring name() const;
 		const std::chrono::milliseconds& duration() const { return m_duration; };
 		std::filesystem::path path() const { return std::filesystem::path{m_filepath}; }
 
 		std::wstring toRowData() const;
 
-		void setDuration(std::wstring_view duration) { m_duration = toMs(duration); }
-
-	private:
-		static std::chrono::milliseconds toMs(std::wstring_view duration);
-
 	private:
 		std::wstring m_filepath;
 		std::chrono::milliseconds m_duration;
 	};
 
 
+	enum class ProjectFormat : std::uint32_t
+	{
+		Binary, // .sav v2, see project_file.hpp
+		Text    // one "path;duration" row per frame or a sequence descriptor per run
+	};
+
+	// A saved row, one image or a run of sequence frames sharing the duration
+	struct ProjectRow
+	{
+		std::wstring path; // the sequence descriptor for runs
+		std::chrono::milliseconds duration;
+		bool isSequence;
+	};
+	using ProjectRows = std::vector<ProjectRow>;
+
+	class ProjectView;
+	struct JournalOp;
+
 	class AnimationData
 	{
 	public:
 		using Animations = std::vector<AnimationDescription>;
+		using FrameHandle = PathPool::Handle;
+
+		// A project row: the interned image path and how long it is shown
+		struct Frame
+		{
+			FrameHandle handle;
+			std::chrono::milliseconds duration;
+		};
+		using Frames = std::vector<Frame>;
+
+		// Handles from here on are frames of sequences, their paths are never stored
+		inline static constexpr FrameHandle sequenceHandleBase = 0x8000'0000;
 
 	public:
-		std::optional<std::filesystem::path> getAnimationFilePath(std::wstring_view name) const;
+		std::filesystem::path getAnimationFilePath(FrameHandle handle) const;
+		// What the list shows, different folders may hold files with the same name
+		std::wstring getName(FrameHandle handle) const;
+		// Known for images added through a folder scan and for frames of a loaded or saved project
+		std::optional<ImageInfo> getImageInfo(FrameHandle handle) const;
+		std::optional<FileMetadata> getFileMetadata(FrameHandle handle) const;
+		// The files of a loaded or saved project are read on a worker, the handler is called when they are done
+		// and collectMetadata() then takes them on the window thread. Without a handler they are read right away.
+		void setOnMetadataReady(const MetadataIndex::OnReady& onReady) { m_metadataIndex.setOnReady(onReady); }
+		void collectMetadata();
+		// Every folder a known image lives in
+		std::vector<std::filesystem::path> getFolders() const;
+
+		Animations toAnimations(const Frames& frames) const;
+		// Runs of consecutive sequence frames with the same duration become one descriptor row
+		ProjectRows toProjectRows(const Frames& frames) const;
+
+		// Files that aren't images are skipped, numbered runs are kept as sequences
+		Frames loadFromFolder(const std::filesystem::path& folder, const CancellationToken& cancellationToken = {});
+		Frames addScannedImages(std::vector<ScannedImage>&& images);
+		// Accepts both formats, the binary one is recognized by its header.
+		// Edits autosaved to the journal of the project are replayed on top.
+		Frames loadFromFile(const std::filesystem::path& file);
+
+		void saveToFile(const std::filesystem::path& file, const Frames& frames, ProjectFormat format = ProjectFormat::Binary);
+
+		// The pack next to the project, loadFromFile opens it if it is not older than the frame files
+		FramePackPtr getFramePack() const { return m_framePack; }
+		bool buildFramePack(const std::filesystem::path& project, const Frames& frames);
+		bool openFramePack(const std::filesystem::path& project, const Frames& frames);
+		void dropFramePack() { m_framePack.reset(); }
+
+	private:
+		Frames loadFromTextFile(const std::filesystem::path& file);
+		Frames loadFromProject(const ProjectView& project);
+		// Stops at the first edit which doesn't fit the frames
+		void applyJournal(Frames& frames, const std::vector<JournalOp>& ops);
 
-		Animations loadFromFolder(const std::filesystem::path& folder);
-		Animations loadFromFile(const std::filesystem::path& file);
+		// Keeps the sidecar index next to the project in sync with the frames it uses
+		void updateMetadataIndex(const std::filesystem::path& file, const Frames& frames);
 
-		void saveToFile(const std::filesystem::path& file, const std::vector<std::vector<std::wstring>>& rawAnimationData) const;
+		// Returns the handle of the first frame. The frames of a registered sequence are reused and
+		// a sequence continuing the last registered one extends it, so its handles stay consecutive.
+		FrameHandle addSequence(const FrameSequence& sequence, const std::optional<ImageInfo>& info = std::nullopt);
+		void appendSequence(const FrameSequence& sequence, std::chrono::milliseconds duration, Frames& frames,
+			const std::optional<ImageInfo>& info = std::nullopt);
 
 	private:
-		void saveToFile(const std::filesystem::path& file, const Animations& animations) const;
+		struct SequenceRange
+		{
+			FrameSequence sequence;
+			FrameHandle firstHandle;
+			std::optional<ImageInfo> info; // of the first frame, a run is taken to be uniform
+		};
+
+		const SequenceRange* findSequence(FrameHandle handle) const;
 
 	private:
-		std::unordered_map<std::wstring, std::wstring> m_animationFiles;
+		PathPool m_paths;
+		std::vector<SequenceRange> m_sequences; // ordered by their handles
+		FrameHandle m_nextSequenceHandle = sequenceHandleBase;
+		std::unordered_map<FrameHandle, ImageInfo> m_imageInfos;
+		MetadataIndex m_metadataIndex;
+		std::filesystem::path m_metadataFile;
+		FramePackPtr m_framePack;
 	};
-
 }
@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <fstream>
+#include <unordered_map>
+
+#include "project_file.hpp"
+#include "utils.hpp"
+
+namespace
+{
+	constexpr std::uint64_t alignTo8(std::uint64_t value)
+	{
+		return (value + 7) & ~std::uint64_t{ 7 };
+	}
+}
+
+namespace SAV
+{
+	namespace ProjectFile
+	{
+		bool write(const std::filesystem::path& file, const ProjectRows& rows)
+		{
+			std::vector<std::wstring> paths;
+			std::vector<std::uint32_t> pathFlags;
+			std::vector<FrameRecord> frames;
+			std::unordered_map<std::wstring, std::uint32_t> pathIndices;
+
+			frames.reserve(rows.size());
+			for (const auto& row : rows)
+			{
+				auto [it, isInserted] = pathIndices.try_emplace(row.path, static_cast<std::uint32_t>(paths.size()));
+				if (isInserted)
+				{
+					paths.push_back(it->first);
+					pathFlags.push_back(row.isSequence ? SequencePath : 0);
+				}
+				frames.push_back(FrameRecord{ it->second, static_cast<std::uint32_t>(row.duration.count()) });
+			}
+
+			const bool hasSequences = std::any_of(rows.begin(), rows.end(), [](const auto& row) { return row.isSequence; });
+			Header header = { magic, hasSequences ? sequenceVersion : version, static_cast<std::uint32_t>(frames.size()), static_cast<std::uint32_t>(paths.size()), sizeof(Header), 0 };
+
+			std::vector<PathEntry> pathTable;
+			pathTable.reserve(paths.size());
+			std::uint64_t offset = header.pathTableOffset + paths.size() * sizeof(PathEntry);
+			for (std::size_t index = 0; index < paths.size(); ++index)
+			{
+				pathTable.push_back(PathEntry{ offset, static_cast<std::uint32_t>(paths[index].size()), pathFlags[index] });
+				offset += paths[index].size() * sizeof(wchar_t);
+			}
+			const auto pathDataEnd = offset;
+			header.framesOffset = alignTo8(pathDataEnd);
+
+			std::ofstream output(file, std::ios_base::binary | std::ios_base::trunc);
+			Utils::writeValue(output, header);
+			output.write(reinterpret_cast<const char*>(pathTable.data()), static_cast<std::streamsize>(pathTable.size() * sizeof(PathEntry)));
+			for (const auto& path : paths)
+			{
+				output.write(reinterpret_cast<const char*>(path.data()), static_cast<std::streamsize>(path.size() * sizeof(wchar_t)));
+			}
+			Utils::writePadding(output, header.framesOffset - pathDataEnd);
+			output.write(reinterpret_cast<const char*>(frames.data()), static_cast<std::streamsize>(frames.size() * sizeof(FrameRecord)));
+
+			return static_cast<bool>(output);
+		}
+	}
+
+	std::optional<ProjectView> ProjectView::open(const std::filesystem::path& file)
+	{
+		auto mappedFile = MappedFile::open(file);
+		if (!mappedFile)
+		{
+			return std::nullopt;
+		}
+
+		ProjectView view{ std::move(*mappedFile) };
+		if (!view.validate())
+		{
+			return std::nullopt;
+		}
+		return std::optional<ProjectView>{ std::move(view) };
+	}
+
+	bool ProjectView::validate() const
+	{
+		const auto size = static_cast<std::uint64_t>(m_file.size());
+		if (size < sizeof(ProjectFile::Header))
+		{
+			return false;
+		}
+
+		const auto& fileHeader = header();
+		if (fileHeader.magic != ProjectFile::magic ||
+			(fileHeader.version != ProjectFile::version && fileHeader.version != ProjectFile::sequenceVersion))
+		{
+			return false;
+		}
+
+		if (fileHeader.pathTableOffset % alignof(ProjectFile::PathEntry) != 0 ||
+			!Utils::isRangeInside(fileHeader.pathTableOffset, fileHeader.pathCount, sizeof(ProjectFile::PathEntry), size))
+		{
+			return false;
+		}
+
+		if (fileHeader.framesOffset % alignof(ProjectFile::FrameRecord) != 0 ||
+			!Utils::isRangeInside(fileHeader.framesOffset, fileHeader.frameCount, sizeof(ProjectFile::FrameRecord), size))
+		{
+			return false;
+		}
+
+		for (std::uint32_t index = 0; index < fileHeader.pathCount; ++index)
+		{
+			const auto& entry = pathTable()[index];
+			if (entry.offset % sizeof(wchar_t) != 0 || !Utils::isRangeInside(entry.offset, entry.length, sizeof(wchar_t), size) ||
+				(fileHeader.version == ProjectFile::version && entry.flags != 0))
+			{
+				return false;
+			}
+		}
+
+		// path indices are checked once here so accessors may trust them
+		for (std::uint32_t frame = 0; frame < fileHeader.frameCount; ++frame)
+		{
+			if (frames()[frame].pathIndex >= fileHeader.pathCount)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	std::wstring_view ProjectView::path(std::uint32_t pathIndex) const
+	{
+		const auto& entry = pathTable()[pathIndex];
+		return std::wstring_view{ reinterpret_cast<const wchar_t*>(m_file.data() + entry.offset), entry.length };
+	}
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "program_data.hpp"
+
+namespace SAV
+{
+	// Binary project format (.sav v2). All integers are little endian, paths are UTF-16.
+	//
+	//   Header
+	//   PathEntry[pathCount]    offset and length of every distinct path
+	//   wchar_t[]               path characters, padded to 8 bytes
+	//   FrameRecord[frameCount] index into the path table and duration of every frame
+	//
+	// Version 3 has the same layout. A path entry flagged as a sequence holds a FrameSequence
+	// descriptor and a record pointing to it stands for all frames of the run. Projects without
+	// sequences are still written as version 2.
+	//
+	// The file is used in place through a memory mapping, nothing is parsed on load.
+	namespace ProjectFile
+	{
+		static_assert(sizeof(wchar_t) == sizeof(char16_t), "paths are stored as UTF-16");
+
+		inline constexpr std::array<char, 4> magic = { 'S', 'A', 'V', '2' };
+		inline constexpr std::uint32_t version = 2;
+		inline constexpr std::uint32_t sequenceVersion = 3;
+
+		enum PathFlags : std::uint32_t
+		{
+			SequencePath = 0x1
+		};
+
+		struct Header
+		{
+			std::array<char, 4> magic;
+			std::uint32_t version;
+			std::uint32_t frameCount;
+			std::uint32_t pathCount;
+			std::uint64_t pathTableOffset;
+			std::uint64_t framesOffset;
+		};
+
+		struct PathEntry
+		{
+			std::uint64_t offset;
+			std::uint32_t length;
+			std::uint32_t flags; // PathFlags, always 0 in version 2
+		};
+
+		struct FrameRecord
+		{
+			std::uint32_t pathIndex;
+			std::uint32_t durationMs;
+		};
+
+		static_assert(sizeof(Header) == 32 && sizeof(PathEntry) == 16 && sizeof(FrameRecord) == 8, "the layout is part of the format");
+
+		bool write(const std::filesystem::path& file, const ProjectRows& rows);
+	}
+
+	// Read-only access to a mapped .sav v2 file
+	class ProjectView
+	{
+	public:
+		// Returns nullopt if the file is not a valid v2 project
+		static std::optional<ProjectView> open(const std::filesystem::path& file);
+
+		std::uint32_t frameCount() const { return header().frameCount; }
+		std::uint32_t pathCount() const { return header().pathCount; }
+
+		std::uint32_t pathIndex(std::uint32_t frame) const { return frames()[frame].pathIndex; }
+		std::chrono::milliseconds duration(std::uint32_t frame) const { return std::chrono::milliseconds{ frames()[frame].durationMs }; }
+
+		std::wstring_view path(std::uint32_t pathIndex) const;
+		// The path is a sequence descriptor and a frame record using it covers every frame of the run
+		bool isSequence(std::uint32_t pathIndex) const { return (pathTable()[pathIndex].flags & ProjectFile::SequencePath) != 0; }
+		std::wstring_view framePath(std::uint32_t frame) const { return path(pathIndex(frame)); }
+
+	private:
+		explicit ProjectView(MappedFile&& file) :
+			m_file{ std::move(file) }
+		{}
+
+		bool validate() const;
+
+		const ProjectFile::Header& header() const { return *reinterpret_cast<const ProjectFile::Header*>(m_file.data()); }
+		const ProjectFile::PathEntry* pathTable() const
+		{
+			return reinterpret_cast<const ProjectFile::PathEntry*>(m_file.data() + header().pathTableOffset);
+		}
+		const ProjectFile::FrameRecord* frames() const
+		{
+			return reinterpret_cast<const ProjectFile::FrameRecord*>(m_file.data() + header().framesOffset);
+		}
+
+	private:
+		MappedFile m_file;
+	};
+}
@@ -0,0 +1,462 @@
+#include <algorithm>
+#include <cstring>
+#include <exception>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.hpp"
+#include "project_file.hpp"
+#include "project_journal.hpp"
+#include "utils.hpp"
+
+namespace
+{
+	struct Journal
+	{
+		std::vector<SAV::JournalOp> ops;
+		std::uint64_t validSize; // the header and every complete record
+	};
+
+	std::filesystem::path nextPath(const std::filesystem::path& project)
+	{
+		auto path = SAV::ProjectJournalFile::journalPath(project);
+		path += SAV::ProjectJournalFile::nextExtension;
+		return path;
+	}
+
+	std::uint32_t checksum(SAV::ProjectJournalFile::Record record, const wchar_t* path)
+	{
+		record.checksum = 0;
+		auto hash = SAV::Utils::hash(record);
+		hash = SAV::Utils::hash(path, record.pathLength * sizeof(wchar_t), hash);
+		return static_cast<std::uint32_t>(hash ^ (hash >> 32));
+	}
+
+	template<typename T>
+	void appendBytes(std::vector<std::byte>& bytes, const T* data, std::size_t count)
+	{
+		auto* first = reinterpret_cast<const std::byte*>(data);
+		bytes.insert(bytes.end(), first, first + count * sizeof(T));
+	}
+
+	void encode(const SAV::JournalOp& op, std::vector<std::byte>& bytes)
+	{
+		SAV::ProjectJournalFile::Record record{ static_cast<std::uint32_t>(op.type), op.index, op.target,
+			static_cast<std::uint32_t>(op.duration.count()), static_cast<std::uint32_t>(op.path.size()), 0 };
+		record.checksum = checksum(record, op.path.data());
+
+		appendBytes(bytes, &record, 1);
+		appendBytes(bytes, op.path.data(), op.path.size());
+	}
+
+	std::vector<std::byte> encode(const SAV::Utils::FileStamp& stamp)
+	{
+		SAV::ProjectJournalFile::Header header{ SAV::ProjectJournalFile::magic, SAV::ProjectJournalFile::version, stamp.size, stamp.modified };
+
+		std::vector<std::byte> bytes;
+		appendBytes(bytes, &header, 1);
+		return bytes;
+	}
+
+	// nullopt if the file is missing or belongs to another version of the project
+	std::optional<Journal> readJournal(const std::filesystem::path& file, const SAV::Utils::FileStamp& stamp)
+	{
+		using namespace SAV::ProjectJournalFile;
+
+		auto mappedFile = SAV::MappedFile::open(file);
+		if (!mappedFile || mappedFile->size() < sizeof(Header))
+		{
+			return std::nullopt;
+		}
+
+		const auto& header = *reinterpret_cast<const Header*>(mappedFile->data());
+		if (header.magic != magic || header.version != version || header.projectSize != stamp.size || header.projectModified != stamp.modified)
+		{
+			return std::nullopt;
+		}
+
+		Journal journal{ {}, sizeof(Header) };
+		const auto size = static_cast<std::uint64_t>(mappedFile->size());
+		while (journal.validSize + sizeof(Record) <= size)
+		{
+			// records follow the path characters without padding, so they are copied out
+			Record record;
+			std::memcpy(&record, mappedFile->data() + journal.validSize, sizeof(Record));
+
+			const auto pathOffset = journal.validSize + sizeof(Record);
+			const auto end = pathOffset + static_cast<std::uint64_t>(record.pathLength) * sizeof(wchar_t);
+			if (end > size || record.type > static_cast<std::uint32_t>(SAV::JournalOp::Type::SetDuration))
+			{
+				break;
+			}
+
+			std::wstring path(record.pathLength, L'\0');
+			std::memcpy(path.data(), mappedFile->data() + pathOffset, path.size() * sizeof(wchar_t));
+			if (checksum(record, path.data()) != record.checksum)
+			{
+				break;
+			}
+
+			journal.ops.push_back(SAV::JournalOp{ static_cast<SAV::JournalOp::Type>(record.type), record.index, record.target,
+				std::chrono::milliseconds{ record.durationMs }, std::move(path) });
+			journal.validSize = end;
+		}
+		return journal;
+	}
+}
+
+namespace SAV
+{
+	// The journal opened for appending, everything after the start offset is cut off
+	class ProjectJournal::File
+	{
+	public:
+		static std::unique_ptr<File> open(const std::filesystem::path& path, std::uint64_t offset)
+		{
+#ifdef _WIN32
+			HANDLE handle = ::CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (handle == INVALID_HANDLE_VALUE)
+			{
+				return nullptr;
+			}
+
+			LARGE_INTEGER position;
+			position.QuadPart = static_cast<LONGLONG>(offset);
+			if (!::SetFilePointerEx(handle, position, nullptr, FILE_BEGIN) || !::SetEndOfFile(handle))
+			{
+				::CloseHandle(handle);
+				return nullptr;
+			}
+			return std::unique_ptr<File>{ new File{ handle } };
+#else
+			int descriptor = ::open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+			if (descriptor < 0)
+			{
+				return nullptr;
+			}
+
+			if (::ftruncate(descriptor, static_cast<off_t>(offset)) != 0 || ::lseek(descriptor, static_cast<off_t>(offset), SEEK_SET) < 0)
+			{
+				::close(descriptor);
+				return nullptr;
+			}
+			return std::unique_ptr<File>{ new File{ descriptor } };
+#endif
+		}
+
+		~File()
+		{
+#ifdef _WIN32
+			::CloseHandle(m_handle);
+#else
+			::close(m_descriptor);
+#endif
+		}
+
+		File(const File&) = delete;
+		File& operator=(const File&) = delete;
+
+		bool write(const std::vector<std::byte>& bytes)
+		{
+			std::size_t written = 0;
+			while (written < bytes.size())
+			{
+#ifdef _WIN32
+				DWORD count = 0;
+				const auto chunk = static_cast<DWORD>((std::min<std::size_t>)(bytes.size() - written, MAXDWORD));
+				if (!::WriteFile(m_handle, bytes.data() + written, chunk, &count, nullptr))
+				{
+					return false;
+				}
+#else
+				auto count = ::write(m_descriptor, bytes.data() + written, bytes.size() - written);
+				if (count < 0)
+				{
+					return false;
+				}
+#endif
+				written += static_cast<std::size_t>(count);
+			}
+			return true;
+		}
+
+		// Returns once the written bytes are on the disk
+		bool sync()
+		{
+#ifdef _WIN32
+			return ::FlushFileBuffers(m_handle) != FALSE;
+#else
+			return ::fsync(m_descriptor) == 0;
+#endif
+		}
+
+	private:
+#ifdef _WIN32
+		explicit File(HANDLE handle) :
+			m_handle{ handle }
+		{}
+
+		HANDLE m_handle;
+#else
+		explicit File(int descriptor) :
+			m_descriptor{ descriptor }
+		{}
+
+		int m_descriptor;
+#endif
+	};
+
+	namespace ProjectJournalFile
+	{
+		std::filesystem::path journalPath(const std::filesystem::path& project)
+		{
+			auto path = project;
+			path += extension;
+			return path;
+		}
+
+		std::vector<JournalOp> read(const std::filesystem::path& project)
+		{
+			auto stamp = Utils::stampOf(project);
+			if (!stamp)
+			{
+				return {};
+			}
+
+			// a compaction may have stopped after replacing the project but before replacing the journal
+			for (const auto& file : { journalPath(project), nextPath(project) })
+			{
+				if (auto journal = readJournal(file, *stamp); journal)
+				{
+					return std::move(journal->ops);
+				}
+			}
+			return {};
+		}
+
+		void remove(const std::filesystem::path& project)
+		{
+			std::error_code ec;
+			std::filesystem::remove(journalPath(project), ec);
+			std::filesystem::remove(nextPath(project), ec);
+		}
+	}
+
+	ProjectJournal::ProjectJournal(const std::filesystem::path& project, const OnError& onError) :
+		m_project{ project },
+		m_journalPath{ ProjectJournalFile::journalPath(project) },
+		m_onError{ onError }
+	{
+		auto stamp = Utils::stampOf(m_project);
+		if (!stamp)
+		{
+			throw std::exception("the project file is missing");
+		}
+
+		std::error_code ec;
+		std::uint64_t offset = 0;
+		if (auto journal = readJournal(m_journalPath, *stamp); journal)
+		{
+			offset = journal->validSize;
+		}
+		else if (auto next = readJournal(nextPath(m_project), *stamp); next)
+		{
+			std::filesystem::rename(nextPath(m_project), m_journalPath, ec);
+			offset = ec ? 0 : next->validSize;
+		}
+		std::filesystem::remove(nextPath(m_project), ec);
+
+		m_file = File::open(m_journalPath, offset);
+		if (!m_file)
+		{
+			throw std::exception("can't open the project journal");
+		}
+
+		if (offset == 0)
+		{
+			auto header = encode(*stamp);
+			if (!m_file->write(header) || !m_file->sync())
+			{
+				throw std::exception("can't write the project journal");
+			}
+			offset = header.size();
+		}
+		m_journalSize = offset;
+
+		m_writer = std::thread(&ProjectJournal::run, this);
+	}
+
+	ProjectJournal::~ProjectJournal()
+	{
+		if (m_compaction.joinable())
+		{
+			m_compaction.join();
+		}
+
+		{
+			std::lock_guard guard(m_mutex);
+			m_isStopped = true;
+		}
+		m_condition.notify_all();
+		m_writer.join();
+	}
+
+	void ProjectJournal::append(const JournalOp& op)
+	{
+		std::lock_guard guard(m_mutex);
+		encode(op, m_pending);
+		if (m_isCompacting)
+		{
+			encode(op, m_tail);
+		}
+
+		if (m_pending.size() >= maxBatchSize)
+		{
+			m_condition.notify_all();
+		}
+	}
+
+	void ProjectJournal::flush()
+	{
+		std::unique_lock lock(m_mutex);
+		const auto request = ++m_flushRequests;
+		m_condition.notify_all();
+		m_condition.wait(lock, [this, request]() { return m_flushedRequests >= request || m_isStopped; });
+	}
+
+	bool ProjectJournal::needsCompaction() const
+	{
+		std::lock_guard guard(m_mutex);
+		return !m_isCompacting && m_journalSize + m_pending.size() > compactionThreshold;
+	}
+
+	void ProjectJournal::compact(ProjectRows&& rows)
+	{
+		{
+			std::lock_guard guard(m_mutex);
+			if (m_isCompacting)
+			{
+				return;
+			}
+			m_isCompacting = true;
+			m_tail.clear();
+		}
+
+		if (m_compaction.joinable())
+		{
+			m_compaction.join();
+		}
+		m_compaction = std::thread(&ProjectJournal::compactProject, this, std::move(rows));
+	}
+
+	void ProjectJournal::run()
+	{
+		std::unique_lock lock(m_mutex);
+		while (true)
+		{
+			m_condition.wait_for(lock, flushInterval,
+				[this]() { return m_isStopped || m_flushRequests != m_flushedRequests || m_pending.size() >= maxBatchSize; });
+			const bool isStopped = m_isStopped;
+
+			lock.unlock();
+			writeBatch();
+			lock.lock();
+
+			if (isStopped)
+			{
+				break;
+			}
+		}
+	}
+
+	void ProjectJournal::writeBatch()
+	{
+		// the file lock is held from taking the batch until it is written, so a compaction never sees
+		// a batch which is neither pending nor in the file
+		std::lock_guard fileGuard(m_fileMutex);
+
+		std::vector<std::byte> batch;
+		std::uint64_t served = 0;
+		{
+			std::lock_guard guard(m_mutex);
+			batch.swap(m_pending);
+			served = m_flushRequests;
+		}
+
+		const bool isWritten = batch.empty() || (m_file && m_file->write(batch) && m_file->sync());
+		if (!isWritten)
+		{
+			m_onError(Error::Write);
+		}
+
+		{
+			std::lock_guard guard(m_mutex);
+			// the size counts only what is in the file, the journal is reopened at it
+			if (isWritten)
+			{
+				m_journalSize += batch.size();
+			}
+			m_flushedRequests = served;
+		}
+		m_condition.notify_all();
+	}
+
+	void ProjectJournal::compactProject(ProjectRows rows)
+	{
+		auto snapshot = m_project;
+		snapshot += L".tmp";
+		const auto next = nextPath(m_project);
+
+		std::optional<Utils::FileStamp> stamp;
+		if (ProjectFile::write(snapshot, rows))
+		{
+			stamp = Utils::stampOf(snapshot);
+		}
+
+		std::lock_guard fileGuard(m_fileMutex);
+		std::lock_guard guard(m_mutex);
+
+		// the edits made while the snapshot was written start the new journal
+		auto bytes = stamp ? encode(*stamp) : std::vector<std::byte>{};
+		bytes.insert(bytes.end(), m_tail.begin(), m_tail.end());
+		m_tail.clear();
+		m_isCompacting = false;
+
+		auto nextFile = stamp ? File::open(next, 0) : nullptr;
+		if (!nextFile || !nextFile->write(bytes) || !nextFile->sync())
+		{
+			std::error_code ec;
+			std::filesystem::remove(snapshot, ec);
+			std::filesystem::remove(next, ec);
+			m_onError(Error::Compaction);
+			return;
+		}
+		nextFile.reset();
+
+		// from here on the old journal no longer matches, the next one takes over
+		m_file.reset();
+		std::error_code ec;
+		std::filesystem::rename(snapshot, m_project, ec);
+		if (ec)
+		{
+			std::filesystem::remove(snapshot, ec);
+			std::filesystem::remove(next, ec);
+			m_file = File::open(m_journalPath, m_journalSize);
+			m_onError(Error::Replace);
+			return;
+		}
+
+		std::filesystem::rename(next, m_journalPath, ec);
+		m_file = File::open(ec ? next : m_journalPath, bytes.size());
+
+		// everything pending is either part of the snapshot or of the tail
+		m_pending.clear();
+		m_journalSize = bytes.size();
+	}
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "program_data.hpp"
+
+namespace SAV
+{
+	// One edit of the frame list
+	struct JournalOp
+	{
+		enum class Type : std::uint32_t
+		{
+			Insert,     // path and duration of the new frame at index
+			Remove,     // the frame at index
+			Move,       // the frame at index is taken out and inserted at target
+			SetDuration // duration of the frame at index
+		};
+
+		Type type;
+		std::uint32_t index;
+		std::uint32_t target;
+		std::chrono::milliseconds duration;
+		std::wstring path;
+	};
+
+	// Journal of the edits made since the project file was written (<project>.savjournal).
+	// All integers are little endian, paths are UTF-16.
+	//
+	//   Header      size and modification time of the project file the edits apply to
+	//   Record...   one per edit, the path characters of an insert follow its record
+	//
+	// A record which is cut off or fails its checksum ends the journal. A compaction writes the new
+	// project file and <project>.savjournal.next with the edits made meanwhile, then both replace the
+	// old files. Whichever of the two journals matches the project file is the valid one.
+	namespace ProjectJournalFile
+	{
+		inline constexpr std::array<char, 4> magic = { 'S', 'A', 'V', 'J' };
+		inline constexpr std::uint32_t version = 1;
+		inline constexpr std::wstring_view extension = L".savjournal";
+		inline constexpr std::wstring_view nextExtension = L".next";
+
+		struct Header
+		{
+			std::array<char, 4> magic;
+			std::uint32_t version;
+			std::uint64_t projectSize;
+			std::int64_t projectModified; // last write time in file clock ticks
+		};
+
+		struct Record
+		{
+			std::uint32_t type;
+			std::uint32_t index;
+			std::uint32_t target;
+			std::uint32_t durationMs;
+			std::uint32_t pathLength;
+			std::uint32_t checksum; // FNV-1a of the record with this field zeroed and the path
+		};
+
+		static_assert(sizeof(Header) == 24 && sizeof(Record) == 24, "the layout is part of the format");
+
+		std::filesystem::path journalPath(const std::filesystem::path& project);
+
+		// Edits recorded for the project file as it is now, empty if there is no matching journal
+		std::vector<JournalOp> read(const std::filesystem::path& project);
+		void remove(const std::filesystem::path& project);
+	}
+
+	// Autosave of a project. Edits are appended to the journal by a writer thread which flushes
+	// them to the disk in batches, so a crash loses at most the last batch. Past a size threshold
+	// the owner hands over the current rows and the project file is rewritten in the background.
+	class ProjectJournal
+	{
+	public:
+		inline static constexpr std::chrono::milliseconds flushInterval{ 500 };
+		inline static constexpr std::uint64_t compactionThreshold = 4ull * 1024 * 1024;
+		// a larger batch is written without waiting for the interval
+		inline static constexpr std::size_t maxBatchSize = 64 * 1024;
+
+		enum class Error : std::uint32_t
+		{
+			Write,      // edits could not be written to the journal
+			Compaction, // the compacted project could not be written
+			Replace     // the compacted project could not replace the old one
+		};
+		// Called on the writer or the compaction thread, the edits in memory are then the only complete copy
+		using OnError = std::function<void(Error)>;
+
+	public:
+		// Continues the journal matching the project file or starts an empty one.
+		// Throws std::exception if the journal can't be opened.
+		ProjectJournal(const std::filesystem::path& project, const OnError& onError);
+		~ProjectJournal();
+
+		ProjectJournal(const ProjectJournal&) = delete;
+		ProjectJournal& operator=(const ProjectJournal&) = delete;
+
+		void append(const JournalOp& op);
+		// Writes the pending batch and waits until it is on the disk
+		void flush();
+
+		bool needsCompaction() const;
+		// Rows must describe the frames after every edit appended so far
+		void compact(ProjectRows&& rows);
+
+	private:
+		class File;
+
+	private:
+		void run();
+		void writeBatch();
+		void compactProject(ProjectRows rows);
+
+	private:
+		std::filesystem::path m_project;
+		std::filesystem::path m_journalPath;
+		OnError m_onError;
+
+		// guards the file, taken before m_mutex
+		std::mutex m_fileMutex;
+		std::unique_ptr<File> m_file;
+
+		mutable std::mutex m_mutex;
+		std::condition_variable m_condition;
+		std::vector<std::byte> m_pending;
+		std::uint64_t m_journalSize = 0;
+		std::uint64_t m_flushRequests = 0;
+		std::uint64_t m_flushedRequests = 0;
+		bool m_isStopped = false;
+
+		// edits appended after the rows of a running compaction were taken
+		bool m_isCompacting = false;
+		std::vector<std::byte> m_tail;
+
+		std::thread m_compaction;
+		std::thread m_writer;
+	};
+}
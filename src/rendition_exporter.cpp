@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <future>
+#include <mutex>
+
+#include "frame_pipeline.hpp"
+#include "rendition_exporter.hpp"
+
+namespace
+{
+	// The renditions encode the same clip side by side: frames add up, seconds are those of the slowest one
+	SAV::ExportProgress combine(const std::vector<SAV::ExportProgress>& reports)
+	{
+		SAV::ExportProgress combined;
+		for (std::size_t index = 0; index < reports.size(); ++index)
+		{
+			const auto& report = reports[index];
+			combined.framesWritten += report.framesWritten;
+			combined.totalFrames += report.totalFrames;
+			combined.encodedTime = index == 0 ? report.encodedTime : (std::min)(combined.encodedTime, report.encodedTime);
+			combined.totalTime = (std::max)(combined.totalTime, report.totalTime);
+			combined.framesPerSecond += report.framesPerSecond;
+			combined.eta = (std::max)(combined.eta, report.eta);
+
+			combined.decodeTime = (std::max)(combined.decodeTime, report.decodeTime);
+			combined.scaleTime = (std::max)(combined.scaleTime, report.scaleTime);
+			combined.encodeTime = (std::max)(combined.encodeTime, report.encodeTime);
+		}
+		return combined;
+	}
+}
+
+namespace SAV
+{
+	HRESULT RenditionExporter::write(const std::vector<AnimationDescription>& data, const CancellationToken& cancellationToken,
+		const VideoFileCreator::ProgressCallback& progressCallback)
+	{
+		FanOutFrameSource frameSource{ data, m_renditions.size(), cancellationToken, m_pack };
+
+		std::mutex reportsMutex;
+		std::vector<ExportProgress> reports(m_renditions.size());
+		auto lastReport = std::chrono::steady_clock::now() - VideoFileCreator::progressInterval;
+
+		std::vector<std::future<HRESULT>> tasks;
+		for (std::size_t index = 0; index < m_renditions.size(); ++index)
+		{
+			tasks.push_back(std::async(std::launch::async,
+				[&, index]() -> HRESULT
+				{
+					const auto& rendition = m_renditions[index];
+					HRESULT hr = E_FAIL;
+					try
+					{
+						VideoFileCreator vfc{ rendition.filename, rendition.width, rendition.height, rendition.bitrate };
+						hr = vfc.write(data, frameSource.consumer(index), cancellationToken,
+							[&, index](const ExportProgress& progress)
+							{
+								std::lock_guard guard(reportsMutex);
+								reports[index] = progress;
+
+								// every encoder reports at a bounded rate already, the sum must not multiply it
+								auto now = std::chrono::steady_clock::now();
+								if (progressCallback && now - lastReport >= VideoFileCreator::progressInterval)
+								{
+									lastReport = now;
+									progressCallback(combine(reports));
+								}
+							});
+					}
+					catch (const std::exception&)
+					{
+						hr = E_FAIL;
+					}
+
+					frameSource.close(index);
+					return hr;
+				}));
+		}
+
+		HRESULT result = S_OK;
+		for (auto& task : tasks)
+		{
+			auto hr = task.get();
+			if (SUCCEEDED(result) && !SUCCEEDED(hr))
+			{
+				result = hr;
+			}
+		}
+
+		if (progressCallback)
+		{
+			progressCallback(combine(reports));
+		}
+		return result;
+	}
+}
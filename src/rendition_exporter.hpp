@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cancellation_token.hpp"
+#include "frame_pack.hpp"
+#include "program_data.hpp"
+#include "video_file_creator.hpp"
+
+namespace SAV
+{
+	struct Rendition
+	{
+		std::wstring filename;
+		std::uint32_t width;
+		std::uint32_t height;
+		Bitrate bitrate;
+	};
+
+	// Encodes several renditions of the same animation in one pass. Every rendition is scaled and encoded
+	// on its own thread while each source image is decoded once for all of them.
+	class RenditionExporter
+	{
+	public:
+		// Frames found in the pack are read from it
+		explicit RenditionExporter(std::vector<Rendition> renditions, FramePackPtr pack = nullptr) :
+			m_renditions{ std::move(renditions) },
+			m_pack{ std::move(pack) }
+		{}
+
+		// The progress callback gets the frames of all renditions and the seconds of the slowest one,
+		// framesPerSecond is the combined throughput.
+		// Returns the first failure, renditions which succeeded are kept.
+		HRESULT write(const std::vector<AnimationDescription>& data, const CancellationToken& cancellationToken = {},
+			const VideoFileCreator::ProgressCallback& progressCallback = nullptr);
+
+	private:
+		std::vector<Rendition> m_renditions;
+		FramePackPtr m_pack;
+	};
+}
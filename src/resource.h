@@ -21,6 +21,9 @@
 #define ID_CANCEL                       1015
 #define IDC_BUTTON2                     1016
 #define ID_SELECT                       1016
+#define IDC_EXPORT_STATS                1017
+#define IDC_RENDITIONS                  1018
+#define IDC_RENDITIONS_EDIT             1019
 #define ID_IMAGE_ADDFOLDER              40001
 #define ID_PROGRAMM_EXIT                40003
 #define ID_IMAGES_WRITEVIDEO            40004
@@ -31,14 +34,21 @@
 #define ID_FILELISTVIEWPOPUP_COPY       40009
 #define ID_COPY_ITEM                    40010
 #define ID_DELETE_ITEM                  40011
+#define ID_PROGRAMM_EXPORT_TEXT         40012
+#define ID_IMAGE_ADDFOLDER_RECURSIVE    40013
+#define ID_PROGRAMM_BUILD_PACK          40014
+#define ID_PROGRAMM_AUTOSAVE            40015
+#define ID_REVERSE_ITEMS                40016
+#define ID_SCALE_ITEMS                  40017
+#define ID_IMAGES_THUMBNAILS            40018
 
 // Next default values for new objects
 // 
 #ifdef APSTUDIO_INVOKED
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        106
-#define _APS_NEXT_COMMAND_VALUE         40012
-#define _APS_NEXT_CONTROL_VALUE         1017
+#define _APS_NEXT_COMMAND_VALUE         40019
+#define _APS_NEXT_CONTROL_VALUE         1020
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
 #endif
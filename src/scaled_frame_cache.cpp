@@ -0,0 +1,78 @@
+#include "scaled_frame_cache.hpp"
+
+namespace SAV
+{
+	std::wstring ScaledFrameCache::makeKey(const std::filesystem::path& source, std::uint32_t width, std::uint32_t height)
+	{
+		// the same file may be referenced through different spellings of its path,
+		// each spelling is resolved on the file system only the first time it is seen
+		auto [it, isInserted] = m_canonicalPaths.try_emplace(source.wstring());
+		if (isInserted)
+		{
+			std::error_code ec;
+			auto canonical = std::filesystem::weakly_canonical(source, ec);
+			it->second = ec ? it->first : canonical.wstring();
+		}
+
+		std::wstring key = it->second;
+		key += L'|';
+		key += std::to_wstring(width);
+		key += L'x';
+		key += std::to_wstring(height);
+		return key;
+	}
+
+	ScaledFrameCache::Frame ScaledFrameCache::find(const std::filesystem::path& source, std::uint32_t width, std::uint32_t height)
+	{
+		auto it = m_index.find(makeKey(source, width, height));
+		if (it == m_index.end())
+		{
+			return nullptr;
+		}
+
+		m_entries.splice(m_entries.begin(), m_entries, it->second);
+		return it->second->frame;
+	}
+
+	void ScaledFrameCache::insert(const std::filesystem::path& source, std::uint32_t width, std::uint32_t height, const Frame& frame)
+	{
+		const std::uint64_t size = static_cast<std::uint64_t>(width) * height * 4;
+		if (!frame || size > m_budget)
+		{
+			return;
+		}
+
+		auto key = makeKey(source, width, height);
+		if (auto it = m_index.find(key); it != m_index.end())
+		{
+			m_usedBytes -= it->second->size;
+			m_entries.erase(it->second);
+			m_index.erase(it);
+		}
+
+		evict(size);
+
+		m_entries.push_front(Entry{ key, frame, size });
+		m_index.emplace(std::move(key), m_entries.begin());
+		m_usedBytes += size;
+	}
+
+	void ScaledFrameCache::clear()
+	{
+		m_index.clear();
+		m_entries.clear();
+		m_canonicalPaths.clear();
+		m_usedBytes = 0;
+	}
+
+	void ScaledFrameCache::evict(std::uint64_t requiredBytes)
+	{
+		while (!m_entries.empty() && m_usedBytes + requiredBytes > m_budget)
+		{
+			auto& last = m_entries.back();
+			m_usedBytes -= last.size;
+			m_index.erase(last.key);
+			m_entries.pop_back();
+		}
+	}
+}
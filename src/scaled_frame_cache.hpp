@@ -0,0 +1,60 @@
+#pragma once
+#include <Windows.h>
+#include <gdiplus.h>
+#include <gdiplusheaders.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace SAV
+{
+	// Keeps frames already decoded and resampled to the output size so repeated
+	// source images are neither decoded nor scaled again during export.
+	class ScaledFrameCache
+	{
+	public:
+		using Frame = std::shared_ptr<Gdiplus::Bitmap>;
+
+		inline static constexpr std::uint64_t defaultBudget = 512ull * 1024 * 1024;
+
+	public:
+		explicit ScaledFrameCache(std::uint64_t budgetBytes = defaultBudget) :
+			m_budget{ budgetBytes },
+			m_usedBytes{ 0 }
+		{}
+
+		ScaledFrameCache(const ScaledFrameCache&) = delete;
+		ScaledFrameCache& operator=(const ScaledFrameCache&) = delete;
+
+		Frame find(const std::filesystem::path& source, std::uint32_t width, std::uint32_t height);
+		void insert(const std::filesystem::path& source, std::uint32_t width, std::uint32_t height, const Frame& frame);
+		void clear();
+
+		std::uint64_t usedBytes() const { return m_usedBytes; }
+
+	private:
+		struct Entry
+		{
+			std::wstring key;
+			Frame frame;
+			std::uint64_t size;
+		};
+		using Entries = std::list<Entry>;
+
+	private:
+		std::wstring makeKey(const std::filesystem::path& source, std::uint32_t width, std::uint32_t height);
+		void evict(std::uint64_t requiredBytes);
+
+	private:
+		std::uint64_t m_budget;
+		std::uint64_t m_usedBytes;
+		Entries m_entries; // most recently used first
+		std::unordered_map<std::wstring, Entries::iterator> m_index;
+		// the spelling of a source path to its canonical form
+		std::unordered_map<std::wstring, std::wstring> m_canonicalPaths;
+	};
+}
@@ -0,0 +1,195 @@
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define SAV_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <optional>
+#include <thread>
+
+#include "number_parser.hpp"
+#include "text_project_parser.hpp"
+
+namespace
+{
+	constexpr char ROW_DELIM = ';';
+	constexpr char TEXT_END = '\x1A';
+
+	struct ChunkResult
+	{
+		std::vector<SAV::TextProjectParser::Row> rows;
+		bool isValid = true;
+	};
+
+	// "pattern [first-last] @ 41ms", the path part is checked by FrameSequence::parse later
+	std::optional<SAV::TextProjectParser::Row> parseSequenceRow(std::string_view line)
+	{
+		auto rangeEnd = line.rfind(']');
+		if (rangeEnd == std::string_view::npos)
+		{
+			return std::nullopt;
+		}
+
+		auto duration = line.substr(rangeEnd + 1);
+		auto skipSpaces = [&duration]()
+			{
+				while (!duration.empty() && duration.front() == ' ')
+				{
+					duration.remove_prefix(1);
+				}
+			};
+		skipSpaces();
+		if (duration.empty() || duration.front() != '@')
+		{
+			return std::nullopt;
+		}
+		duration.remove_prefix(1);
+		skipSpaces();
+
+		auto durationMs = SAV::NumberParser::parseDuration(duration);
+		if (!durationMs)
+		{
+			return std::nullopt;
+		}
+
+		return SAV::TextProjectParser::Row{ line.substr(0, rangeEnd + 1), *durationMs, true };
+	}
+
+	// A plain row reads its duration like the std::from_chars of the old loader: the leading digits
+	// count and what follows them is ignored, text which doesn't start with a digit or overflows reads
+	// as 0. Only a whole duration with a suffix reads differently, "2s" is 2000 instead of 2.
+	std::uint32_t parsePlainDuration(std::string_view duration)
+	{
+		if (auto durationMs = SAV::NumberParser::parseDuration(duration); durationMs)
+		{
+			return *durationMs;
+		}
+
+		auto digits = duration.substr(0, duration.find_first_not_of("0123456789"));
+		return static_cast<std::uint32_t>(SAV::NumberParser::parseNumber(digits, (std::numeric_limits<std::uint32_t>::max)()).value_or(0));
+	}
+
+	ChunkResult parseChunk(const char* first, const char* last)
+	{
+		ChunkResult result;
+		while (first < last)
+		{
+			auto lineEnd = SAV::TextProjectParser::findNewline(first, last);
+			std::string_view line{ first, static_cast<std::size_t>(lineEnd - first) };
+			first = lineEnd == last ? last : lineEnd + 1;
+
+			// text mode reading turns "\r\n" into "\n", a lone '\r' is kept
+			if (lineEnd != last && !line.empty() && line.back() == '\r')
+			{
+				line.remove_suffix(1);
+			}
+
+			if (line.empty())
+			{
+				continue;
+			}
+
+			if (auto row = parseSequenceRow(line); row)
+			{
+				result.rows.push_back(*row);
+				continue;
+			}
+
+			auto pos = line.find(ROW_DELIM);
+			if (pos == std::string_view::npos)
+			{
+				result.isValid = false;
+				return result;
+			}
+
+			result.rows.push_back({ line.substr(0, pos), parsePlainDuration(line.substr(pos + 1)), false });
+		}
+		return result;
+	}
+}
+
+namespace SAV::TextProjectParser
+{
+	const char* findNewline(const char* first, const char* last)
+	{
+#ifdef SAV_HAS_SSE2
+		const __m128i newline = _mm_set1_epi8('\n');
+		while (last - first >= 16)
+		{
+			const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+			const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+			if (mask != 0)
+			{
+				unsigned long index = 0;
+#ifdef _MSC_VER
+				_BitScanForward(&index, static_cast<unsigned long>(mask));
+#else
+				index = static_cast<unsigned long>(__builtin_ctz(static_cast<unsigned int>(mask)));
+#endif
+				return first + index;
+			}
+			first += 16;
+		}
+#endif
+		return std::find(first, last, '\n');
+	}
+
+	std::vector<Row> parse(std::string_view content)
+	{
+		if (auto end = content.find(TEXT_END); end != std::string_view::npos)
+		{
+			content = content.substr(0, end);
+		}
+
+		const char* first = content.data();
+		const char* last = content.data() + content.size();
+
+		const std::size_t threadCount = std::clamp<std::size_t>(content.size() / minChunkSize, 1, (std::max)(1u, std::thread::hardware_concurrency()));
+
+		// chunk boundaries are moved forward to the next line start so no row is split
+		std::vector<const char*> bounds{ first };
+		for (std::size_t index = 1; index < threadCount; ++index)
+		{
+			const char* bound = (std::max)(bounds.back(), first + content.size() * index / threadCount);
+			bound = findNewline(bound, last);
+			bounds.push_back(bound == last ? last : bound + 1);
+		}
+		bounds.push_back(last);
+
+		std::vector<ChunkResult> results(threadCount);
+		std::vector<std::thread> workers;
+		for (std::size_t index = 1; index < threadCount; ++index)
+		{
+			workers.emplace_back([&results, &bounds, index]()
+				{
+					results[index] = parseChunk(bounds[index], bounds[index + 1]);
+				});
+		}
+		results[0] = parseChunk(bounds[0], bounds[1]);
+
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+
+		std::size_t rowCount = 0;
+		for (const auto& result : results)
+		{
+			if (!result.isValid)
+			{
+				throw std::exception();
+			}
+			rowCount += result.rows.size();
+		}
+
+		std::vector<Row> rows;
+		rows.reserve(rowCount);
+		for (auto& result : results)
+		{
+			rows.insert(rows.end(), result.rows.begin(), result.rows.end());
+		}
+		return rows;
+	}
+}
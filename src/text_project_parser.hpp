@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace SAV
+{
+	// Parser for the text project format, one "path;duration" row per line.
+	// It works on the raw bytes of a mapped file and yields views into them, large inputs are split
+	// at line boundaries and parsed on several threads.
+	// The result is the same as reading the file row by row through std::wifstream in the "C" locale:
+	// CRLF is read as LF, Ctrl+Z ends the text and empty rows are skipped. A duration is read up to the
+	// end of its leading digits, one which doesn't start with a digit reads as 0. A whole duration with
+	// one of the NumberParser suffixes is read with it.
+	// A row like "shot_%05d.exr [1-50000] @ 41ms" describes a whole FrameSequence.
+	namespace TextProjectParser
+	{
+		struct Row
+		{
+			std::string_view path; // "pattern [first-last]" for sequence rows
+			std::uint32_t durationMs;
+			bool isSequence;
+		};
+
+		// inputs smaller than that are not worth a thread
+		inline constexpr std::size_t minChunkSize = 1024 * 1024;
+
+		// Throws std::exception for a non empty row without a delimiter
+		std::vector<Row> parse(std::string_view content);
+
+		// Position of the first '\n' in [first, last) or last
+		const char* findNewline(const char* first, const char* last);
+	}
+}
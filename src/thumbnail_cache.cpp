@@ -0,0 +1,539 @@
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#include "frame_pipeline.hpp"
+#include "thumbnail_cache.hpp"
+#include "utils.hpp"
+
+namespace
+{
+	struct Image
+	{
+		std::uint32_t width;
+		std::uint32_t height;
+		std::vector<std::uint32_t> pixels;
+	};
+
+	// Channel sums of ARGB pixels
+	struct PixelSum
+	{
+		void add(std::uint32_t pixel)
+		{
+			alpha += pixel >> 24;
+			red += (pixel >> 16) & 0xFF;
+			green += (pixel >> 8) & 0xFF;
+			blue += pixel & 0xFF;
+		}
+
+		std::uint32_t average(std::uint32_t count) const
+		{
+			return ((alpha / count) << 24) | ((red / count) << 16) | ((green / count) << 8) | (blue / count);
+		}
+
+		std::uint32_t alpha = 0;
+		std::uint32_t red = 0;
+		std::uint32_t green = 0;
+		std::uint32_t blue = 0;
+	};
+
+	// One level of the pyramid, every pixel is the average of a 2x2 box. An odd last row or column is dropped.
+	Image halve(const std::uint32_t* pixels, std::uint32_t width, std::uint32_t height, std::uint32_t stride)
+	{
+		Image image{ width / 2, height / 2, {} };
+		image.pixels.resize(static_cast<std::size_t>(image.width) * image.height);
+		for (std::uint32_t y = 0; y < image.height; ++y)
+		{
+			const auto* top = pixels + static_cast<std::size_t>(y) * 2 * stride;
+			const auto* bottom = top + stride;
+			auto* output = image.pixels.data() + static_cast<std::size_t>(y) * image.width;
+			for (std::uint32_t x = 0; x < image.width; ++x)
+			{
+				PixelSum sum;
+				sum.add(top[2 * x]);
+				sum.add(top[2 * x + 1]);
+				sum.add(bottom[2 * x]);
+				sum.add(bottom[2 * x + 1]);
+				output[x] = sum.average(4);
+			}
+		}
+		return image;
+	}
+
+	// The last step, less than halving: every pixel averages the source pixels its box covers
+	Image boxResample(const std::uint32_t* pixels, std::uint32_t width, std::uint32_t height, std::uint32_t stride,
+		std::uint32_t targetWidth, std::uint32_t targetHeight)
+	{
+		Image image{ targetWidth, targetHeight, {} };
+		image.pixels.resize(static_cast<std::size_t>(targetWidth) * targetHeight);
+		for (std::uint32_t y = 0; y < targetHeight; ++y)
+		{
+			const auto top = static_cast<std::uint32_t>(static_cast<std::uint64_t>(y) * height / targetHeight);
+			const auto bottom = (std::max)(top + 1, static_cast<std::uint32_t>(static_cast<std::uint64_t>(y + 1) * height / targetHeight));
+			for (std::uint32_t x = 0; x < targetWidth; ++x)
+			{
+				const auto left = static_cast<std::uint32_t>(static_cast<std::uint64_t>(x) * width / targetWidth);
+				const auto right = (std::max)(left + 1, static_cast<std::uint32_t>(static_cast<std::uint64_t>(x + 1) * width / targetWidth));
+
+				PixelSum sum;
+				for (auto row = top; row < bottom; ++row)
+				{
+					for (auto column = left; column < right; ++column)
+					{
+						sum.add(pixels[static_cast<std::size_t>(row) * stride + column]);
+					}
+				}
+				image.pixels[static_cast<std::size_t>(y) * targetWidth + x] = sum.average((bottom - top) * (right - left));
+			}
+		}
+		return image;
+	}
+
+	// Halves the image while it stays at least twice the size of the thumbnail, so the box of the
+	// last step is never larger than 3x3 pixels however large the source is
+	Image downsample(const std::uint32_t* pixels, std::uint32_t width, std::uint32_t height, std::uint32_t maxSize)
+	{
+		const auto longer = (std::max)(width, height);
+		const auto scale = (std::min)(1.0, static_cast<double>(maxSize) / longer);
+		const auto targetWidth = (std::max)(1u, static_cast<std::uint32_t>(width * scale));
+		const auto targetHeight = (std::max)(1u, static_cast<std::uint32_t>(height * scale));
+
+		Image level{ width, height, {} };
+		const auto* source = pixels;
+		auto stride = width;
+		while (level.width >= 2 * targetWidth && level.height >= 2 * targetHeight)
+		{
+			level = halve(source, level.width, level.height, stride);
+			source = level.pixels.data();
+			stride = level.width;
+		}
+
+		if (level.width == targetWidth && level.height == targetHeight && !level.pixels.empty())
+		{
+			return level;
+		}
+		return boxResample(source, level.width, level.height, stride, targetWidth, targetHeight);
+	}
+}
+
+namespace SAV
+{
+	std::filesystem::path ThumbnailFile::sidecarPath(const std::filesystem::path& project)
+	{
+		auto path = project;
+		path += extension;
+		return path;
+	}
+
+	ThumbnailCache::ThumbnailCache(const OnReady& onReady) :
+		m_onReady{ onReady }
+	{
+		// the window thread decodes the shown frame as well, so it keeps a core
+		const auto workerCount = (std::max)(1u, std::thread::hardware_concurrency() / 2);
+		for (std::uint32_t index = 0; index < workerCount; ++index)
+		{
+			m_workers.emplace_back(&ThumbnailCache::run, this);
+		}
+	}
+
+	ThumbnailCache::~ThumbnailCache()
+	{
+		{
+			std::lock_guard guard(m_mutex);
+			m_isStopped = true;
+		}
+		m_cancellation.cancel();
+		m_condition.notify_all();
+
+		for (auto& worker : m_workers)
+		{
+			worker.join();
+		}
+	}
+
+	std::optional<Thumbnail> ThumbnailCache::find(const std::filesystem::path& source) const
+	{
+		if (auto it = m_entries.find(source.wstring()); it != m_entries.end() && it->second.isChecked)
+		{
+			const auto& entry = it->second;
+			return Thumbnail{ entry.width, entry.height, entry.stride, entry.pixels };
+		}
+		return std::nullopt;
+	}
+
+	void ThumbnailCache::request(const std::vector<std::filesystem::path>& sources)
+	{
+		std::vector<std::filesystem::path> missing;
+		for (const auto& source : sources)
+		{
+			auto key = source.wstring();
+			if (m_failed.count(key) > 0)
+			{
+				continue;
+			}
+
+			auto it = m_entries.find(key);
+			if (it != m_entries.end() && !it->second.isChecked)
+			{
+				// only the shown thumbnails are compared with their files, a whole sidecar would take long
+				auto stamp = Utils::stampOf(source);
+				if (stamp && stamp->size == it->second.sourceSize && stamp->modified == it->second.sourceModified)
+				{
+					it->second.isChecked = true;
+				}
+				else
+				{
+					releaseTile(it->second);
+					m_entries.erase(it);
+					m_isModified = true;
+					it = m_entries.end();
+				}
+			}
+
+			if (it == m_entries.end())
+			{
+				missing.push_back(source);
+			}
+		}
+
+		{
+			std::lock_guard guard(m_mutex);
+			for (const auto& source : m_requests)
+			{
+				m_pending.erase(source.wstring());
+			}
+			m_requests.clear();
+
+			for (auto& source : missing)
+			{
+				if (m_pending.insert(source.wstring()).second)
+				{
+					m_requests.push_back(std::move(source));
+				}
+			}
+		}
+		m_condition.notify_all();
+	}
+
+	std::size_t ThumbnailCache::collect()
+	{
+		std::vector<Result> results;
+		std::uint64_t generation = 0;
+		{
+			std::lock_guard guard(m_mutex);
+			results.swap(m_results);
+			generation = m_generation;
+			for (const auto& result : results)
+			{
+				m_pending.erase(result.source);
+			}
+		}
+
+		for (auto& result : results)
+		{
+			// the file changed meanwhile, the next request makes it again
+			if (result.generation != generation)
+			{
+				continue;
+			}
+
+			if (result.pixels.empty())
+			{
+				m_failed.insert(std::move(result.source));
+				continue;
+			}
+
+			auto tile = allocateTile();
+			auto* pixels = tilePixels(tile);
+			for (std::uint32_t row = 0; row < result.height; ++row)
+			{
+				std::copy_n(result.pixels.data() + static_cast<std::size_t>(row) * result.width, result.width, pixels + static_cast<std::size_t>(row) * tileSize);
+			}
+
+			if (auto it = m_entries.find(result.source); it != m_entries.end())
+			{
+				releaseTile(it->second);
+			}
+			m_entries.insert_or_assign(std::move(result.source),
+				Entry{ pixels, result.width, result.height, tileSize, tile, result.sourceSize, result.sourceModified, true });
+			m_isModified = true;
+		}
+		return results.size();
+	}
+
+	void ThumbnailCache::setFramePack(FramePackPtr pack)
+	{
+		std::lock_guard guard(m_mutex);
+		m_pack = std::move(pack);
+	}
+
+	void ThumbnailCache::invalidate(const std::vector<std::filesystem::path>& changedFiles)
+	{
+		std::unordered_set<std::wstring> changed;
+		for (const auto& file : changedFiles)
+		{
+			changed.insert(file.wstring());
+		}
+
+		auto isAffected = [&changed](const std::wstring& source)
+		{
+			return changed.count(source) > 0 || changed.count(std::filesystem::path{ source }.parent_path().wstring()) > 0;
+		};
+
+		for (auto& [source, entry] : m_entries)
+		{
+			if (entry.isChecked && isAffected(source))
+			{
+				entry.isChecked = false;
+			}
+		}
+		for (auto it = m_failed.begin(); it != m_failed.end();)
+		{
+			it = isAffected(*it) ? m_failed.erase(it) : std::next(it);
+		}
+
+		std::lock_guard guard(m_mutex);
+		++m_generation;
+	}
+
+	void ThumbnailCache::load(const std::filesystem::path& thumbnailFile)
+	{
+		clear();
+
+		auto mappedFile = MappedFile::open(thumbnailFile);
+		if (!mappedFile || mappedFile->size() < sizeof(ThumbnailFile::Header))
+		{
+			return;
+		}
+
+		const auto size = static_cast<std::uint64_t>(mappedFile->size());
+		const auto& header = *reinterpret_cast<const ThumbnailFile::Header*>(mappedFile->data());
+		if (header.magic != ThumbnailFile::magic || header.version != ThumbnailFile::version || header.tileSize != tileSize ||
+			header.entriesOffset % alignof(ThumbnailFile::Entry) != 0 ||
+			!Utils::isRangeInside(header.entriesOffset, header.entryCount, sizeof(ThumbnailFile::Entry), size))
+		{
+			return;
+		}
+
+		auto* entries = reinterpret_cast<const ThumbnailFile::Entry*>(mappedFile->data() + header.entriesOffset);
+		m_entries.reserve(header.entryCount);
+		for (std::uint32_t index = 0; index < header.entryCount; ++index)
+		{
+			const auto& entry = entries[index];
+			if (entry.pathOffset % sizeof(wchar_t) != 0 || !Utils::isRangeInside(entry.pathOffset, entry.pathLength, sizeof(wchar_t), size) ||
+				entry.width == 0 || entry.width > tileSize || entry.height == 0 || entry.height > tileSize ||
+				entry.pixelsOffset % sizeof(std::uint32_t) != 0 ||
+				!Utils::isRangeInside(entry.pixelsOffset, static_cast<std::uint64_t>(entry.width) * entry.height, sizeof(std::uint32_t), size))
+			{
+				m_entries.clear();
+				return;
+			}
+
+			std::wstring path{ reinterpret_cast<const wchar_t*>(mappedFile->data() + entry.pathOffset), entry.pathLength };
+			auto* pixels = reinterpret_cast<const std::uint32_t*>(mappedFile->data() + entry.pixelsOffset);
+			m_entries.emplace(std::move(path),
+				Entry{ pixels, entry.width, entry.height, entry.width, std::nullopt, entry.sourceSize, entry.sourceModified, false });
+		}
+
+		// the entries point into the mapping, moving it keeps the addresses
+		m_file = std::move(mappedFile);
+	}
+
+	bool ThumbnailCache::save(const std::filesystem::path& thumbnailFile)
+	{
+		ThumbnailFile::Header header = { ThumbnailFile::magic, ThumbnailFile::version,
+			static_cast<std::uint32_t>(m_entries.size()), tileSize, sizeof(ThumbnailFile::Header) };
+
+		std::vector<ThumbnailFile::Entry> entries;
+		entries.reserve(m_entries.size());
+		std::uint64_t pathOffset = header.entriesOffset + m_entries.size() * sizeof(ThumbnailFile::Entry);
+		std::uint64_t pixelsOffset = pathOffset;
+		for (const auto& [path, entry] : m_entries)
+		{
+			pixelsOffset += path.size() * sizeof(wchar_t);
+		}
+		const auto padding = (sizeof(std::uint32_t) - pixelsOffset % sizeof(std::uint32_t)) % sizeof(std::uint32_t);
+		pixelsOffset += padding;
+
+		for (const auto& [path, entry] : m_entries)
+		{
+			entries.push_back(ThumbnailFile::Entry{ pathOffset, pixelsOffset, entry.sourceSize, entry.sourceModified,
+				static_cast<std::uint32_t>(path.size()), entry.width, entry.height, 0 });
+			pathOffset += path.size() * sizeof(wchar_t);
+			pixelsOffset += static_cast<std::uint64_t>(entry.width) * entry.height * sizeof(std::uint32_t);
+		}
+
+		// the old file may be the mapped one, it is replaced once the new one is complete
+		auto nextFile = thumbnailFile;
+		nextFile += L".next";
+		{
+			std::ofstream output(nextFile, std::ios_base::binary | std::ios_base::trunc);
+			Utils::writeValue(output, header);
+			output.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(ThumbnailFile::Entry)));
+			for (const auto& [path, entry] : m_entries)
+			{
+				output.write(reinterpret_cast<const char*>(path.data()), static_cast<std::streamsize>(path.size() * sizeof(wchar_t)));
+			}
+			output.write("\0\0\0", static_cast<std::streamsize>(padding));
+			for (const auto& [path, entry] : m_entries)
+			{
+				for (std::uint32_t row = 0; row < entry.height; ++row)
+				{
+					output.write(reinterpret_cast<const char*>(entry.pixels + static_cast<std::size_t>(row) * entry.stride),
+						static_cast<std::streamsize>(entry.width * sizeof(std::uint32_t)));
+				}
+			}
+
+			if (!output)
+			{
+				output.close();
+				std::error_code ec;
+				std::filesystem::remove(nextFile, ec);
+				return false;
+			}
+		}
+
+		// the old file can't be replaced while it is mapped, its thumbnails are kept as offsets meanwhile
+		std::vector<std::pair<decltype(m_entries)::iterator, std::size_t>> mappedEntries;
+		const auto mappedSize = m_file ? m_file->size() : 0;
+		for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+		{
+			if (!it->second.tile)
+			{
+				mappedEntries.emplace_back(it, reinterpret_cast<const std::byte*>(it->second.pixels) - m_file->data());
+			}
+		}
+		m_file.reset();
+
+		std::error_code ec;
+		std::filesystem::rename(nextFile, thumbnailFile, ec);
+		if (!ec)
+		{
+			// every thumbnail is in the file now, the atlas isn't needed anymore
+			load(thumbnailFile);
+			return true;
+		}
+
+		// the old file is still there, it is mapped again and the next save tries once more
+		std::filesystem::remove(nextFile, ec);
+		m_file = MappedFile::open(thumbnailFile);
+		if (m_file && m_file->size() != mappedSize)
+		{
+			m_file.reset();
+		}
+		for (auto& [it, offset] : mappedEntries)
+		{
+			if (m_file)
+			{
+				it->second.pixels = reinterpret_cast<const std::uint32_t*>(m_file->data() + offset);
+			}
+			else
+			{
+				// the thumbnail is made again when it is requested
+				m_entries.erase(it);
+			}
+		}
+		m_isModified = true;
+		return false;
+	}
+
+	void ThumbnailCache::run()
+	{
+		for (;;)
+		{
+			std::filesystem::path source;
+			FramePackPtr pack;
+			std::uint64_t generation = 0;
+			{
+				std::unique_lock lock(m_mutex);
+				m_condition.wait(lock, [this]() { return m_isStopped || !m_requests.empty(); });
+				if (m_isStopped)
+				{
+					return;
+				}
+
+				source = std::move(m_requests.front());
+				m_requests.pop_front();
+				pack = m_pack;
+				generation = m_generation;
+			}
+
+			auto result = make(source, pack);
+			if (m_cancellation.isCanceled())
+			{
+				return;
+			}
+			result.generation = generation;
+
+			{
+				std::lock_guard guard(m_mutex);
+				m_results.push_back(std::move(result));
+			}
+			m_onReady();
+		}
+	}
+
+	ThumbnailCache::Result ThumbnailCache::make(const std::filesystem::path& source, const FramePackPtr& pack) const
+	{
+		Result result{ source.wstring(), 0, 0, 0, 0, 0, {} };
+		auto stamp = Utils::stampOf(source);
+		if (!stamp)
+		{
+			return result;
+		}
+		result.sourceSize = stamp->size;
+		result.sourceModified = stamp->modified;
+
+		DecodedFrame frame{ source, pack };
+		if (!frame.decode(m_cancellation.token()) || frame.width() == 0 || frame.height() == 0)
+		{
+			return result;
+		}
+
+		auto image = downsample(reinterpret_cast<const std::uint32_t*>(frame.pixels().data()), frame.width(), frame.height(), tileSize);
+		result.width = image.width;
+		result.height = image.height;
+		result.pixels = std::move(image.pixels);
+		return result;
+	}
+
+	std::uint32_t ThumbnailCache::allocateTile()
+	{
+		if (!m_freeTiles.empty())
+		{
+			auto tile = m_freeTiles.back();
+			m_freeTiles.pop_back();
+			return tile;
+		}
+
+		if (m_tileCount % tilesPerPage == 0)
+		{
+			m_pages.emplace_back(tilesPerPage * tileSize * tileSize);
+		}
+		return m_tileCount++;
+	}
+
+	std::uint32_t* ThumbnailCache::tilePixels(std::uint32_t tile)
+	{
+		return m_pages[tile / tilesPerPage].data() + (tile % tilesPerPage) * tileSize * tileSize;
+	}
+
+	void ThumbnailCache::releaseTile(const Entry& entry)
+	{
+		if (entry.tile)
+		{
+			m_freeTiles.push_back(*entry.tile);
+		}
+	}
+
+	void ThumbnailCache::clear()
+	{
+		m_entries.clear();
+		m_pages.clear();
+		m_tileCount = 0;
+		m_freeTiles.clear();
+		m_failed.clear();
+		m_file.reset();
+		m_isModified = false;
+	}
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "cancellation_token.hpp"
+#include "frame_pack.hpp"
+#include "mapped_file.hpp"
+
+namespace SAV
+{
+	// Thumbnail sidecar (<project>.savthumb), the thumbnails made for the frames of a project.
+	// All integers are little endian, paths are UTF-16, pixels are 32bpp ARGB rows of width pixels.
+	//
+	//   Header
+	//   Entry[entryCount]
+	//   wchar_t[]           source paths
+	//   uint32_t[]          pixels of every thumbnail
+	namespace ThumbnailFile
+	{
+		inline constexpr std::array<char, 4> magic = { 'S', 'A', 'V', 'T' };
+		inline constexpr std::uint32_t version = 1;
+		inline constexpr std::wstring_view extension = L".savthumb";
+
+		struct Header
+		{
+			std::array<char, 4> magic;
+			std::uint32_t version;
+			std::uint32_t entryCount;
+			std::uint32_t tileSize; // thumbnails of another size are made again
+			std::uint64_t entriesOffset;
+		};
+
+		struct Entry
+		{
+			std::uint64_t pathOffset;
+			std::uint64_t pixelsOffset;
+			// the source file when the thumbnail was made, a changed file gets a new one
+			std::uint64_t sourceSize;
+			std::int64_t sourceModified;
+			std::uint32_t pathLength;
+			std::uint32_t width;
+			std::uint32_t height;
+			std::uint32_t reserved;
+		};
+
+		static_assert(sizeof(Header) == 24 && sizeof(Entry) == 48, "the layout is part of the format");
+
+		std::filesystem::path sidecarPath(const std::filesystem::path& project);
+	}
+
+	// Downscaled image, rows are stride pixels apart
+	struct Thumbnail
+	{
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint32_t stride;
+		const std::uint32_t* pixels;
+	};
+
+	// Small copies of the frame images for the frame list. They are made on worker threads, only for
+	// the sources asked for last, and kept in an atlas of fixed size tiles. Thumbnails read from the
+	// sidecar are used straight from the mapped file.
+	class ThumbnailCache
+	{
+	public:
+		// the longer side of a thumbnail, smaller images keep their size
+		inline static constexpr std::uint32_t tileSize = 32;
+		// the atlas grows by pages, so the tiles handed out never move
+		inline static constexpr std::size_t tilesPerPage = 256;
+
+		// Called on a worker thread after thumbnails were made, collect() takes them on the window thread
+		using OnReady = std::function<void()>;
+
+	public:
+		explicit ThumbnailCache(const OnReady& onReady);
+		~ThumbnailCache();
+
+		ThumbnailCache(const ThumbnailCache&) = delete;
+		ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+		// Everything below is called on the window thread
+
+		// nullopt until the thumbnail was made or found up to date by request(). The pixels stay
+		// valid until the next load() or save().
+		std::optional<Thumbnail> find(const std::filesystem::path& source) const;
+		// Makes the missing thumbnails of the sources, the ones requested before and not started yet are dropped
+		void request(const std::vector<std::filesystem::path>& sources);
+		// Moves the thumbnails made so far into the atlas, returns how many there were
+		std::size_t collect();
+
+		// The images are decoded from the pack if it holds them
+		void setFramePack(FramePackPtr pack);
+		// The thumbnails of changed files are checked again the next time they are requested,
+		// a folder stands for every file in it
+		void invalidate(const std::vector<std::filesystem::path>& changedFiles);
+
+		// A missing or damaged file simply starts empty, the thumbnails made meanwhile are dropped
+		void load(const std::filesystem::path& thumbnailFile);
+		// false if the file couldn't be written or replaced, the thumbnails are kept for the next try
+		bool save(const std::filesystem::path& thumbnailFile);
+		bool isModified() const { return m_isModified; }
+
+	private:
+		struct Entry
+		{
+			const std::uint32_t* pixels; // a tile of the atlas or a thumbnail of the mapped file
+			std::uint32_t width;
+			std::uint32_t height;
+			std::uint32_t stride;
+			std::optional<std::uint32_t> tile;
+			std::uint64_t sourceSize;
+			std::int64_t sourceModified;
+			bool isChecked;
+		};
+
+		struct Result
+		{
+			std::wstring source;
+			std::uint64_t generation;
+			std::uint32_t width;
+			std::uint32_t height;
+			std::uint64_t sourceSize;
+			std::int64_t sourceModified;
+			std::vector<std::uint32_t> pixels;
+		};
+
+	private:
+		void run();
+		// The pixels are empty if the source can't be decoded
+		Result make(const std::filesystem::path& source, const FramePackPtr& pack) const;
+
+		std::uint32_t allocateTile();
+		std::uint32_t* tilePixels(std::uint32_t tile);
+		void releaseTile(const Entry& entry);
+		void clear();
+
+	private:
+		OnReady m_onReady;
+
+		std::unordered_map<std::wstring, Entry> m_entries;
+		std::vector<std::vector<std::uint32_t>> m_pages;
+		std::uint32_t m_tileCount = 0;
+		std::vector<std::uint32_t> m_freeTiles;
+		// sources which can't be decoded are not tried again until they change
+		std::unordered_set<std::wstring> m_failed;
+		std::optional<MappedFile> m_file;
+		bool m_isModified = false;
+
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		std::deque<std::filesystem::path> m_requests;
+		// requested or being made, until collect() takes the result
+		std::unordered_set<std::wstring> m_pending;
+		std::vector<Result> m_results;
+		FramePackPtr m_pack;
+		// results made before an invalidate() may show the old file
+		std::uint64_t m_generation = 0;
+		bool m_isStopped = false;
+
+		CancellationSource m_cancellation;
+		std::vector<std::thread> m_workers;
+	};
+}
@@ -44,18 +44,29 @@ namespace SAV
 		::RemoveWindowSubclass(m_parentHwnd, timelineSubclassProc, 1);
 	}
 
-	void TimeLine::add(const std::wstring& frameName, std::chrono::milliseconds interval)
+	void TimeLine::add(FrameId frame, std::chrono::milliseconds interval)
 	{
-		m_frames.emplace_back(frameName, interval);
+		if (!m_spans.empty())
+		{
+			auto& last = m_spans.back();
+			if (last.interval == interval && frame == last.first + last.count)
+			{
+				++last.count;
+				return;
+			}
+		}
+
+		m_spans.push_back(Span{ frame, 1, interval });
 	}
 
 	bool TimeLine::advance()
 	{
-		if (m_current == m_frames.size())
+		if (m_span == m_spans.size())
 		{
-			if (m_isLooped)
+			if (m_isLooped && !m_spans.empty())
 			{
-				m_current = 0;
+				m_span = 0;
+				m_offset = 0;
 			}
 			else
 			{
@@ -63,9 +74,16 @@ namespace SAV
 			}
 		}
 
-		auto& [frameName, timerCount] = m_frames.at(m_current++);
+		const auto& span = m_spans.at(m_span);
+		const auto frame = span.first + m_offset;
+		const auto timerCount = span.interval;
+		if (++m_offset == span.count)
+		{
+			++m_span;
+			m_offset = 0;
+		}
 
-		m_onFrameChanged(frameName);
+		m_onFrameChanged(frame);
 
 		if (m_animationTimer == 0)
 		{
@@ -78,17 +96,83 @@ namespace SAV
 	void TimeLine::play(bool isLooped, bool isReverInEnd)
 	{
 		m_isLooped = isLooped;
-		m_current = 0;
+		m_span = 0;
+		m_offset = 0;
 		advance();
 	}
 
 	void TimeLine::addInvertFrames()
 	{
-		std::vector<std::pair<std::wstring, std::chrono::milliseconds>> newFrames;
-		newFrames.reserve(m_frames.size() * 2);
-		std::copy(m_frames.begin(), m_frames.end(), std::back_inserter(newFrames));
-		std::copy(m_frames.rbegin(), m_frames.rend(), std::back_inserter(newFrames));
-		m_frames = std::move(newFrames);
+		// a span only counts upwards, the reversed frames are added one by one
+		auto spans = m_spans;
+		for (auto it = spans.rbegin(); it != spans.rend(); ++it)
+		{
+			for (auto offset = it->count; offset > 0; --offset)
+			{
+				add(it->first + offset - 1, it->interval);
+			}
+		}
+	}
+
+	std::vector<TimeLine::FrameId> TimeLine::upcoming(std::size_t count) const
+	{
+		std::vector<FrameId> frames;
+		auto span = m_span;
+		auto offset = m_offset;
+		bool isWrapped = false;
+		while (frames.size() < count && !(isWrapped && span == m_span && offset == m_offset))
+		{
+			if (span == m_spans.size())
+			{
+				if (!m_isLooped || isWrapped || m_spans.empty())
+				{
+					break;
+				}
+				span = 0;
+				offset = 0;
+				isWrapped = true;
+			}
+			frames.push_back(m_spans[span].first + offset);
+			if (++offset == m_spans[span].count)
+			{
+				++span;
+				offset = 0;
+			}
+		}
+		return frames;
+	}
+
+	std::size_t TimeLine::position() const
+	{
+		std::size_t position = m_offset;
+		for (std::size_t span = 0; span < m_span && span < m_spans.size(); ++span)
+		{
+			position += m_spans[span].count;
+		}
+		return position;
+	}
+
+	void TimeLine::seek(std::size_t position)
+	{
+		m_span = 0;
+		m_offset = 0;
+		while (m_span < m_spans.size() && position >= m_spans[m_span].count)
+		{
+			position -= m_spans[m_span].count;
+			++m_span;
+		}
+
+		if (m_span < m_spans.size())
+		{
+			m_offset = static_cast<std::uint32_t>(position);
+		}
+	}
+
+	void TimeLine::clear()
+	{
+		m_span = 0;
+		m_offset = 0;
+		m_spans.clear();
 	}
 
 	void TimeLine::reset()
@@ -99,8 +183,9 @@ namespace SAV
 			m_animationTimer = 0;
 		}
 
-		m_current = 0;
+		m_span = 0;
+		m_offset = 0;
 		m_isLooped = false;
-		m_frames.clear();
+		m_spans.clear();
 	}
 }
\ No newline at end of file
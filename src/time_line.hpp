@@ -12,7 +12,9 @@ namespace SAV
 	class TimeLine
 	{
 	public:
-		using OnFrameChanged = std::function<void(const std::wstring&)>;
+		// Frames are identified by whatever the owner uses to find their images
+		using FrameId = std::uint32_t;
+		using OnFrameChanged = std::function<void(FrameId)>;
 
 	public:
 		TimeLine(HWND window, const OnFrameChanged& onFrameChanged);
@@ -20,19 +22,39 @@ namespace SAV
 
 		TimeLine(const TimeLine&) = delete;
 
-		void add(const std::wstring& frameName, std::chrono::milliseconds interval);
+		void add(FrameId frame, std::chrono::milliseconds interval);
 		void setLooped(bool value) { m_isLooped = value; }
 		void play(bool isLooped);
 		bool advance();
+		// The frames shown next, the looped timeline wraps around
+		std::vector<FrameId> upcoming(std::size_t count) const;
 		void reset();
 		bool hasTimer(WPARAM timerID) const { return timerID == m_animationTimer; }
+		bool isPlaying() const { return m_animationTimer != 0; }
+
+		// Frames shown so far in the current pass
+		std::size_t position() const;
+		// Continues with the frame at the position, past the end the pass is over
+		void seek(std::size_t position);
+		// Drops the frames but keeps playing, for replacing them by the frames added next
+		void clear();
+
+	private:
+		// Consecutive frame ids shown for the same time, a whole sequence fits into one span
+		struct Span
+		{
+			FrameId first;
+			std::uint32_t count;
+			std::chrono::milliseconds interval;
+		};
 
 	private:
 		HWND m_parentHwnd;
-		std::uint32_t m_current = 0;
+		std::size_t m_span = 0;
+		std::uint32_t m_offset = 0;
 		UINT_PTR m_animationTimer = 0;
 		bool m_isLooped = false;
-		std::vector<std::pair<std::wstring, std::chrono::milliseconds>> m_frames;
+		std::vector<Span> m_spans;
 		OnFrameChanged m_onFrameChanged;
 	};
 }
\ No newline at end of file
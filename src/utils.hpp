@@ -1,37 +1,84 @@
 #pragma once
 #include <Windows.h>
 
-#include <array>
-#include <charconv>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
 #include <optional>
+#include <ostream>
 #include <sstream>
 #include <type_traits>
 
 namespace SAV::Utils
 {
-	template<typename StringType>
-	std::optional<std::uint64_t> fromString(const StringType& data)
+	// count items of itemSize bytes from offset lie within size bytes, checked without overflowing on values read from a file
+	constexpr bool isRangeInside(std::uint64_t offset, std::uint64_t count, std::uint64_t itemSize, std::uint64_t size)
 	{
-		std::uint64_t value = 0;
-		std::array<char, 10> buf = { 0 };
+		return offset <= size && (itemSize == 0 || count <= (size - offset) / itemSize);
+	}
+
+	inline constexpr std::uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
 
-		int len = 0;
-		if constexpr (std::is_same_v<typename StringType::value_type, wchar_t>)
+	// FNV-1a, good enough to tell whether inputs differ; not meant to be cryptographic
+	inline std::uint64_t hash(const void* data, std::size_t size, std::uint64_t seed = FNV_OFFSET_BASIS)
+	{
+		constexpr std::uint64_t FNV_PRIME = 1099511628211ull;
+		auto* bytes = static_cast<const unsigned char*>(data);
+		for (std::size_t i = 0; i < size; ++i)
 		{
-			len = WideCharToMultiByte(CP_UTF8, 0, data.c_str(), static_cast<int>(data.length()), buf.data(), static_cast<int>(buf.size()), nullptr, nullptr);
+			seed ^= bytes[i];
+			seed *= FNV_PRIME;
 		}
-		else
+		return seed;
+	}
+
+	// pointers are rejected so hash(data, size) always hashes the pointed-to bytes
+	template<typename T, typename = std::enable_if_t<std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>>>
+	std::uint64_t hash(const T& value, std::uint64_t seed = FNV_OFFSET_BASIS)
+	{
+		return hash(&value, sizeof(T), seed);
+	}
+
+	// Size and last write time of a file, the sidecars compare them to tell whether it changed since
+	struct FileStamp
+	{
+		std::uint64_t size;
+		std::int64_t modified;
+	};
+
+	inline std::optional<FileStamp> stampOf(const std::filesystem::path& file)
+	{
+		std::error_code ec;
+		auto size = std::filesystem::file_size(file, ec);
+		if (ec)
 		{
-			len = static_cast<int>(data.size());
-			std::copy(data.begin(), data.end(), buf.begin());
+			return std::nullopt;
 		}
 
-		auto result = std::from_chars(buf.data(), buf.data() + len, value);
-		if (result.ec == std::errc())
+		auto writeTime = std::filesystem::last_write_time(file, ec);
+		if (ec)
+		{
+			return std::nullopt;
+		}
+		return FileStamp{ size, static_cast<std::int64_t>(writeTime.time_since_epoch().count()) };
+	}
+
+	// The binary formats are written field by field in the layout they are mapped with
+	template<typename T, typename = std::enable_if_t<std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>>>
+	void writeValue(std::ostream& output, const T& value)
+	{
+		output.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	inline void writePadding(std::ostream& output, std::uint64_t size)
+	{
+		static constexpr char zeros[64] = {};
+		while (size > 0)
 		{
-			return std::optional<std::uint64_t>(value);
+			const auto count = (std::min)(size, std::uint64_t{ sizeof(zeros) });
+			output.write(zeros, static_cast<std::streamsize>(count));
+			size -= count;
 		}
-		return std::nullopt;
 	}
 
 	template<typename ... Args>
@@ -3,19 +3,34 @@
 #include <mferror.h>
 
 #include <cmath>
+#include <unordered_map>
+#include <vector>
+#include "number_parser.hpp"
+#include "utils.hpp"
 #include "video_file_creator.hpp"
 
+namespace
+{
+	const HRESULT E_EXPORT_CANCELED = HRESULT_FROM_WIN32(ERROR_CANCELLED);
+
+	BOOL CALLBACK abortDrawing(VOID* data)
+	{
+		auto* cancellationToken = static_cast<const SAV::CancellationToken*>(data);
+		return cancellationToken->isCanceled() ? TRUE : FALSE;
+	}
+}
+
 namespace SAV
 {
 	VideoFileCreator::VideoFileCreator(std::wstring_view filename, std::uint32_t width, std::uint32_t height, std::uint32_t bitrate) :
         m_width{width},
         m_height{height},
         m_bitrate{bitrate},
-        m_fps{30},
+        m_fps{ NumberParser::projectFps },
         m_filename{filename},
         m_frameDuration{ 1000.0f / m_fps },
         m_frameTimestamp{0},
-        m_isCanceled{ false }
+        m_resumedFrames{0}
     {
 		auto hr = ::CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
 		if (!SUCCEEDED(hr))
@@ -30,47 +45,389 @@ namespace SAV
 			::CoUninitialize();
 			throw std::exception("MFStartup is failed");
 		}
-
-		hr = initializeSinkWriter();
 	}
 
-    HRESULT VideoFileCreator::write(const std::vector<AnimationDescription>& data, std::function<void()> progressCallback)
+    HRESULT VideoFileCreator::write(const std::vector<AnimationDescription>& data, const CancellationToken& cancellationToken,
+        const ProgressCallback& progressCallback, FramePackPtr pack)
+    {
+        DirectFrameSource frameSource{ data, std::move(pack) };
+        return write(data, frameSource, cancellationToken, progressCallback);
+    }
+
+    HRESULT VideoFileCreator::write(const std::vector<AnimationDescription>& data, FrameSource& frameSource,
+        const CancellationToken& cancellationToken, const ProgressCallback& progressCallback)
+    {
+        auto segments = planSegments(data);
+        if (segments.empty())
+        {
+            return E_INVALIDARG;
+        }
+
+        ExportCheckpoint checkpoint{ m_filename, hashJob(data) };
+        checkpoint.load();
+
+        m_progress = ExportProgress{};
+        for (const auto& segment : segments)
+        {
+            m_progress.totalFrames += segment.frames.frameCount;
+            if (checkpoint.isCompleted(segment.index))
+            {
+                m_progress.framesWritten += segment.frames.frameCount;
+            }
+        }
+        m_resumedFrames = m_progress.framesWritten;
+        m_progress.totalTime = ExportProgress::Seconds{ m_progress.totalFrames * m_frameDuration / 1000.0 };
+        m_exportStart = std::chrono::steady_clock::now();
+        m_lastReport = m_exportStart;
+        reportProgress(progressCallback, true);
+
+        for (const auto& segment : segments)
+        {
+            if (checkpoint.isCompleted(segment.index))
+            {
+                continue;
+            }
+
+            auto hr = writeSegment(data, frameSource, segment, checkpoint.segmentPath(segment.index), cancellationToken, progressCallback);
+            if (!SUCCEEDED(hr))
+            {
+                return hr;
+            }
+
+            if (!checkpoint.commit(segment.index, segment.frames))
+            {
+                return E_FAIL;
+            }
+        }
+
+        auto assembleStart = std::chrono::steady_clock::now();
+        auto hr = assembleSegments(segments, checkpoint, cancellationToken);
+        m_progress.encodeTime += std::chrono::steady_clock::now() - assembleStart;
+        if (!SUCCEEDED(hr))
+        {
+            return hr;
+        }
+
+        checkpoint.clear();
+        reportProgress(progressCallback, true);
+        return S_OK;
+    }
+
+    std::uint32_t VideoFileCreator::frameCount(const AnimationDescription& frame) const
     {
-        std::unique_ptr<Gdiplus::Bitmap> videoFrameBitmap{ new Gdiplus::Bitmap(m_width, m_height) };
-        std::unique_ptr<Gdiplus::Graphics> frameGraphics{ new Gdiplus::Graphics(videoFrameBitmap.get()) };
-        HRESULT hr = S_OK;
+        return static_cast<std::uint32_t>(std::ceil(frame.duration().count() / m_frameDuration));
+    }
 
+    std::vector<VideoFileCreator::Segment> VideoFileCreator::planSegments(const std::vector<AnimationDescription>& data) const
+    {
+        // segments are cut at row boundaries only, so the same data always produces the same plan
+        const std::uint64_t segmentFrames = static_cast<std::uint64_t>(segmentDuration.count()) * m_fps;
+
+        std::vector<Segment> segments;
+        Segment segment{ 0, 0, 0, { 0, 0 } };
+        for (std::size_t row = 0; row < data.size(); ++row)
+        {
+            segment.frames.frameCount += frameCount(data[row]);
+            segment.lastRow = row + 1;
+
+            if (segment.frames.frameCount >= segmentFrames || segment.lastRow == data.size())
+            {
+                segments.push_back(segment);
+                segment = Segment{ segment.index + 1, segment.lastRow, segment.lastRow,
+                                   { segment.frames.firstFrame + segment.frames.frameCount, 0 } };
+            }
+        }
+
+        return segments;
+    }
+
+    std::uint64_t VideoFileCreator::hashJob(const std::vector<AnimationDescription>& data) const
+    {
+        auto jobHash = Utils::hash(m_width);
+        jobHash = Utils::hash(m_height, jobHash);
+        jobHash = Utils::hash(m_bitrate, jobHash);
+        jobHash = Utils::hash(m_fps, jobHash);
+
+        // an edited image must not resume from segments encoded with its old content,
+        // so the size and write time of every source count too, each file is looked at once
+        std::unordered_map<std::wstring, std::uint64_t> fileStamps;
         for (const auto& frame : data)
         {
-            std::unique_ptr<Gdiplus::Bitmap> originalBitmap = std::make_unique<Gdiplus::Bitmap>(frame.path().wstring().c_str());
-            frameGraphics->DrawImage(originalBitmap.get(), 0, 0, m_width, m_height);
+            auto filepath = frame.path().wstring();
+            auto [stamp, isInserted] = fileStamps.try_emplace(filepath, 0);
+            if (isInserted)
+            {
+                std::error_code sizeEc;
+                std::error_code timeEc;
+                const auto size = std::filesystem::file_size(frame.path(), sizeEc);
+                const auto modified = std::filesystem::last_write_time(frame.path(), timeEc);
+                stamp->second = Utils::hash(sizeEc ? 0 : size);
+                stamp->second = Utils::hash(timeEc ? 0 : modified.time_since_epoch().count(), stamp->second);
+            }
+
+            jobHash = Utils::hash(filepath.data(), filepath.size() * sizeof(wchar_t), jobHash);
+            jobHash = Utils::hash(frame.duration().count(), jobHash);
+            jobHash = Utils::hash(stamp->second, jobHash);
+        }
+        return jobHash;
+    }
 
-            auto frameCount = static_cast<std::uint32_t>(std::ceil(frame.duration().count() / m_frameDuration));
+    HRESULT VideoFileCreator::writeSegment(const std::vector<AnimationDescription>& data, FrameSource& frameSource, const Segment& segment,
+        const std::filesystem::path& output, const CancellationToken& cancellationToken, const ProgressCallback& progressCallback)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(output.parent_path(), ec);
 
-            for (std::uint32_t frameIndex = 0; frameIndex < frameCount; ++frameIndex)
+        m_currentOutput = output;
+        m_frameTimestamp = 0;
+        HRESULT hr = initializeSinkWriter(output);
+        if (!SUCCEEDED(hr))
+        {
+            discardOutput();
+            return hr;
+        }
+
+        for (auto row = segment.firstRow; row < segment.lastRow; ++row)
+        {
+            const auto& frame = data[row];
+            auto decodedFrame = frameSource.acquire(row, cancellationToken);
+            auto videoFrameBitmap = decodedFrame ? getScaledFrame(*decodedFrame, cancellationToken) : nullptr;
+            if (cancellationToken.isCanceled())
+            {
+                discardOutput();
+                return E_EXPORT_CANCELED;
+            }
+
+            if (!videoFrameBitmap)
             {
-                hr = writeFrame(videoFrameBitmap, static_cast<std::uint32_t>(m_frameDuration * 10000));
-                if (!SUCCEEDED(hr) || m_isCanceled)
+                discardOutput();
+                return E_FAIL;
+            }
+
+            for (std::uint32_t frameIndex = 0; frameIndex < frameCount(frame); ++frameIndex)
+            {
+                auto encodeStart = std::chrono::steady_clock::now();
+                hr = writeFrame(*videoFrameBitmap, static_cast<std::uint32_t>(m_frameDuration * 10000));
+                m_progress.encodeTime += std::chrono::steady_clock::now() - encodeStart;
+                if (!SUCCEEDED(hr))
                 {
-                    m_isCanceled = false;
+                    discardOutput();
                     return hr;
                 }
+
+                if (cancellationToken.isCanceled())
+                {
+                    discardOutput();
+                    return E_EXPORT_CANCELED;
+                }
+
+                ++m_progress.framesWritten;
+                reportProgress(progressCallback, false);
             }
+        }
 
-            if (progressCallback)
+        auto encodeStart = std::chrono::steady_clock::now();
+        hr = m_sinkWriter->Finalize();
+        m_progress.encodeTime += std::chrono::steady_clock::now() - encodeStart;
+        if (!SUCCEEDED(hr))
+        {
+            discardOutput();
+            return hr;
+        }
+
+        m_sinkWriter = nullptr;
+        return S_OK;
+    }
+
+    HRESULT VideoFileCreator::assembleSegments(const std::vector<Segment>& segments, const ExportCheckpoint& checkpoint,
+        const CancellationToken& cancellationToken)
+    {
+        m_currentOutput = m_filename;
+
+        std::error_code ec;
+        if (segments.size() == 1)
+        {
+            std::filesystem::remove(m_currentOutput, ec);
+            std::filesystem::rename(checkpoint.segmentPath(segments.front().index), m_currentOutput, ec);
+            return ec ? E_FAIL : S_OK;
+        }
+
+        // the segments share encoder settings, so their compressed samples are copied as is with shifted timestamps
+        winrt::com_ptr<IMFSinkWriter> sinkWriter;
+        DWORD streamIndex = 0;
+        const LONGLONG frameDuration = static_cast<std::uint32_t>(m_frameDuration * 10000);
+
+        for (const auto& segment : segments)
+        {
+            winrt::com_ptr<IMFSourceReader> reader;
+            auto hr = MFCreateSourceReaderFromURL(checkpoint.segmentPath(segment.index).c_str(), nullptr, reader.put());
+            if (!SUCCEEDED(hr))
+            {
+                m_sinkWriter = std::move(sinkWriter);
+                discardOutput();
+                return hr;
+            }
+
+            if (!sinkWriter)
             {
-                progressCallback();
+                winrt::com_ptr<IMFMediaType> mediaType;
+                winrt::com_ptr<IMFAttributes> attributes;
+
+                hr = reader->GetNativeMediaType(static_cast<DWORD>(MF_SOURCE_READER_FIRST_VIDEO_STREAM), 0, mediaType.put());
+                if (SUCCEEDED(hr))
+                {
+                    hr = MFCreateAttributes(attributes.put(), 1);
+                }
+                if (SUCCEEDED(hr))
+                {
+                    hr = attributes->SetGUID(MF_TRANSCODE_CONTAINERTYPE, MFTranscodeContainerType_MPEG4);
+                }
+                if (SUCCEEDED(hr))
+                {
+                    hr = MFCreateSinkWriterFromURL(m_filename.c_str(), NULL, attributes.get(), sinkWriter.put());
+                }
+                if (SUCCEEDED(hr))
+                {
+                    hr = sinkWriter->AddStream(mediaType.get(), &streamIndex);
+                }
+                if (SUCCEEDED(hr))
+                {
+                    hr = sinkWriter->SetInputMediaType(streamIndex, mediaType.get(), NULL);
+                }
+                if (SUCCEEDED(hr))
+                {
+                    hr = sinkWriter->BeginWriting();
+                }
+                if (!SUCCEEDED(hr))
+                {
+                    m_sinkWriter = std::move(sinkWriter);
+                    discardOutput();
+                    return hr;
+                }
+            }
+
+            const LONGLONG offset = static_cast<LONGLONG>(segment.frames.firstFrame) * frameDuration;
+            while (true)
+            {
+                if (cancellationToken.isCanceled())
+                {
+                    m_sinkWriter = std::move(sinkWriter);
+                    discardOutput();
+                    return E_EXPORT_CANCELED;
+                }
+
+                DWORD flags = 0;
+                LONGLONG timestamp = 0;
+                winrt::com_ptr<IMFSample> sample;
+                hr = reader->ReadSample(static_cast<DWORD>(MF_SOURCE_READER_FIRST_VIDEO_STREAM), 0, nullptr, &flags, &timestamp, sample.put());
+                if (SUCCEEDED(hr) && sample)
+                {
+                    hr = sample->SetSampleTime(timestamp + offset);
+                    if (SUCCEEDED(hr))
+                    {
+                        hr = sinkWriter->WriteSample(streamIndex, sample.get());
+                    }
+                }
+
+                if (!SUCCEEDED(hr))
+                {
+                    m_sinkWriter = std::move(sinkWriter);
+                    discardOutput();
+                    return hr;
+                }
+
+                if (flags & MF_SOURCE_READERF_ENDOFSTREAM)
+                {
+                    break;
+                }
             }
         }
 
-        if (SUCCEEDED(hr))
+        auto hr = sinkWriter->Finalize();
+        if (!SUCCEEDED(hr))
         {
-            m_sinkWriter->Finalize();
+            m_sinkWriter = std::move(sinkWriter);
+            discardOutput();
         }
-        return S_OK;
+        return hr;
+    }
+
+    void VideoFileCreator::discardOutput()
+    {
+        // an unfinalized mp4 is not playable, the sink writer must release the file before it can be removed
+        m_sinkWriter = nullptr;
+
+        std::error_code ec;
+        std::filesystem::remove(m_currentOutput, ec);
+    }
+
+    void VideoFileCreator::reportProgress(const ProgressCallback& progressCallback, bool force)
+    {
+        if (!progressCallback)
+        {
+            return;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (!force && now - m_lastReport < progressInterval)
+        {
+            return;
+        }
+        m_lastReport = now;
+
+        m_progress.encodedTime = ExportProgress::Seconds{ m_progress.framesWritten * m_frameDuration / 1000.0 };
+
+        // frames restored from a checkpoint cost nothing and would skew the rate
+        ExportProgress::Seconds elapsed = now - m_exportStart;
+        const auto framesEncoded = m_progress.framesWritten - m_resumedFrames;
+        if (elapsed.count() > 0.0 && framesEncoded > 0)
+        {
+            m_progress.framesPerSecond = framesEncoded / elapsed.count();
+            m_progress.eta = ExportProgress::Seconds{ (m_progress.totalFrames - m_progress.framesWritten) / m_progress.framesPerSecond };
+        }
+
+        progressCallback(m_progress);
+    }
+
+    ScaledFrameCache::Frame VideoFileCreator::getScaledFrame(DecodedFrame& decodedFrame, const CancellationToken& cancellationToken)
+    {
+        const auto& source = decodedFrame.source();
+        if (auto cached = m_frameCache.find(source, m_width, m_height); cached)
+        {
+            return cached;
+        }
+
+        auto decodeStart = std::chrono::steady_clock::now();
+        const bool isDecoded = decodedFrame.decode(cancellationToken);
+        auto scaleStart = std::chrono::steady_clock::now();
+        m_progress.decodeTime += scaleStart - decodeStart;
+        if (!isDecoded)
+        {
+            return nullptr;
+        }
+
+        auto originalBitmap = decodedFrame.createBitmap();
+        auto scaledBitmap = std::make_shared<Gdiplus::Bitmap>(static_cast<INT>(m_width), static_cast<INT>(m_height), PixelFormat32bppARGB);
+        Gdiplus::Status status = Gdiplus::Ok;
+        {
+            Gdiplus::Graphics frameGraphics{ scaledBitmap.get() };
+            const Gdiplus::Rect destination{ 0, 0, static_cast<INT>(m_width), static_cast<INT>(m_height) };
+            status = frameGraphics.DrawImage(originalBitmap.get(), destination,
+                0, 0, static_cast<INT>(originalBitmap->GetWidth()), static_cast<INT>(originalBitmap->GetHeight()),
+                Gdiplus::UnitPixel, nullptr, abortDrawing, const_cast<CancellationToken*>(&cancellationToken));
+        }
+        m_progress.scaleTime += std::chrono::steady_clock::now() - scaleStart;
+
+        if (status != Gdiplus::Ok)
+        {
+            return nullptr;
+        }
+
+        m_frameCache.insert(source, m_width, m_height, scaledBitmap);
+        return scaledBitmap;
     }
 
-	HRESULT VideoFileCreator::initializeSinkWriter()
+	HRESULT VideoFileCreator::initializeSinkWriter(const std::filesystem::path& output)
 	{
 		winrt::com_ptr<IMFMediaType> mediaTypeOut = nullptr;
 		winrt::com_ptr<IMFMediaType> mediaTypeIn = nullptr;
@@ -88,7 +445,7 @@ namespace SAV
 			return hr;
 		}
 
-		hr = MFCreateSinkWriterFromURL(m_filename.c_str(), NULL, attributes.get(), m_sinkWriter.put());
+		hr = MFCreateSinkWriterFromURL(output.c_str(), NULL, attributes.get(), m_sinkWriter.put());
 		if (!SUCCEEDED(hr))
 		{
 			return hr;
@@ -207,12 +564,12 @@ namespace SAV
         return m_sinkWriter->BeginWriting();
 	}
 
-    HRESULT VideoFileCreator::writeFrame(std::unique_ptr<Gdiplus::Bitmap>& frame, std::uint32_t frameDuration)
+    HRESULT VideoFileCreator::writeFrame(Gdiplus::Bitmap& frame, std::uint32_t frameDuration)
     {
-        Gdiplus::Rect rect{0, 0, static_cast<std::int32_t>(frame->GetWidth()), static_cast<std::int32_t>(frame->GetHeight())};
+        Gdiplus::Rect rect{0, 0, static_cast<std::int32_t>(frame.GetWidth()), static_cast<std::int32_t>(frame.GetHeight())};
         Gdiplus::BitmapData frameData;
 
-        if (frame->LockBits(&rect, Gdiplus::ImageLockModeRead, PixelFormat32bppARGB, &frameData) != Gdiplus::Ok)
+        if (frame.LockBits(&rect, Gdiplus::ImageLockModeRead, PixelFormat32bppARGB, &frameData) != Gdiplus::Ok)
         {
             return E_FAIL;
         }
@@ -226,21 +583,21 @@ namespace SAV
         HRESULT hr = MFCreateMemoryBuffer(bufferSize, buffer.put());
         if (!SUCCEEDED(hr))
         {
-            frame->UnlockBits(&frameData);
+            frame.UnlockBits(&frameData);
             return hr;
         }
 
         hr = buffer->Lock(&pData, NULL, NULL);
         if (!SUCCEEDED(hr))
         {
-            frame->UnlockBits(&frameData);
+            frame.UnlockBits(&frameData);
             return hr;
         }
 
         hr = MFCopyImage(pData, frameData.Stride, (BYTE*)frameData.Scan0, frameData.Stride, frameData.Stride, frameData.Height);
         if (!SUCCEEDED(hr))
         {
-            frame->UnlockBits(&frameData);
+            frame.UnlockBits(&frameData);
             buffer->Unlock();
             return hr;
         }
@@ -248,7 +605,7 @@ namespace SAV
         hr = buffer->SetCurrentLength(bufferSize);
         if (!SUCCEEDED(hr))
         {
-            frame->UnlockBits(&frameData);
+            frame.UnlockBits(&frameData);
             buffer->Unlock();
             return hr;
         }
@@ -257,7 +614,7 @@ namespace SAV
         hr = MFCreateSample(sample.put());
         if (!SUCCEEDED(hr))
         {
-            frame->UnlockBits(&frameData);
+            frame.UnlockBits(&frameData);
             buffer->Unlock();
             return hr;
         }
@@ -265,7 +622,7 @@ namespace SAV
         hr = sample->AddBuffer(buffer.get());
         if (!SUCCEEDED(hr))
         {
-            frame->UnlockBits(&frameData);
+            frame.UnlockBits(&frameData);
             buffer->Unlock();
             return hr;
         }
@@ -274,7 +631,7 @@ namespace SAV
         hr = sample->SetSampleTime(m_frameTimestamp);
         if (!SUCCEEDED(hr))
         {
-            frame->UnlockBits(&frameData);
+            frame.UnlockBits(&frameData);
             buffer->Unlock();
             return hr;
         }
@@ -284,14 +641,14 @@ namespace SAV
         if (!SUCCEEDED(hr))
         {
             m_frameTimestamp = 0;
-            frame->UnlockBits(&frameData);
+            frame.UnlockBits(&frameData);
             buffer->Unlock();
             return hr;
         }
 
         hr = m_sinkWriter->WriteSample(m_videoStreamIndex, sample.get());
 
-        frame->UnlockBits(&frameData);
+        frame.UnlockBits(&frameData);
         buffer->Unlock();
         return hr;
     }
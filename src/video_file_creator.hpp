@@ -11,7 +11,11 @@
 #include <memory>
 #include <ratio>
 
+#include "cancellation_token.hpp"
+#include "export_checkpoint.hpp"
+#include "frame_pipeline.hpp"
 #include "program_data.hpp"
+#include "scaled_frame_cache.hpp"
 #include "time_line.hpp"
 
 namespace SAV
@@ -35,22 +39,75 @@ namespace SAV
 		std::uint32_t bps;
 	};
 
+	struct ExportProgress
+	{
+		using Seconds = std::chrono::duration<double>;
+
+		std::uint64_t framesWritten = 0;
+		std::uint64_t totalFrames = 0;
+		Seconds encodedTime{ 0 };
+		Seconds totalTime{ 0 };
+		double framesPerSecond = 0.0;
+		Seconds eta{ 0 };
+
+		// wall-clock time spent in each stage of the export so far
+		Seconds decodeTime{ 0 };
+		Seconds scaleTime{ 0 };
+		Seconds encodeTime{ 0 };
+	};
+
 	class VideoFileCreator
 	{
+	public:
+		using ProgressCallback = std::function<void(const ExportProgress&)>;
+
+		// reports are delivered from the export thread at most once per this interval
+		inline static constexpr std::chrono::milliseconds progressInterval{ 250 };
+		// the export is encoded in segments of about this length so an interrupted job can be resumed
+		inline static constexpr std::chrono::seconds segmentDuration{ 60 };
+
 	public:
 		VideoFileCreator(std::wstring_view filename, std::uint32_t width, std::uint32_t height, const Bitrate& bitrate) :
 			VideoFileCreator(filename, width, height, bitrate.value())
 		{}
 
-		HRESULT write(const std::vector<AnimationDescription>& data, std::function<void()> progressCallback = nullptr);
+		// Returns HRESULT_FROM_WIN32(ERROR_CANCELLED) when the token is canceled, the partial output file is removed then.
+		// Segments finished before a cancel or a failure are kept, writing the same data with the same settings
+		// again only encodes the remaining segments.
+		// Frames found in the pack are read from it.
+		HRESULT write(const std::vector<AnimationDescription>& data, const CancellationToken& cancellationToken = {},
+			const ProgressCallback& progressCallback = nullptr, FramePackPtr pack = nullptr);
+
+		// Same as above, source images come from frameSource which may be shared with other encoders
+		HRESULT write(const std::vector<AnimationDescription>& data, FrameSource& frameSource, const CancellationToken& cancellationToken,
+			const ProgressCallback& progressCallback);
 
-		void cancel() { m_isCanceled = true; };
 	private:
 		VideoFileCreator(std::wstring_view filename, std::uint32_t width, std::uint32_t height, std::uint32_t bitrate);
 
 	private:
-		HRESULT writeFrame(std::unique_ptr<Gdiplus::Bitmap>& frame, std::uint32_t frameDuration);
-		HRESULT initializeSinkWriter();
+		struct Segment
+		{
+			std::uint32_t index;
+			std::size_t firstRow;
+			std::size_t lastRow;
+			ExportCheckpoint::Segment frames;
+		};
+
+	private:
+		std::uint32_t frameCount(const AnimationDescription& frame) const;
+		std::vector<Segment> planSegments(const std::vector<AnimationDescription>& data) const;
+		std::uint64_t hashJob(const std::vector<AnimationDescription>& data) const;
+
+		HRESULT writeSegment(const std::vector<AnimationDescription>& data, FrameSource& frameSource, const Segment& segment,
+			const std::filesystem::path& output, const CancellationToken& cancellationToken, const ProgressCallback& progressCallback);
+		HRESULT assembleSegments(const std::vector<Segment>& segments, const ExportCheckpoint& checkpoint, const CancellationToken& cancellationToken);
+
+		ScaledFrameCache::Frame getScaledFrame(DecodedFrame& decodedFrame, const CancellationToken& cancellationToken);
+		void discardOutput();
+		HRESULT writeFrame(Gdiplus::Bitmap& frame, std::uint32_t frameDuration);
+		HRESULT initializeSinkWriter(const std::filesystem::path& output);
+		void reportProgress(const ProgressCallback& progressCallback, bool force);
 
 	private:
 		std::uint32_t m_width;
@@ -58,10 +115,15 @@ namespace SAV
 		std::uint32_t m_bitrate;
 		std::uint32_t m_fps;
 		std::wstring m_filename;
+		std::filesystem::path m_currentOutput;
 		float m_frameDuration;
 		std::uint64_t m_frameTimestamp;
 		DWORD m_videoStreamIndex;
 		winrt::com_ptr<IMFSinkWriter> m_sinkWriter;
-		bool m_isCanceled;
+		ScaledFrameCache m_frameCache;
+		ExportProgress m_progress;
+		std::chrono::steady_clock::time_point m_exportStart;
+		std::chrono::steady_clock::time_point m_lastReport;
+		std::uint64_t m_resumedFrames;
 	};
 }
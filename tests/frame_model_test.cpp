@@ -0,0 +1,114 @@
+// FrameModel::move of a selection: where the block lands next to the target, with the selection on
+// one or both sides of it, and that it matches the single frame move the list uses for one row.
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "frame_model.hpp"
+
+namespace
+{
+	using SAV::FrameModel;
+
+	int failures = 0;
+
+	void check(bool condition, const std::string& what)
+	{
+		if (!condition)
+		{
+			std::printf("failed: %s\n", what.c_str());
+			++failures;
+		}
+	}
+
+	// Frames 0..count-1, every handle is the index it starts at
+	FrameModel makeModel(std::size_t count)
+	{
+		FrameModel::Frames frames;
+		for (std::size_t index = 0; index < count; ++index)
+		{
+			frames.push_back({ static_cast<SAV::AnimationData::FrameHandle>(index), std::chrono::milliseconds{ 40 } });
+		}
+		FrameModel model;
+		model.assign(std::move(frames));
+		return model;
+	}
+
+	std::vector<std::size_t> order(const FrameModel& model)
+	{
+		std::vector<std::size_t> handles;
+		for (const auto& frame : model.frames())
+		{
+			handles.push_back(frame.handle);
+		}
+		return handles;
+	}
+
+	std::string toString(const std::vector<std::size_t>& values)
+	{
+		std::string text;
+		for (auto value : values)
+		{
+			text += (text.empty() ? "" : " ") + std::to_string(value);
+		}
+		return text;
+	}
+
+	void checkMove(const std::vector<std::size_t>& indices, std::size_t target, const std::vector<std::size_t>& expected, std::size_t expectedStart)
+	{
+		auto model = makeModel(expected.size());
+		const auto start = model.move(indices, target);
+		const auto what = "move {" + toString(indices) + "} onto " + std::to_string(target);
+		check(order(model) == expected, what + ": got " + toString(order(model)) + ", expected " + toString(expected));
+		check(start == expectedStart, what + ": starts at " + std::to_string(start) + ", expected " + std::to_string(expectedStart));
+	}
+
+	// The block of one frame lands where the single frame move puts it
+	void checkSingle(std::size_t index, std::size_t target, std::size_t count)
+	{
+		auto single = makeModel(count);
+		single.move(index, target);
+		auto block = makeModel(count);
+		block.move(std::vector<std::size_t>{ index }, target);
+		check(order(single) == order(block), "a block of frame " + std::to_string(index) + " onto " + std::to_string(target) + " moves like the single frame");
+	}
+}
+
+int main()
+{
+	// down: behind the target
+	checkMove({ 0 }, 3, { 1, 2, 3, 0, 4, 5, 6 }, 3);
+	checkMove({ 0, 1 }, 3, { 2, 3, 0, 1, 4, 5, 6 }, 2);
+	checkMove({ 0, 2 }, 5, { 1, 3, 4, 5, 0, 2, 6 }, 4);
+	checkMove({ 0 }, 6, { 1, 2, 3, 4, 5, 6, 0 }, 6);
+
+	// up: in front of the target
+	checkMove({ 5 }, 3, { 0, 1, 2, 5, 3, 4, 6 }, 3);
+	checkMove({ 4, 6 }, 1, { 0, 4, 6, 1, 2, 3, 5 }, 1);
+	checkMove({ 6 }, 0, { 6, 0, 1, 2, 3, 4, 5 }, 0);
+
+	// on both sides of the target: behind it, like {0} onto 3 however many frames follow it
+	checkMove({ 0, 5 }, 3, { 1, 2, 3, 0, 5, 4, 6 }, 3);
+	checkMove({ 0, 5, 6 }, 3, { 1, 2, 3, 0, 5, 6, 4 }, 3);
+	checkMove({ 1, 2, 5 }, 3, { 0, 3, 1, 2, 5, 4, 6 }, 2);
+	checkMove({ 2, 4 }, 3, { 0, 1, 3, 2, 4, 5, 6 }, 3);
+
+	// onto a moved frame: nothing changes, neighbours or not
+	checkMove({ 0, 5 }, 5, { 0, 1, 2, 3, 4, 5, 6 }, 0);
+	checkMove({ 2, 3 }, 2, { 0, 1, 2, 3, 4, 5, 6 }, 2);
+
+	for (std::size_t index = 0; index < 7; ++index)
+	{
+		for (std::size_t target = 0; target < 7; ++target)
+		{
+			checkSingle(index, target, 7);
+		}
+	}
+
+	if (failures == 0)
+	{
+		std::printf("all frame model checks passed\n");
+	}
+	return failures == 0 ? 0 : 1;
+}
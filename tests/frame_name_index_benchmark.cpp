@@ -0,0 +1,79 @@
+// Time of a filter box search in FrameNameIndex over a list of 100k frames, the target is below 1 ms
+// for every query. The found frames are checked against a scan of the names.
+// Usage: frame_name_index_benchmark [frames]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cwctype>
+#include <string>
+#include <vector>
+
+#include "frame_name_index.hpp"
+
+int main(int argc, char** argv)
+{
+	const std::size_t frameCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100'000;
+
+	SAV::FrameNameIndex index;
+	std::vector<std::wstring> names;
+	std::vector<SAV::FrameNameIndex::FrameHandle> frames;
+	names.reserve(frameCount);
+	frames.reserve(frameCount);
+	for (std::size_t frame = 0; frame < frameCount; ++frame)
+	{
+		names.push_back(L"Shot" + std::to_wstring(frame / 1000) + L"_frame_" + std::to_wstring(frame) + L".png");
+		frames.push_back(static_cast<SAV::FrameNameIndex::FrameHandle>(frame));
+		index.add(frames.back(), names.back());
+	}
+	// the list shows the frames in another order than they were loaded
+	std::reverse(frames.begin(), frames.end());
+	index.setFrames(frames);
+
+	constexpr int runs = 20;
+	constexpr double target = 1.0;
+	bool isPassed = true;
+	for (const wchar_t* query : { L"f", L"7", L"_1", L"SHOT4", L"frame_4242", L"99.png", L"xyz" })
+	{
+		const std::wstring_view text{ query };
+		std::wstring lower(text);
+		std::transform(lower.begin(), lower.end(), lower.begin(), [](wchar_t symbol) { return static_cast<wchar_t>(std::towlower(symbol)); });
+
+		std::vector<std::size_t> expected;
+		for (std::size_t position = 0; position < frames.size(); ++position)
+		{
+			auto name = names[frames[position]];
+			std::transform(name.begin(), name.end(), name.begin(), [](wchar_t symbol) { return static_cast<wchar_t>(std::towlower(symbol)); });
+			if (name.find(lower) != std::wstring::npos)
+			{
+				expected.push_back(position);
+			}
+		}
+
+		double best = 0.0;
+		std::vector<std::size_t> found;
+		for (int run = 0; run < runs; ++run)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			found = index.find(text);
+			const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			best = run == 0 ? elapsed.count() : (std::min)(best, elapsed.count());
+		}
+
+		if (found != expected)
+		{
+			std::printf("\"%ls\": expected %zu frames, found %zu\n", query, expected.size(), found.size());
+			return 1;
+		}
+
+		std::printf("\"%ls\": %zu of %zu frames, best of %d runs %.3f ms\n", query, found.size(), frames.size(), runs, best);
+		isPassed = isPassed && best < target;
+	}
+
+	if (!isPassed)
+	{
+		std::printf("a search took %.0f ms or more\n", target);
+		return 1;
+	}
+	return 0;
+}
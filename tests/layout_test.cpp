@@ -0,0 +1,102 @@
+// BoxLayout reports only the named boxes whose scaled dimensions differ from the applied ones,
+// and keeps reporting them until they are applied. The main window keeps a gap below its filter box.
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "layout.hpp"
+#include "main_window_layout.hpp"
+
+namespace
+{
+	using namespace SAV::Layout;
+
+	constexpr std::array<ItemSpec, 3> ITEMS = { {
+		{ 0, ItemType::VBox, "" },
+		{ 1, ItemType::Box, "Top", pixels(20) },
+		{ 1, ItemType::Box, "Bottom", rest() },
+	} };
+
+	constexpr auto TABLE = layOut("Root", ItemDimensions{ 0, 0, 100, 100 }, ItemMargin{ 0, 0, 0, 0 }, ITEMS);
+
+	int failures = 0;
+
+	void check(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			std::printf("failed: %s\n", what);
+			++failures;
+		}
+	}
+
+	std::vector<std::string> names(const std::vector<ItemChange>& changes)
+	{
+		std::vector<std::string> result;
+		for (const auto& change : changes)
+		{
+			result.push_back(change.name);
+		}
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+}
+
+int main()
+{
+	BoxLayout layout{ TABLE };
+	check(layout.findChanges().empty(), "a new layout has no changes");
+
+	layout.resize(100, 100);
+	check(layout.findChanges().empty(), "the size it was made for changes nothing");
+
+	// a pixel more scales the root but rounds the children down to their old dimensions
+	layout.resize(100, 101);
+	auto changes = layout.findChanges();
+	check(names(changes) == std::vector<std::string>{ "Root" }, "only the root changes by one pixel");
+	check(changes.size() == 1 && changes.front().dimensions == ItemDimensions{ 0, 0, 100, 101 }, "the root gets the new size");
+
+	check(layout.findChanges().size() == 1, "changes which weren't applied are found again");
+	layout.setApplied(changes);
+	check(layout.findChanges().empty(), "applied changes aren't found again");
+
+	layout.resize(200, 200);
+	changes = layout.findChanges();
+	check(names(changes) == std::vector<std::string>{ "Bottom", "Root", "Top" }, "every named box changes at twice the size");
+	check(getDimensions(layout, "Top") == ItemDimensions{ 0, 0, 200, 40 }, "the top box scales");
+	check(getDimensions(layout, "Bottom") == ItemDimensions{ 0, 40, 200, 160 }, "the bottom box scales");
+
+	// a batch which failed applies nothing, the next one still has every change
+	layout.resize(200, 200);
+	check(layout.findChanges().size() == 3, "a resize to the same size keeps the changes");
+
+	changes.erase(std::remove_if(changes.begin(), changes.end(), [](const ItemChange& change) { return change.name != "Top"; }), changes.end());
+	layout.setApplied(changes);
+	check(names(layout.findChanges()) == std::vector<std::string>{ "Bottom", "Root" }, "only the applied box is left out");
+
+	check(!getDimensions(layout, "Missing"), "an unknown name has no dimensions");
+
+	// the filter box of the main window keeps its gap to the time line at any size
+	namespace MainWindow = SAV::MainWindowLayout;
+	BoxLayout window{ MainWindow::TABLE };
+	for (auto [width, height] : { std::array<std::uint32_t, 2>{ MainWindow::WINDOW_WIDTH, MainWindow::WINDOW_HEIGHT },
+		std::array<std::uint32_t, 2>{ 1920, 1080 }, std::array<std::uint32_t, 2>{ 2960, 1536 } })
+	{
+		window.resize(width, height);
+		const auto filterBox = getDimensions(window, std::string(MainWindow::LAYOUT_FILTER_BOX_NAME));
+		const auto timeLine = getDimensions(window, std::string(MainWindow::LAYOUT_TIME_LINE_NAME));
+		check(filterBox && timeLine && filterBox->y + filterBox->height < timeLine->y, "the filter box ends above the time line");
+	}
+	const auto filterBox = findDimensions(MainWindow::TABLE, MainWindow::LAYOUT_FILTER_BOX_NAME);
+	check(filterBox.y + filterBox.height + MainWindow::FILTER_BOX_GAP == findDimensions(MainWindow::TABLE, MainWindow::LAYOUT_TIME_LINE_NAME).y,
+		"the filter box ends a gap above the time line");
+
+	if (failures == 0)
+	{
+		std::printf("all layout checks passed\n");
+	}
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+// Durations per second of NumberParser::parseDuration on a generated mix of plain, ms, s and f values.
+// Usage: number_parser_benchmark [values]
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "number_parser.hpp"
+
+int main(int argc, char** argv)
+{
+	const std::size_t valueCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+
+	constexpr const char* suffixes[] = { "", "ms", "s", "f" };
+	std::string content;
+	std::vector<std::string_view> values;
+	std::vector<std::size_t> offsets;
+	content.reserve(valueCount * 8);
+	offsets.reserve(valueCount + 1);
+	for (std::size_t value = 0; value < valueCount; ++value)
+	{
+		offsets.push_back(content.size());
+		content += std::to_string(value % 100'000);
+		content += suffixes[value % 4];
+	}
+	offsets.push_back(content.size());
+
+	// the views are taken once the text doesn't move anymore
+	values.reserve(valueCount);
+	for (std::size_t value = 0; value < valueCount; ++value)
+	{
+		values.emplace_back(content.data() + offsets[value], offsets[value + 1] - offsets[value]);
+	}
+
+	constexpr int runs = 5;
+	double best = 0.0;
+	std::uint64_t sum = 0;
+	std::size_t parsed = 0;
+	for (int run = 0; run < runs; ++run)
+	{
+		sum = 0;
+		parsed = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (auto text : values)
+		{
+			if (auto duration = SAV::NumberParser::parseDuration(text); duration)
+			{
+				sum += *duration;
+				++parsed;
+			}
+		}
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		best = run == 0 ? elapsed.count() : (std::min)(best, elapsed.count());
+	}
+
+	if (parsed != valueCount)
+	{
+		std::printf("expected %zu durations, parsed %zu\n", valueCount, parsed);
+		return 1;
+	}
+
+	// the sum keeps the loop from being optimized out
+	std::printf("%zu durations (sum %llu): best of %d runs %.3f s, %.1f ns per value, %.0f values/s\n", parsed,
+		static_cast<unsigned long long>(sum), runs, best, best * 1e9 / parsed, best > 0.0 ? parsed / best : 0.0);
+	return 0;
+}
@@ -0,0 +1,203 @@
+// NumberParser on the edges of its ranges, malformed text and every duration suffix, in both
+// character types. Durations are also read through TextProjectParser rows.
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "number_parser.hpp"
+#include "text_project_parser.hpp"
+
+namespace
+{
+	using namespace std::string_view_literals;
+	namespace NumberParser = SAV::NumberParser;
+
+	constexpr std::uint64_t maxUint32 = (std::numeric_limits<std::uint32_t>::max)();
+	constexpr std::uint64_t maxUint64 = (std::numeric_limits<std::uint64_t>::max)();
+
+	// the parser is meant for compile time too
+	static_assert(NumberParser::parseNumber("4294967295"sv, maxUint32) == maxUint32);
+	static_assert(!NumberParser::parseNumber("4294967296"sv, maxUint32));
+	static_assert(NumberParser::parseDuration(L"2s"sv) == 2000u);
+
+	int failures = 0;
+
+	template <typename T>
+	void check(const std::optional<T>& actual, const std::optional<T>& expected, const char* text, const char* what)
+	{
+		if (actual != expected)
+		{
+			std::printf("failed: %s \"%s\": ", what, text);
+			actual ? std::printf("got %llu, ", static_cast<unsigned long long>(*actual)) : std::printf("got nothing, ");
+			expected ? std::printf("expected %llu\n", static_cast<unsigned long long>(*expected)) : std::printf("expected nothing\n");
+			++failures;
+		}
+	}
+
+	// The same text as both character types
+	void checkNumber(const char* text, std::uint64_t maxValue, std::optional<std::uint64_t> expected)
+	{
+		const std::string_view narrow{ text };
+		const std::wstring wide(narrow.begin(), narrow.end());
+		check(NumberParser::parseNumber(narrow, maxValue), expected, text, "parseNumber");
+		check(NumberParser::parseNumber(std::wstring_view{ wide }, maxValue), expected, text, "parseNumber wide");
+	}
+
+	void checkDuration(const char* text, std::optional<std::uint32_t> expected, std::uint32_t fps = NumberParser::projectFps)
+	{
+		const std::string_view narrow{ text };
+		const std::wstring wide(narrow.begin(), narrow.end());
+		check(NumberParser::parseDuration(narrow, fps), expected, text, "parseDuration");
+		check(NumberParser::parseDuration(std::wstring_view{ wide }, fps), expected, text, "parseDuration wide");
+	}
+
+	void checkRow(const char* text, std::uint32_t expected)
+	{
+		auto rows = SAV::TextProjectParser::parse(text);
+		check(rows.size() == 1 ? std::optional{ rows.front().durationMs } : std::nullopt, std::optional{ expected }, text, "plain row");
+	}
+
+	void testNumbers()
+	{
+		checkNumber("0", maxUint32, 0);
+		checkNumber("7", maxUint32, 7);
+		checkNumber("000123", maxUint32, 123);
+		checkNumber("4294967295", maxUint32, maxUint32);
+		checkNumber("4294967296", maxUint32, std::nullopt);
+		checkNumber("00004294967295", maxUint32, maxUint32);
+		checkNumber("42949672950", maxUint32, std::nullopt);
+		checkNumber("18446744073709551615", maxUint64, maxUint64);
+		checkNumber("18446744073709551616", maxUint64, std::nullopt);
+		checkNumber("99999999999999999999", maxUint64, std::nullopt);
+		checkNumber("255", 255, 255);
+		checkNumber("256", 255, std::nullopt);
+		checkNumber("0", 0, 0);
+		checkNumber("1", 0, std::nullopt);
+
+		// empty, signs, whitespace and trailing garbage
+		checkNumber("", maxUint32, std::nullopt);
+		checkNumber("+1", maxUint32, std::nullopt);
+		checkNumber("-1", maxUint32, std::nullopt);
+		checkNumber("-0", maxUint32, std::nullopt);
+		checkNumber(" 1", maxUint32, std::nullopt);
+		checkNumber("1 ", maxUint32, std::nullopt);
+		checkNumber("\t1", maxUint32, std::nullopt);
+		checkNumber("1\n", maxUint32, std::nullopt);
+		checkNumber("1 2", maxUint32, std::nullopt);
+		checkNumber("12a", maxUint32, std::nullopt);
+		checkNumber("a12", maxUint32, std::nullopt);
+		checkNumber("1.5", maxUint32, std::nullopt);
+		checkNumber("1e3", maxUint32, std::nullopt);
+		checkNumber("0x10", maxUint32, std::nullopt);
+		checkNumber("1,000", maxUint32, std::nullopt);
+
+		// every single character next to the digits
+		for (int symbol = 1; symbol < 128; ++symbol)
+		{
+			const char text[] = { static_cast<char>(symbol), '\0' };
+			checkNumber(text, maxUint32, symbol >= '0' && symbol <= '9' ? std::optional<std::uint64_t>{ static_cast<std::uint64_t>(symbol - '0') } : std::nullopt);
+		}
+
+		// every value around each power of ten up to the limit
+		for (std::uint64_t power = 1; power <= maxUint32; power *= 10)
+		{
+			for (auto value : { power - 1, power, power + 1 })
+			{
+				const auto text = std::to_string(value);
+				checkNumber(text.c_str(), maxUint32, value <= maxUint32 ? std::optional{ value } : std::nullopt);
+			}
+		}
+	}
+
+	void testDurations()
+	{
+		// plain milliseconds
+		checkDuration("0", 0);
+		checkDuration("41", 41);
+		checkDuration("4294967295", static_cast<std::uint32_t>(maxUint32));
+		checkDuration("4294967296", std::nullopt);
+
+		// ms
+		checkDuration("0ms", 0);
+		checkDuration("41ms", 41);
+		checkDuration("4294967295ms", static_cast<std::uint32_t>(maxUint32));
+		checkDuration("4294967296ms", std::nullopt);
+		checkDuration("ms", std::nullopt);
+		checkDuration("41 ms", std::nullopt);
+		checkDuration("41MS", std::nullopt);
+		checkDuration("41msms", std::nullopt);
+
+		// s
+		checkDuration("0s", 0);
+		checkDuration("2s", 2000);
+		checkDuration("4294967s", 4294967000);
+		checkDuration("4294968s", std::nullopt);
+		checkDuration("s", std::nullopt);
+		checkDuration("1.5s", std::nullopt);
+		checkDuration("2S", std::nullopt);
+
+		// f, rounded to the closest millisecond
+		checkDuration("0f", 0);
+		checkDuration("1f", 33);
+		checkDuration("2f", 67);
+		checkDuration("3f", 100);
+		checkDuration("30f", 1000);
+		checkDuration("1f", 42, 24);
+		checkDuration("1f", 17, 60);
+		checkDuration("1f", 1000, 1);
+		checkDuration("1f", std::nullopt, 0);
+		checkDuration("128849018f", 4294967267);
+		checkDuration("128849019f", std::nullopt);
+		checkDuration("4294967295f", 4294967295, 1000);
+		checkDuration("4294967296f", std::nullopt, 1000);
+		checkDuration("f", std::nullopt);
+		checkDuration("1F", std::nullopt);
+
+		// empty, signs, whitespace and trailing garbage
+		checkDuration("", std::nullopt);
+		checkDuration("-41", std::nullopt);
+		checkDuration("+41ms", std::nullopt);
+		checkDuration(" 41", std::nullopt);
+		checkDuration("41 ", std::nullopt);
+		checkDuration("41x", std::nullopt);
+		checkDuration("41m", std::nullopt);
+		checkDuration("41sm", std::nullopt);
+		checkDuration("41fs", std::nullopt);
+	}
+
+	// Plain rows read the duration like the std::from_chars of the baseline loader: the leading digits,
+	// 0 without any. Only a whole suffixed duration reads differently.
+	void testProjectRows()
+	{
+		checkRow("a.png;41", 41);
+		checkRow("a.png;41 ", 41);
+		checkRow("a.png; 41", 0);
+		checkRow("a.png;+41", 0);
+		checkRow("a.png;41abc", 41);
+		checkRow("a.png;41 ms", 41);
+		checkRow("a.png;41ms", 41);
+		checkRow("a.png;2s", 2000);
+		checkRow("a.png;3f", 100);
+		checkRow("a.png;abc", 0);
+		checkRow("a.png;", 0);
+		checkRow("a.png;-41", 0);
+		checkRow("a.png;4294967295", static_cast<std::uint32_t>(maxUint32));
+		checkRow("a.png;4294967296", 0);
+	}
+}
+
+int main()
+{
+	testNumbers();
+	testDurations();
+	testProjectRows();
+
+	if (failures == 0)
+	{
+		std::printf("all number parser checks passed\n");
+	}
+	return failures == 0 ? 0 : 1;
+}
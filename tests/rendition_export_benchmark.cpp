@@ -0,0 +1,166 @@
+// Wall time and frames per second of RenditionExporter writing every rendition in one pass, against the
+// same renditions written one after another. Windows only, it needs Media Foundation and GDI+.
+// Usage: rendition_export_benchmark <project> <output folder> [<width>x<height>@<kbps> ...]
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <Windows.h>
+#include <gdiplus.h>
+
+#include "number_parser.hpp"
+#include "program_data.hpp"
+#include "rendition_exporter.hpp"
+
+#pragma comment (lib,"Gdiplus.lib")
+
+namespace
+{
+	struct Run
+	{
+		HRESULT result = S_OK;
+		double seconds = 0.0;
+		std::uint64_t frames = 0;
+	};
+
+	std::optional<SAV::Rendition> parseRendition(std::wstring_view text, const std::filesystem::path& folder, std::wstring_view prefix)
+	{
+		auto sizeDelim = text.find(L'x');
+		auto bitrateDelim = text.find(L'@');
+		if (sizeDelim == std::wstring_view::npos || bitrateDelim == std::wstring_view::npos || bitrateDelim < sizeDelim)
+		{
+			return std::nullopt;
+		}
+
+		constexpr std::uint64_t maxValue = (std::numeric_limits<std::uint32_t>::max)();
+		auto width = SAV::NumberParser::parseNumber(text.substr(0, sizeDelim), maxValue);
+		auto height = SAV::NumberParser::parseNumber(text.substr(sizeDelim + 1, bitrateDelim - sizeDelim - 1), maxValue);
+		auto bitrate = SAV::NumberParser::parseNumber(text.substr(bitrateDelim + 1), maxValue);
+		if (!width || !height || !bitrate)
+		{
+			return std::nullopt;
+		}
+
+		auto filename = folder / (std::wstring{ prefix } + L"_" + std::to_wstring(*height) + L"p.mp4");
+		return SAV::Rendition{ filename.wstring(), static_cast<std::uint32_t>(*width), static_cast<std::uint32_t>(*height),
+			SAV::Bitrate{ static_cast<std::uint32_t>(*bitrate), SAV::Bitrate::KBPS() } };
+	}
+
+	// A checkpoint left by an earlier run would let the exporter skip the segments it already encoded
+	void removeOutputs(const std::vector<SAV::Rendition>& renditions)
+	{
+		for (const auto& rendition : renditions)
+		{
+			std::error_code ec;
+			std::filesystem::remove(rendition.filename, ec);
+			std::filesystem::remove(rendition.filename + L".checkpoint", ec);
+			std::filesystem::remove_all(rendition.filename + L".parts", ec);
+		}
+	}
+
+	Run write(const std::vector<SAV::Rendition>& renditions, const SAV::AnimationData::Animations& animations, const SAV::FramePackPtr& pack)
+	{
+		removeOutputs(renditions);
+
+		Run run;
+		SAV::RenditionExporter exporter{ renditions, pack };
+		const auto start = std::chrono::steady_clock::now();
+		run.result = exporter.write(animations, {}, [&run](const SAV::ExportProgress& progress) { run.frames = progress.framesWritten; });
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		run.seconds = elapsed.count();
+		return run;
+	}
+
+	void print(const char* what, const Run& run)
+	{
+		std::printf("%s: %llu frames in %.2f s, %.1f frames/s\n", what, static_cast<unsigned long long>(run.frames), run.seconds,
+			run.seconds > 0.0 ? run.frames / run.seconds : 0.0);
+	}
+}
+
+int wmain(int argc, wchar_t** argv)
+{
+	if (argc < 3)
+	{
+		std::printf("usage: rendition_export_benchmark <project> <output folder> [<width>x<height>@<kbps> ...]\n");
+		return 1;
+	}
+
+	std::vector<std::wstring_view> sizes;
+	for (int arg = 3; arg < argc; ++arg)
+	{
+		sizes.push_back(argv[arg]);
+	}
+	if (sizes.empty())
+	{
+		sizes = { L"3840x2160@35000", L"1920x1080@8000", L"1280x720@4000" };
+	}
+
+	const std::filesystem::path folder{ argv[2] };
+	std::vector<SAV::Rendition> together;
+	std::vector<SAV::Rendition> separate;
+	for (auto size : sizes)
+	{
+		auto first = parseRendition(size, folder, L"together");
+		auto second = parseRendition(size, folder, L"separate");
+		if (!first || !second)
+		{
+			std::printf("can't read the size \"%ls\", expected <width>x<height>@<kbps>\n", std::wstring{ size }.c_str());
+			return 1;
+		}
+		together.push_back(std::move(*first));
+		separate.push_back(std::move(*second));
+	}
+
+	Gdiplus::GdiplusStartupInput gdiplusStartupInput;
+	ULONG_PTR gdiplusToken;
+	Gdiplus::GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, NULL);
+
+	int exitCode = 0;
+	try
+	{
+		SAV::AnimationData animationData;
+		auto frames = animationData.loadFromFile(argv[1]);
+		const auto animations = animationData.toAnimations(frames);
+		const auto pack = animationData.getFramePack();
+
+		const auto onePass = write(together, animations, pack);
+		Run oneByOne;
+		for (const auto& rendition : separate)
+		{
+			const auto run = write({ rendition }, animations, pack);
+			oneByOne.result = FAILED(oneByOne.result) ? oneByOne.result : run.result;
+			oneByOne.seconds += run.seconds;
+			oneByOne.frames += run.frames;
+		}
+
+		if (FAILED(onePass.result) || FAILED(oneByOne.result))
+		{
+			std::printf("the export failed: 0x%08lx, 0x%08lx\n", static_cast<unsigned long>(onePass.result), static_cast<unsigned long>(oneByOne.result));
+			exitCode = 1;
+		}
+		else
+		{
+			std::printf("%zu renditions of %zu frames%s\n", together.size(), frames.size(), pack ? ", read from the frame pack" : "");
+			print("one pass", onePass);
+			print("one by one", oneByOne);
+			std::printf("speedup %.2fx\n", onePass.seconds > 0.0 ? oneByOne.seconds / onePass.seconds : 0.0);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::printf("%s\n", e.what());
+		exitCode = 1;
+	}
+
+	Gdiplus::GdiplusShutdown(gdiplusToken);
+	return exitCode;
+}
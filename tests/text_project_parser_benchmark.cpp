@@ -0,0 +1,47 @@
+// Rows per second of TextProjectParser::parse on a generated project of 1M rows.
+// Usage: text_project_parser_benchmark [rows]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "text_project_parser.hpp"
+
+int main(int argc, char** argv)
+{
+	const std::size_t rowCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+
+	std::string content;
+	content.reserve(rowCount * 48);
+	for (std::size_t row = 0; row < rowCount; ++row)
+	{
+		content += "C:\\animations\\shot_010\\frame_";
+		content += std::to_string(row % 100'000);
+		content += ".png;";
+		content += std::to_string(40 + row % 3);
+		content += "\r\n";
+	}
+
+	constexpr int runs = 5;
+	double best = 0.0;
+	std::size_t parsed = 0;
+	for (int run = 0; run < runs; ++run)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		auto rows = SAV::TextProjectParser::parse(content);
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		parsed = rows.size();
+		best = run == 0 ? elapsed.count() : (std::min)(best, elapsed.count());
+	}
+
+	if (parsed != rowCount)
+	{
+		std::printf("expected %zu rows, parsed %zu\n", rowCount, parsed);
+		return 1;
+	}
+
+	std::printf("%zu rows, %.1f MiB: best of %d runs %.3f s, %.0f rows/s\n", parsed, content.size() / (1024.0 * 1024.0), runs, best,
+		best > 0.0 ? parsed / best : 0.0);
+	return 0;
+}